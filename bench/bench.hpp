@@ -0,0 +1,460 @@
+/*
+ * pixelLib
+ * Copyright (c) 2025 Interlaced Pixel
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#ifndef PIXELLIB_BENCH_HPP
+#define PIXELLIB_BENCH_HPP
+
+// Minimal benchmark harness behind `make bench`.
+//
+// A benchmark is a function that runs its workload state.iterations() times:
+//
+//   PIXELLIB_BENCHMARK("json/parse/document")
+//   {
+//     const std::string text = make_document(); // setup
+//     state.reset_timer();                      // exclude it from the timing
+//     for (uint64_t i = 0; i < state.iterations(); ++i)
+//       pixellib::bench::do_not_optimize(parse(text));
+//     state.set_bytes_processed(text.size() * state.iterations());
+//   }
+//
+// The runner grows the iteration count until one run takes at least
+// --min-time, then times --repetitions runs at that count and reports the
+// median time per iteration. Results are printed as a table and written as
+// JSON (--out); --baseline compares against a previous results file and exits
+// with status 1 when a benchmark got slower by more than --threshold.
+
+// json.hpp includes doctest; the benchmark binary has no test runner.
+#ifndef DOCTEST_CONFIG_DISABLE
+#define DOCTEST_CONFIG_DISABLE
+#endif
+
+#include "../include/filesystem.hpp"
+#include "../include/json.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace pixellib::bench
+{
+
+class State
+{
+public:
+  using clock = std::chrono::steady_clock;
+
+  explicit State(const uint64_t iterations) : iterations_(iterations), start_(clock::now()) {}
+
+  uint64_t iterations() const
+  {
+    return iterations_;
+  }
+
+  // Restarts the clock, so setup done so far is not measured.
+  void reset_timer()
+  {
+    start_ = clock::now();
+    stopped_ = false;
+  }
+
+  // Stops the clock early, so teardown after this call is not measured.
+  void stop_timer()
+  {
+    if (!stopped_)
+    {
+      stop_ = clock::now();
+      stopped_ = true;
+    }
+  }
+
+  // Totals for the whole run (all iterations), reported as rates.
+  void set_bytes_processed(const uint64_t bytes)
+  {
+    bytes_ = bytes;
+  }
+
+  void set_items_processed(const uint64_t items)
+  {
+    items_ = items;
+  }
+
+  std::chrono::nanoseconds elapsed() const
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>((stopped_ ? stop_ : clock::now()) - start_);
+  }
+
+  uint64_t bytes_processed() const
+  {
+    return bytes_;
+  }
+
+  uint64_t items_processed() const
+  {
+    return items_;
+  }
+
+private:
+  uint64_t iterations_;
+  clock::time_point start_;
+  clock::time_point stop_;
+  bool stopped_ = false;
+  uint64_t bytes_ = 0;
+  uint64_t items_ = 0;
+};
+
+// Keeps the compiler from discarding a computed value or the work behind it.
+template <typename T>
+inline void do_not_optimize(const T &value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "m"(value) : "memory");
+#else
+  const volatile char *bytes = reinterpret_cast<const volatile char *>(&value);
+  (void)*bytes;
+#endif
+}
+
+struct Benchmark
+{
+  std::string name;
+  std::function<void(State &)> run;
+};
+
+inline std::vector<Benchmark> &registry()
+{
+  static std::vector<Benchmark> benchmarks;
+  return benchmarks;
+}
+
+inline bool register_benchmark(std::string name, std::function<void(State &)> run)
+{
+  registry().push_back({std::move(name), std::move(run)});
+  return true;
+}
+
+#define PIXELLIB_BENCH_CONCAT_INNER(a, b) a##b
+#define PIXELLIB_BENCH_CONCAT(a, b) PIXELLIB_BENCH_CONCAT_INNER(a, b)
+#define PIXELLIB_BENCHMARK(name)                                                                                                           \
+  static void PIXELLIB_BENCH_CONCAT(pixellib_benchmark_, __LINE__)(::pixellib::bench::State & state);                                      \
+  static const bool PIXELLIB_BENCH_CONCAT(pixellib_benchmark_registered_, __LINE__) =                                                      \
+      ::pixellib::bench::register_benchmark(name, &PIXELLIB_BENCH_CONCAT(pixellib_benchmark_, __LINE__));                                  \
+  static void PIXELLIB_BENCH_CONCAT(pixellib_benchmark_, __LINE__)(::pixellib::bench::State & state)
+
+struct Result
+{
+  std::string name;
+  uint64_t iterations = 0;
+  size_t repetitions = 0;
+  double ns_per_op = 0.0; // median over repetitions
+  double min_ns_per_op = 0.0;
+  double max_ns_per_op = 0.0;
+  double bytes_per_second = 0.0;
+  double items_per_second = 0.0;
+};
+
+struct RunOptions
+{
+  std::string filter; // substring of the benchmark name
+  std::chrono::milliseconds min_time{100};
+  size_t repetitions = 5;
+  std::string out;
+  std::string baseline;
+  double threshold = 0.10; // allowed slowdown against the baseline
+  bool list = false;
+};
+
+namespace detail
+{
+
+inline Result measure(const Benchmark &benchmark, const RunOptions &options)
+{
+  const auto min_ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(options.min_time).count());
+  uint64_t iterations = 1;
+  for (;;)
+  {
+    State state(iterations);
+    benchmark.run(state);
+    const auto ns = static_cast<double>(std::max<int64_t>(state.elapsed().count(), 1));
+    if (ns >= min_ns || iterations >= (uint64_t{1} << 40))
+    {
+      break;
+    }
+    // Aim slightly past min_time; grow at least 1.5x and at most 10x per step.
+    const double scale = std::clamp(min_ns * 1.2 / ns, 1.5, 10.0);
+    iterations = static_cast<uint64_t>(static_cast<double>(iterations) * scale) + 1;
+  }
+
+  Result result;
+  result.name = benchmark.name;
+  result.iterations = iterations;
+  result.repetitions = std::max<size_t>(options.repetitions, 1);
+  std::vector<std::pair<double, State>> runs;
+  for (size_t i = 0; i < result.repetitions; ++i)
+  {
+    State state(iterations);
+    benchmark.run(state);
+    runs.emplace_back(static_cast<double>(state.elapsed().count()) / static_cast<double>(iterations), state);
+  }
+  std::sort(runs.begin(), runs.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+  const auto &[median_ns, median_state] = runs[runs.size() / 2];
+  result.ns_per_op = median_ns;
+  result.min_ns_per_op = runs.front().first;
+  result.max_ns_per_op = runs.back().first;
+  const double seconds = std::max(median_ns * static_cast<double>(iterations), 1.0) / 1e9;
+  result.bytes_per_second = static_cast<double>(median_state.bytes_processed()) / seconds;
+  result.items_per_second = static_cast<double>(median_state.items_processed()) / seconds;
+  return result;
+}
+
+inline std::string to_json(const std::vector<Result> &results, const RunOptions &options)
+{
+  std::string out;
+  core::json::JsonWriter writer(out, core::json::StringifyOptions{true, 2, false});
+  char date[32] = "";
+  const std::time_t now = std::time(nullptr);
+  if (const std::tm *utc = std::gmtime(&now))
+  {
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", utc);
+  }
+  writer.begin_object();
+  writer.key("context").begin_object();
+  writer.key("date").value(std::string_view(date));
+#if defined(__clang__)
+  writer.key("compiler").value(std::string_view("clang " __clang_version__));
+#elif defined(__GNUC__)
+  writer.key("compiler").value(std::string_view("gcc " __VERSION__));
+#elif defined(_MSC_VER)
+  writer.key("compiler").value(std::string_view("msvc"));
+#endif
+#ifdef NDEBUG
+  writer.key("assertions").value(false);
+#else
+  writer.key("assertions").value(true);
+#endif
+  writer.key("min_time_ms").value(static_cast<int64_t>(options.min_time.count()));
+  writer.key("repetitions").value(static_cast<uint64_t>(options.repetitions));
+  writer.end_object();
+  writer.key("benchmarks").begin_array();
+  for (const auto &result : results)
+  {
+    writer.begin_object();
+    writer.key("name").value(std::string_view(result.name));
+    writer.key("iterations").value(result.iterations);
+    writer.key("repetitions").value(static_cast<uint64_t>(result.repetitions));
+    writer.key("ns_per_op").value(result.ns_per_op);
+    writer.key("min_ns_per_op").value(result.min_ns_per_op);
+    writer.key("max_ns_per_op").value(result.max_ns_per_op);
+    if (result.bytes_per_second > 0.0)
+    {
+      writer.key("bytes_per_second").value(result.bytes_per_second);
+    }
+    if (result.items_per_second > 0.0)
+    {
+      writer.key("items_per_second").value(result.items_per_second);
+    }
+    writer.end_object();
+  }
+  writer.end_array();
+  writer.end_object();
+  out += '\n';
+  return out;
+}
+
+// Reads name -> ns_per_op from a results file written by to_json.
+inline std::optional<std::unordered_map<std::string, double>> load_baseline(const std::string &path)
+{
+  core::filesystem::MappedFile file(path);
+  core::json::JSON doc;
+  if (!file.is_open() || !core::json::JSON::parse(file.view(), doc) || !doc.is_object())
+  {
+    return std::nullopt;
+  }
+  const core::json::JSON *benchmarks = doc.find("benchmarks");
+  if (!benchmarks || !benchmarks->is_array())
+  {
+    return std::nullopt;
+  }
+  std::unordered_map<std::string, double> baseline;
+  for (const auto &entry : benchmarks->as_array())
+  {
+    const core::json::JSON *name = entry.is_object() ? entry.find("name") : nullptr;
+    const core::json::JSON *ns = entry.is_object() ? entry.find("ns_per_op") : nullptr;
+    if (name && name->is_string() && ns && ns->is_number())
+    {
+      baseline[std::string(name->as_string_view())] = ns->as_number().to_double();
+    }
+  }
+  return baseline;
+}
+
+inline std::string format_rate(const Result &result)
+{
+  char text[48] = "";
+  if (result.bytes_per_second > 0.0)
+  {
+    std::snprintf(text, sizeof(text), "%10.1f MiB/s", result.bytes_per_second / (1024.0 * 1024.0));
+  }
+  else if (result.items_per_second > 0.0)
+  {
+    std::snprintf(text, sizeof(text), "%10.3f M/s", result.items_per_second / 1e6);
+  }
+  return text;
+}
+
+inline bool parse_arguments(const int argc, char **argv, RunOptions &options)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string_view arg(argv[i]);
+    const size_t eq = arg.find('=');
+    const std::string_view name = arg.substr(0, eq);
+    const std::string value(eq == std::string_view::npos ? std::string_view() : arg.substr(eq + 1));
+    try
+    {
+      if (name == "--filter")
+        options.filter = value;
+      else if (name == "--min-time")
+        options.min_time = std::chrono::milliseconds(std::stoll(value));
+      else if (name == "--repetitions")
+        options.repetitions = static_cast<size_t>(std::stoul(value));
+      else if (name == "--out")
+        options.out = value;
+      else if (name == "--baseline")
+        options.baseline = value;
+      else if (name == "--threshold")
+        options.threshold = std::stod(value);
+      else if (name == "--list")
+        options.list = true;
+      else
+      {
+        std::cerr << "unknown option " << arg << "\n"
+                  << "usage: " << argv[0]
+                  << " [--filter=text] [--min-time=ms] [--repetitions=n] [--out=results.json] [--baseline=results.json] [--threshold=0.10] [--list]\n";
+        return false;
+      }
+    }
+    catch (const std::exception &)
+    {
+      std::cerr << "invalid value for " << name << ": " << value << "\n";
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace detail
+
+// Runs the registered benchmarks; returns the process exit status
+// (0 ok, 1 regression against the baseline, 2 usage or I/O error).
+inline int run(const int argc, char **argv)
+{
+  RunOptions options;
+  if (!detail::parse_arguments(argc, argv, options))
+  {
+    return 2;
+  }
+
+  std::vector<const Benchmark *> selected;
+  for (const auto &benchmark : registry())
+  {
+    if (benchmark.name.find(options.filter) != std::string::npos)
+    {
+      selected.push_back(&benchmark);
+    }
+  }
+  std::sort(selected.begin(), selected.end(), [](const Benchmark *a, const Benchmark *b) { return a->name < b->name; });
+  if (options.list)
+  {
+    for (const auto *benchmark : selected)
+    {
+      std::cout << benchmark->name << "\n";
+    }
+    return 0;
+  }
+
+  std::optional<std::unordered_map<std::string, double>> baseline;
+  if (!options.baseline.empty())
+  {
+    baseline = detail::load_baseline(options.baseline);
+    if (!baseline)
+    {
+      std::cerr << "cannot read baseline " << options.baseline << "\n";
+      return 2;
+    }
+  }
+
+  std::vector<Result> results;
+  size_t regressions = 0;
+  char line[256];
+  for (const auto *benchmark : selected)
+  {
+    const Result result = detail::measure(*benchmark, options);
+    std::snprintf(line, sizeof(line), "%-44s %12llu %14.1f ns/op %s", result.name.c_str(), static_cast<unsigned long long>(result.iterations),
+                  result.ns_per_op, detail::format_rate(result).c_str());
+    std::cout << line;
+    if (baseline)
+    {
+      if (const auto it = baseline->find(result.name); it != baseline->end() && it->second > 0.0)
+      {
+        const double change = result.ns_per_op / it->second - 1.0;
+        const bool regressed = change > options.threshold;
+        regressions += regressed ? 1 : 0;
+        std::snprintf(line, sizeof(line), "  %+7.1f%% vs baseline%s", change * 100.0, regressed ? "  REGRESSION" : "");
+        std::cout << line;
+      }
+      else
+      {
+        std::cout << "  (new)";
+      }
+    }
+    std::cout << std::endl;
+    results.push_back(result);
+  }
+
+  if (!options.out.empty() && !core::filesystem::FileSystem::write_file_atomic(options.out, detail::to_json(results, options)))
+  {
+    std::cerr << "cannot write " << options.out << "\n";
+    return 2;
+  }
+  if (regressions > 0)
+  {
+    std::cout << regressions << " benchmark(s) slower than the baseline by more than " << options.threshold * 100.0 << "%\n";
+    return 1;
+  }
+  return 0;
+}
+
+} // namespace pixellib::bench
+
+#endif
@@ -0,0 +1,227 @@
+#include "bench.hpp"
+
+#include "../include/filesystem.hpp"
+
+#include <string>
+
+#ifdef _WIN32
+#include <process.h>
+#define PIXELLIB_BENCH_GETPID _getpid
+#else
+#include <unistd.h>
+#define PIXELLIB_BENCH_GETPID getpid
+#endif
+
+using pixellib::bench::do_not_optimize;
+using pixellib::core::filesystem::DirectoryEntry;
+using pixellib::core::filesystem::FileSystem;
+using pixellib::core::filesystem::MappedFile;
+using pixellib::core::filesystem::WalkOptions;
+
+namespace
+{
+
+constexpr size_t file_bytes = 1024 * 1024;
+
+// Scratch directory for one benchmark run, removed with its contents when it
+// goes out of scope.
+class ScratchDirectory
+{
+public:
+  ScratchDirectory() : path_(FileSystem::temp_directory_path() + "/pixellib_bench_" + std::to_string(PIXELLIB_BENCH_GETPID()))
+  {
+    FileSystem::create_directories(path_);
+  }
+
+  ~ScratchDirectory()
+  {
+    remove_tree(path_);
+  }
+
+  ScratchDirectory(const ScratchDirectory &) = delete;
+  ScratchDirectory &operator=(const ScratchDirectory &) = delete;
+
+  std::string file(const std::string &name) const
+  {
+    return path_ + "/" + name;
+  }
+
+  const std::string &path() const
+  {
+    return path_;
+  }
+
+private:
+  static void remove_tree(const std::string &path)
+  {
+    for (const auto &name : FileSystem::directory_iterator(path))
+    {
+      const std::string child = path + "/" + name;
+      if (FileSystem::is_directory(child))
+      {
+        remove_tree(child);
+      }
+      else
+      {
+        FileSystem::remove(child);
+      }
+    }
+    FileSystem::remove(path);
+  }
+
+  std::string path_;
+};
+
+const std::string &payload()
+{
+  static const std::string data = []
+  {
+    std::string bytes(file_bytes, '\0');
+    for (size_t i = 0; i < bytes.size(); ++i)
+    {
+      bytes[i] = static_cast<char>('a' + (i * 7) % 26);
+    }
+    return bytes;
+  }();
+  return data;
+}
+
+} // namespace
+
+PIXELLIB_BENCHMARK("filesystem/write_file/1MiB")
+{
+  ScratchDirectory scratch;
+  const std::string path = scratch.file("out.bin");
+  state.reset_timer();
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    FileSystem::write_file(path, payload());
+  }
+  state.set_bytes_processed(file_bytes * state.iterations());
+  state.stop_timer();
+}
+
+PIXELLIB_BENCHMARK("filesystem/write_file_atomic/1MiB")
+{
+  ScratchDirectory scratch;
+  const std::string path = scratch.file("out.bin");
+  state.reset_timer();
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    FileSystem::write_file_atomic(path, payload());
+  }
+  state.set_bytes_processed(file_bytes * state.iterations());
+  state.stop_timer();
+}
+
+PIXELLIB_BENCHMARK("filesystem/read_file/1MiB")
+{
+  ScratchDirectory scratch;
+  const std::string path = scratch.file("in.bin");
+  FileSystem::write_file(path, payload());
+  state.reset_timer();
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    do_not_optimize(FileSystem::read_file(path));
+  }
+  state.set_bytes_processed(file_bytes * state.iterations());
+  state.stop_timer();
+}
+
+// Maps the file and touches every page, the minimum a parser would do.
+PIXELLIB_BENCHMARK("filesystem/mapped_file/1MiB")
+{
+  ScratchDirectory scratch;
+  const std::string path = scratch.file("in.bin");
+  FileSystem::write_file(path, payload());
+  state.reset_timer();
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    MappedFile mapped(path);
+    unsigned sum = 0;
+    const std::string_view view = mapped.view();
+    for (size_t offset = 0; offset < view.size(); offset += 4096)
+    {
+      sum += static_cast<unsigned char>(view[offset]);
+    }
+    do_not_optimize(sum);
+  }
+  state.set_bytes_processed(file_bytes * state.iterations());
+  state.stop_timer();
+}
+
+PIXELLIB_BENCHMARK("filesystem/copy_file/8MiB")
+{
+  ScratchDirectory scratch;
+  const std::string source = scratch.file("source.bin");
+  const std::string destination = scratch.file("copy.bin");
+  std::string big;
+  for (int i = 0; i < 8; ++i)
+  {
+    big += payload();
+  }
+  FileSystem::write_file(source, big);
+  state.reset_timer();
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    FileSystem::copy_file(source, destination);
+  }
+  state.set_bytes_processed(big.size() * state.iterations());
+  state.stop_timer();
+}
+
+namespace
+{
+
+void make_tree(const ScratchDirectory &scratch)
+{
+  for (int d = 0; d < 40; ++d)
+  {
+    const std::string directory = scratch.file("tree/d" + std::to_string(d));
+    FileSystem::create_directories(directory);
+    for (int f = 0; f < 50; ++f)
+    {
+      FileSystem::write_file(directory + "/f" + std::to_string(f), "");
+    }
+  }
+}
+
+} // namespace
+
+PIXELLIB_BENCHMARK("filesystem/walk/2k_entries")
+{
+  ScratchDirectory scratch;
+  make_tree(scratch);
+  uint64_t entries = 0;
+  state.reset_timer();
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    FileSystem::walk(scratch.file("tree"), [&entries](const DirectoryEntry &)
+                     {
+                       ++entries;
+                       return true;
+                     });
+  }
+  state.set_items_processed(entries);
+  state.stop_timer();
+}
+
+PIXELLIB_BENCHMARK("filesystem/walk/2k_entries/threads:4")
+{
+  ScratchDirectory scratch;
+  make_tree(scratch);
+  WalkOptions options;
+  options.threads = 4;
+  uint64_t entries = 0;
+  state.reset_timer();
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    FileSystem::walk(scratch.file("tree"), [&entries](const DirectoryEntry &)
+                     {
+                       ++entries;
+                       return true;
+                     }, options);
+  }
+  state.set_items_processed(entries);
+  state.stop_timer();
+}
@@ -0,0 +1,261 @@
+#include "bench.hpp"
+
+#include "../include/json.hpp"
+
+#include <string>
+#include <vector>
+
+using pixellib::bench::do_not_optimize;
+using pixellib::core::json::JSON;
+using pixellib::core::json::JsonQuery;
+using pixellib::core::json::JsonWriter;
+using pixellib::core::json::NdjsonParser;
+
+namespace
+{
+
+// API-response-like document: an array of records mixing short strings,
+// escapes, integers, doubles, booleans and a nested array.
+void write_document(JsonWriter &writer, const int records)
+{
+  writer.begin_object();
+  writer.key("count").value(records);
+  writer.key("items").begin_array();
+  for (int i = 0; i < records; ++i)
+  {
+    writer.begin_object();
+    writer.key("id").value(1000000 + i);
+    writer.key("name").value("item \"" + std::to_string(i) + "\"");
+    writer.key("path").value(std::string_view("/var/data/records/segment"));
+    writer.key("price").value(i * 0.25 + 0.1);
+    writer.key("active").value(i % 3 != 0);
+    writer.key("tags").begin_array().value("alpha").value("beta").value(i).end_array();
+    writer.end_object();
+  }
+  writer.end_array();
+  writer.end_object();
+}
+
+const std::string &document()
+{
+  static const std::string text = []
+  {
+    std::string out;
+    JsonWriter writer(out);
+    write_document(writer, 2000);
+    return out;
+  }();
+  return text;
+}
+
+} // namespace
+
+PIXELLIB_BENCHMARK("json/parse/document")
+{
+  const std::string &text = document();
+  state.reset_timer();
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    JSON doc;
+    JSON::parse(text, doc);
+    do_not_optimize(doc);
+  }
+  state.set_bytes_processed(text.size() * state.iterations());
+}
+
+PIXELLIB_BENCHMARK("json/stringify/document")
+{
+  JSON doc;
+  JSON::parse(document(), doc);
+  size_t bytes = 0;
+  state.reset_timer();
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    const std::string out = doc.stringify();
+    bytes += out.size();
+    do_not_optimize(out);
+  }
+  state.set_bytes_processed(bytes);
+}
+
+PIXELLIB_BENCHMARK("json/writer/document")
+{
+  std::string out;
+  size_t bytes = 0;
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    out.clear();
+    JsonWriter writer(out);
+    write_document(writer, 2000);
+    bytes += out.size();
+    do_not_optimize(out);
+  }
+  state.set_bytes_processed(bytes);
+}
+
+namespace
+{
+
+// Base64-like payload with occasional escapes: long runs the SIMD string
+// scanner can skip, then a quote and a newline to escape.
+const std::string &string_payload()
+{
+  static const std::string payload = []
+  {
+    std::string out;
+    out.reserve(1 << 20);
+    while (out.size() < (1 << 20))
+    {
+      out += "QUJDREVGR0hJSktMTU5PUFFSU1RVVldYWVphYmNkZWZnaGlqa2xtbm9wcXJzdHV2d3h5ejAxMjM0NTY3ODk+";
+      out += "\"quoted\"\n";
+    }
+    return out;
+  }();
+  return payload;
+}
+
+std::string event_log(const int events)
+{
+  std::string text = R"({"events":[)";
+  for (int i = 0; i < events; ++i)
+  {
+    text += (i ? "," : "");
+    text += R"({"ts":)" + std::to_string(i) + R"(,"payload":{"message":"some log line with text","values":[1,2,3,4]}})";
+  }
+  text += "]}";
+  return text;
+}
+
+std::string ndjson_lines(const int lines)
+{
+  std::string text;
+  for (int i = 0; i < lines; ++i)
+  {
+    text += R"({"ts":)" + std::to_string(i) + R"(,"level":"info","message":"request served","tags":["a","b"]})" "\n";
+  }
+  return text;
+}
+
+JSON sensor_rows(const int rows)
+{
+  JSON::array_t out;
+  for (int i = 0; i < rows; ++i)
+  {
+    out.push_back(JSON::object(JSON::object_t{{"ts", JSON::number(std::to_string(1700000000 + i))},
+                                              {"value", JSON(i * 0.25)},
+                                              {"name", JSON(std::string("sensor-") + std::to_string(i % 16))}}));
+  }
+  return JSON::array(std::move(out));
+}
+
+} // namespace
+
+PIXELLIB_BENCHMARK("json/stringify/long_string")
+{
+  const JSON value(string_payload());
+  size_t bytes = 0;
+  state.reset_timer();
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    const std::string out = value.stringify();
+    bytes += out.size();
+    do_not_optimize(out);
+  }
+  state.set_bytes_processed(bytes);
+}
+
+PIXELLIB_BENCHMARK("json/parse/long_string")
+{
+  const std::string text = JSON(string_payload()).stringify();
+  state.reset_timer();
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    JSON doc;
+    JSON::parse(text, doc);
+    do_not_optimize(doc);
+  }
+  state.set_bytes_processed(text.size() * state.iterations());
+}
+
+// Pointer query against the full parse of the same document below.
+PIXELLIB_BENCHMARK("json/query/events")
+{
+  const std::string text = event_log(20000);
+  const JsonQuery query{"/events/*/ts"};
+  std::vector<std::vector<JSON>> matches;
+  state.reset_timer();
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    query.run(text, matches);
+    do_not_optimize(matches);
+  }
+  state.set_bytes_processed(text.size() * state.iterations());
+}
+
+PIXELLIB_BENCHMARK("json/parse/events")
+{
+  const std::string text = event_log(20000);
+  state.reset_timer();
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    JSON doc;
+    JSON::parse(text, doc);
+    do_not_optimize(doc);
+  }
+  state.set_bytes_processed(text.size() * state.iterations());
+}
+
+namespace
+{
+
+// threads == 0 lets the parser use every hardware thread.
+const bool ndjson_registered = []
+{
+  for (const size_t threads : {1, 0})
+  {
+    const std::string suffix = threads ? "/threads:1" : "/threads:all";
+    pixellib::bench::register_benchmark("json/ndjson/lines" + suffix, [threads](pixellib::bench::State &state)
+                                        {
+                                          const std::string text = ndjson_lines(100000);
+                                          const NdjsonParser parser({threads, 1 << 20, {}});
+                                          size_t records = 0;
+                                          state.reset_timer();
+                                          for (uint64_t i = 0; i < state.iterations(); ++i)
+                                          {
+                                            parser.parse(text, [&](size_t, JSON &&) { return ++records > 0; });
+                                          }
+                                          do_not_optimize(records);
+                                          state.set_bytes_processed(text.size() * state.iterations());
+                                        });
+  }
+  return true;
+}();
+
+} // namespace
+
+PIXELLIB_BENCHMARK("json/cbor/decode")
+{
+  const std::string binary = sensor_rows(20000).to_cbor();
+  state.reset_timer();
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    JSON doc;
+    JSON::from_cbor(binary, doc);
+    do_not_optimize(doc);
+  }
+  state.set_bytes_processed(binary.size() * state.iterations());
+}
+
+PIXELLIB_BENCHMARK("json/cbor/encode")
+{
+  const JSON doc = sensor_rows(20000);
+  size_t bytes = 0;
+  state.reset_timer();
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    const std::string out = doc.to_cbor();
+    bytes += out.size();
+    do_not_optimize(out);
+  }
+  state.set_bytes_processed(bytes);
+}
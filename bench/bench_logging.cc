@@ -0,0 +1,449 @@
+#include "bench.hpp"
+
+#include "../include/filesystem.hpp"
+#include "../include/logging.hpp"
+
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h>
+#define PIXELLIB_BENCH_GETPID _getpid
+#else
+#include <unistd.h>
+#define PIXELLIB_BENCH_GETPID getpid
+#endif
+
+namespace logging = pixellib::core::logging;
+using logging::AsyncLogSink;
+using logging::Logger;
+using pixellib::bench::do_not_optimize;
+using pixellib::core::filesystem::FileSystem;
+
+namespace
+{
+
+// Discards everything written to it, so stream sinks measure formatting and
+// dispatch rather than terminal speed.
+class NullBuffer : public std::streambuf
+{
+protected:
+  int_type overflow(const int_type ch) override
+  {
+    return traits_type::not_eof(ch);
+  }
+
+  std::streamsize xsputn(const char *, const std::streamsize count) override
+  {
+    return count;
+  }
+};
+
+std::ostream &null_stream()
+{
+  static NullBuffer buffer;
+  static std::ostream stream(&buffer);
+  return stream;
+}
+
+// Splits state.iterations() info calls across threads; the reported time per
+// iteration is the wall time per message across all threads.
+void log_from_threads(pixellib::bench::State &state, const size_t threads)
+{
+  const auto worker = [](const uint64_t count)
+  {
+    for (uint64_t i = 0; i < count; ++i)
+    {
+      Logger::info("request served status=200 bytes=5120");
+    }
+  };
+  std::vector<std::thread> pool;
+  const uint64_t per_thread = state.iterations() / threads;
+  for (size_t t = 1; t < threads; ++t)
+  {
+    pool.emplace_back(worker, per_thread);
+  }
+  worker(state.iterations() - per_thread * (threads - 1));
+  for (auto &thread : pool)
+  {
+    thread.join();
+  }
+  state.set_items_processed(state.iterations());
+}
+
+class NullSink : public logging::LogSink
+{
+public:
+  void write(const std::string &) override {}
+};
+
+void reset_logger()
+{
+  Logger::configure(Logger::LoggerConfigBuilder().set_level(logging::LOG_INFO).build());
+}
+
+std::string bench_log_path()
+{
+  return FileSystem::temp_directory_path() + "/pixellib_bench_" + std::to_string(PIXELLIB_BENCH_GETPID()) + ".log";
+}
+
+const bool registered = []
+{
+  Logger::set_output_streams(null_stream(), null_stream());
+
+  pixellib::bench::register_benchmark("logging/filtered", [](pixellib::bench::State &state)
+                                      {
+                                        Logger::configure(Logger::LoggerConfigBuilder().set_level(logging::LOG_INFO).add_stream_sink(null_stream()).build());
+                                        state.reset_timer();
+                                        for (uint64_t i = 0; i < state.iterations(); ++i)
+                                        {
+                                          Logger::debug("filtered out");
+                                        }
+                                        state.set_items_processed(state.iterations());
+                                        state.stop_timer();
+                                        reset_logger();
+                                      });
+
+  for (const size_t threads : {1, 4})
+  {
+    const std::string suffix = "/threads:" + std::to_string(threads);
+    pixellib::bench::register_benchmark("logging/stream_sink" + suffix, [threads](pixellib::bench::State &state)
+                                        {
+                                          Logger::configure(Logger::LoggerConfigBuilder().set_level(logging::LOG_INFO).add_stream_sink(null_stream()).build());
+                                          state.reset_timer();
+                                          log_from_threads(state, threads);
+                                          state.stop_timer();
+                                          reset_logger();
+                                        });
+
+    pixellib::bench::register_benchmark("logging/file_sink" + suffix, [threads](pixellib::bench::State &state)
+                                        {
+                                          const std::string path = bench_log_path();
+                                          Logger::configure(Logger::LoggerConfigBuilder().set_level(logging::LOG_INFO).add_file_sink(path, size_t{1} << 40, 1).build());
+                                          state.reset_timer();
+                                          log_from_threads(state, threads);
+                                          state.stop_timer();
+                                          reset_logger();
+                                          FileSystem::remove(path);
+                                        });
+
+    // Caller-side cost with a blocking queue: a full queue throttles callers to
+    // the worker's drain rate, so sustained throughput is measured, not drops.
+    pixellib::bench::register_benchmark("logging/async_sink" + suffix, [threads](pixellib::bench::State &state)
+                                        {
+                                          Logger::configure(Logger::LoggerConfigBuilder()
+                                                                .set_level(logging::LOG_INFO)
+                                                                .add_async_sink(std::make_unique<logging::StreamSink>(null_stream()), 8192, AsyncLogSink::DropPolicy::BLOCK,
+                                                                                AsyncLogSink::QueueBackend::LOCK_FREE)
+                                                                .build());
+                                          state.reset_timer();
+                                          log_from_threads(state, threads);
+                                          state.stop_timer();
+                                          Logger::async_flush();
+                                          reset_logger();
+                                        });
+  }
+  return true;
+}();
+
+} // namespace
+
+namespace
+{
+
+// Producers write straight into the sink, bypassing the logger, so the two
+// queue backends are compared on the same blocking workload.
+void write_from_threads(pixellib::bench::State &state, AsyncLogSink &async, const size_t threads)
+{
+  const std::string message(96, 'x');
+  const auto worker = [&](const uint64_t count)
+  {
+    for (uint64_t i = 0; i < count; ++i)
+    {
+      async.write(message);
+    }
+  };
+  std::vector<std::thread> pool;
+  const uint64_t per_thread = state.iterations() / threads;
+  for (size_t t = 1; t < threads; ++t)
+  {
+    pool.emplace_back(worker, per_thread);
+  }
+  worker(state.iterations() - per_thread * (threads - 1));
+  for (auto &thread : pool)
+  {
+    thread.join();
+  }
+  async.flush();
+  state.set_items_processed(state.iterations());
+}
+
+const bool sink_registered = []
+{
+  for (const auto &[name, backend] : {std::pair{"mutex", AsyncLogSink::QueueBackend::MUTEX}, std::pair{"lock_free", AsyncLogSink::QueueBackend::LOCK_FREE}})
+  {
+    pixellib::bench::register_benchmark(std::string("logging/async_queue/") + name + "/threads:8", [backend](pixellib::bench::State &state)
+                                        {
+                                          AsyncLogSink async(std::make_unique<NullSink>(), 1024, AsyncLogSink::DropPolicy::BLOCK, std::chrono::milliseconds(5000), backend);
+                                          state.reset_timer();
+                                          write_from_threads(state, async, 8);
+                                        });
+  }
+
+  for (const size_t buffer_size : {size_t{0}, size_t{64 * 1024}})
+  {
+    const std::string suffix = buffer_size ? "/buffer:64k" : "/unbuffered";
+    pixellib::bench::register_benchmark("logging/rotating_file" + suffix, [buffer_size](pixellib::bench::State &state)
+                                        {
+                                          const std::string path = bench_log_path();
+                                          logging::RotatingFileOptions options;
+                                          options.buffer_size = buffer_size;
+                                          const std::string message(80, 'p');
+                                          {
+                                            logging::RotatingFileLogger file(path, size_t{1} << 40, 1, options);
+                                            state.reset_timer();
+                                            for (uint64_t i = 0; i < state.iterations(); ++i)
+                                            {
+                                              file.write(message);
+                                            }
+                                            file.flush();
+                                            state.stop_timer();
+                                          }
+                                          state.set_items_processed(state.iterations());
+                                          FileSystem::remove(path);
+                                        });
+  }
+
+  // Caller-side latency: eager calls format before enqueueing, deferred calls
+  // copy the arguments and leave formatting to the worker.
+  for (const bool deferred : {false, true})
+  {
+    pixellib::bench::register_benchmark(std::string("logging/async_format/") + (deferred ? "deferred" : "eager"), [deferred](pixellib::bench::State &state)
+                                        {
+                                          Logger::LoggerConfigBuilder builder;
+                                          builder.set_level(logging::LOG_INFO);
+                                          if (deferred)
+                                          {
+                                            builder.add_deferred_async_sink(std::make_unique<NullSink>(), nullptr, 1 << 16, AsyncLogSink::DropPolicy::BLOCK);
+                                          }
+                                          else
+                                          {
+                                            builder.add_async_sink(std::make_unique<NullSink>(), 1 << 16, AsyncLogSink::DropPolicy::BLOCK, AsyncLogSink::QueueBackend::LOCK_FREE);
+                                          }
+                                          Logger::configure(builder.build());
+                                          Logger::set_deferred_formatting(deferred);
+                                          state.reset_timer();
+                                          for (uint64_t i = 0; i < state.iterations(); ++i)
+                                          {
+                                            Logger::info("request {} took {} ms on {}", i, 1.25, "worker-3");
+                                          }
+                                          state.set_items_processed(state.iterations());
+                                          state.stop_timer();
+                                          Logger::async_flush();
+                                          Logger::set_deferred_formatting(false);
+                                          reset_logger();
+                                        });
+  }
+  return true;
+}();
+
+} // namespace
+
+// Formatting a timestamp from scratch with put_time, the baseline for the
+// per-thread cached prefix below.
+PIXELLIB_BENCHMARK("logging/timestamp/put_time")
+{
+  size_t bytes = 0;
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    const std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    std::tm local_tm;
+    localtime_threadsafe(&now, &local_tm);
+    std::ostringstream oss;
+    oss << "[" << std::put_time(&local_tm, "%Y-%m-%d %H:%M:%S") << "] ";
+    bytes += oss.str().size();
+  }
+  do_not_optimize(bytes);
+  state.set_items_processed(state.iterations());
+}
+
+PIXELLIB_BENCHMARK("logging/timestamp/cached")
+{
+  std::string text;
+  size_t bytes = 0;
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    text.clear();
+    text.push_back('[');
+    logging::detail::append_timestamp(text, std::chrono::system_clock::now(), logging::TimestampFormat::STANDARD, logging::TimestampPrecision::MILLISECONDS);
+    text.append("] ");
+    bytes += text.size();
+  }
+  do_not_optimize(bytes);
+  state.set_items_processed(state.iterations());
+}
+
+// The LOG_DEBUG macro below the configured level, as at a real call site.
+PIXELLIB_BENCHMARK("logging/filtered/macro")
+{
+  Logger::configure(Logger::LoggerConfigBuilder().set_level(logging::LOG_INFO).add_stream_sink(null_stream()).build());
+  state.reset_timer();
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    LOG_DEBUG("x");
+  }
+  state.set_items_processed(state.iterations());
+  state.stop_timer();
+  reset_logger();
+}
+
+PIXELLIB_BENCHMARK("logging/format/runtime")
+{
+  Logger::configure(Logger::LoggerConfigBuilder().set_level(logging::LOG_INFO).add_stream_sink(null_stream()).build());
+  state.reset_timer();
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    Logger::info("request {} took {} ms on {}", i, 12.5, "worker");
+  }
+  state.set_items_processed(state.iterations());
+  state.stop_timer();
+  reset_logger();
+}
+
+PIXELLIB_BENCHMARK("logging/format/checked")
+{
+  Logger::configure(Logger::LoggerConfigBuilder().set_level(logging::LOG_INFO).add_stream_sink(null_stream()).build());
+  state.reset_timer();
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    Logger::infof("request {} took {} ms on {}", i, 12.5, "worker");
+  }
+  state.set_items_processed(state.iterations());
+  state.stop_timer();
+  reset_logger();
+}
+
+PIXELLIB_BENCHMARK("logging/format/checked_filtered")
+{
+  Logger::configure(Logger::LoggerConfigBuilder().set_level(logging::LOG_INFO).add_stream_sink(null_stream()).build());
+  state.reset_timer();
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    Logger::debugf("request {} took {} ms on {}", i, 12.5, "worker");
+  }
+  state.set_items_processed(state.iterations());
+  state.stop_timer();
+  reset_logger();
+}
+
+// JSON lines carrying four context members, whose escaped fragments are cached
+// by the LogContext rather than rebuilt for every message.
+PIXELLIB_BENCHMARK("logging/json_formatter/context")
+{
+  logging::JSONLogFormatter formatter;
+  std::tm tm{};
+  logging::LogContext context;
+  context.add("request_id", "9f3c2a7e-41d0-4b8e-a1f2-0c6d5e4b3a21");
+  context.add("user", "alice \"admin\"");
+  context.add("session", 1234567);
+  context.add("path", "/api/v1/items");
+  size_t bytes = 0;
+  state.reset_timer();
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    bytes += formatter.format(logging::LOG_INFO, "m", tm, nullptr, 0).size();
+  }
+  do_not_optimize(bytes);
+  state.set_items_processed(state.iterations());
+}
+
+// A 10 KB message where every fourth byte needs escaping.
+PIXELLIB_BENCHMARK("logging/json_formatter/escape_heavy")
+{
+  logging::JSONLogFormatter formatter;
+  std::tm tm{};
+  std::string message;
+  for (int i = 0; i < 1000; ++i)
+  {
+    message += "part \"\\\n\t";
+  }
+  size_t bytes = 0;
+  state.reset_timer();
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    bytes += formatter.format(logging::LOG_INFO, message, tm, nullptr, 0).size();
+  }
+  do_not_optimize(bytes);
+  state.set_bytes_processed(message.size() * state.iterations());
+}
+
+PIXELLIB_BENCHMARK("logging/category/filtered_handle")
+{
+  Logger::LoggerRegistry::set_config("bench", Logger::LoggerConfigBuilder().set_level(logging::LOG_WARNING).add_stream_sink(null_stream()).build());
+  auto handle = Logger::get("bench");
+  state.reset_timer();
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    handle.info("filtered");
+  }
+  state.set_items_processed(state.iterations());
+}
+
+// Looking the category up by name on every call, what a handle saves.
+PIXELLIB_BENCHMARK("logging/category/registry_lookup")
+{
+  Logger::LoggerRegistry::set_config("bench", Logger::LoggerConfigBuilder().set_level(logging::LOG_WARNING).add_stream_sink(null_stream()).build());
+  size_t found = 0;
+  state.reset_timer();
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    found += Logger::LoggerRegistry::get_config("bench") != nullptr;
+  }
+  do_not_optimize(found);
+  state.set_items_processed(state.iterations());
+}
+
+// A flooding call site held to 10 messages per second; nearly every call is
+// rejected by the throttle.
+PIXELLIB_BENCHMARK("logging/throttled/rate_limited")
+{
+  Logger::configure(Logger::LoggerConfigBuilder().set_level(logging::LOG_INFO).add_stream_sink(null_stream()).build());
+  state.reset_timer();
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    LOG_THROTTLED(logging::LOG_WARNING, logging::LogThrottlePolicy::per_second(10, 10), "flood");
+  }
+  state.set_items_processed(state.iterations());
+  state.stop_timer();
+  reset_logger();
+}
+
+PIXELLIB_BENCHMARK("logging/metrics/histogram_record")
+{
+  logging::LogHistogram histogram;
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    histogram.record(i * 37);
+  }
+  do_not_optimize(histogram.snapshot().count);
+  state.set_items_processed(state.iterations());
+}
+
+PIXELLIB_BENCHMARK("logging/metrics/steady_clock_now")
+{
+  uint64_t sum = 0;
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    sum += static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+  }
+  do_not_optimize(sum);
+  state.set_items_processed(state.iterations());
+}
@@ -0,0 +1,319 @@
+#include "bench.hpp"
+
+#include "../include/network.hpp"
+
+#include <string>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#endif
+
+using pixellib::bench::do_not_optimize;
+using pixellib::core::network::ConnectionPoolOptions;
+using pixellib::core::network::HttpBatchOptions;
+using pixellib::core::network::HttpBatchResult;
+using pixellib::core::network::Network;
+using pixellib::core::network::Url;
+using pixellib::core::network::UrlView;
+
+namespace
+{
+
+const std::string sample_url = "https://user@api.example.com:8443/v1/search/items?q=hello%20world&page=2&sort=desc#results";
+const std::string sample_component = "name=J\xc3\xbcrgen M\xc3\xbcller&city=K\xc3\xb6ln/Altstadt?page=2";
+
+} // namespace
+
+PIXELLIB_BENCHMARK("network/ipv4/valid")
+{
+  const std::string address = "192.168.100.254";
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    do_not_optimize(Network::is_valid_ipv4(address));
+  }
+  state.set_items_processed(state.iterations());
+}
+
+PIXELLIB_BENCHMARK("network/ipv4/invalid")
+{
+  const std::string address = "256.168.1.1";
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    do_not_optimize(Network::is_valid_ipv4(address));
+  }
+  state.set_items_processed(state.iterations());
+}
+
+PIXELLIB_BENCHMARK("network/ipv6/valid")
+{
+  const std::string address = "2001:db8:85a3::8a2e:370:7334";
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    do_not_optimize(Network::is_valid_ipv6(address));
+  }
+  state.set_items_processed(state.iterations());
+}
+
+PIXELLIB_BENCHMARK("network/url/parse")
+{
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    Url url;
+    do_not_optimize(Url::parse(sample_url, url).success);
+    do_not_optimize(url);
+  }
+  state.set_items_processed(state.iterations());
+}
+
+PIXELLIB_BENCHMARK("network/url/parse_view")
+{
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    UrlView view;
+    do_not_optimize(UrlView::parse(sample_url, view));
+    do_not_optimize(view);
+  }
+  state.set_items_processed(state.iterations());
+}
+
+PIXELLIB_BENCHMARK("network/url/encode")
+{
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    do_not_optimize(Network::url_encode(sample_component));
+  }
+  state.set_bytes_processed(sample_component.size() * state.iterations());
+}
+
+PIXELLIB_BENCHMARK("network/url/encode_to")
+{
+  std::string out;
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    out.clear();
+    Network::url_encode_to(sample_component, out);
+    do_not_optimize(out);
+  }
+  state.set_bytes_processed(sample_component.size() * state.iterations());
+}
+
+PIXELLIB_BENCHMARK("network/url/decode_in_place")
+{
+  const std::string encoded = Network::url_encode(sample_component);
+  std::string buffer;
+  state.reset_timer();
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    buffer.assign(encoded);
+    Network::url_decode_in_place(buffer);
+    do_not_optimize(buffer);
+  }
+  state.set_bytes_processed(encoded.size() * state.iterations());
+}
+
+PIXELLIB_BENCHMARK("network/http/response_code")
+{
+  const std::string response = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    do_not_optimize(Network::parse_http_response_code(response));
+  }
+  state.set_items_processed(state.iterations());
+}
+
+#ifndef _WIN32
+namespace
+{
+
+// Keep-alive HTTP/1.1 server on 127.0.0.1 answering every GET with a short
+// Content-Length body; "/slow..." paths respond after 5ms, standing in for a
+// remote host's latency.
+class LoopbackServer
+{
+public:
+  LoopbackServer()
+  {
+    listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ::bind(listen_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+    ::listen(listen_fd_, 128);
+    socklen_t len = sizeof(addr);
+    ::getsockname(listen_fd_, reinterpret_cast<sockaddr *>(&addr), &len);
+    port_ = ntohs(addr.sin_port);
+    acceptor_ = std::thread([this] { accept_loop(); });
+  }
+
+  ~LoopbackServer()
+  {
+    stopping_ = true;
+    ::shutdown(listen_fd_, SHUT_RDWR);
+    ::close(listen_fd_);
+    acceptor_.join();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (const int fd : client_fds_)
+      {
+        ::shutdown(fd, SHUT_RDWR);
+      }
+    }
+    for (auto &worker : workers_)
+    {
+      worker.join();
+    }
+    for (const int fd : client_fds_)
+    {
+      ::close(fd);
+    }
+  }
+
+  LoopbackServer(const LoopbackServer &) = delete;
+  LoopbackServer &operator=(const LoopbackServer &) = delete;
+
+  std::string url(const std::string &path) const
+  {
+    return "http://127.0.0.1:" + std::to_string(port_) + path;
+  }
+
+private:
+  void accept_loop()
+  {
+    while (!stopping_)
+    {
+      const int fd = ::accept(listen_fd_, nullptr, nullptr);
+      if (fd < 0)
+      {
+        continue;
+      }
+      std::lock_guard<std::mutex> lock(mutex_);
+      client_fds_.push_back(fd);
+      workers_.emplace_back([fd] { serve(fd); });
+    }
+  }
+
+  static void serve(const int fd)
+  {
+    static const std::string response = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok";
+    std::string pending;
+    char buffer[4096];
+    for (;;)
+    {
+      size_t header_end = std::string::npos;
+      while ((header_end = pending.find("\r\n\r\n")) == std::string::npos)
+      {
+        const ssize_t received = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (received <= 0)
+        {
+          return;
+        }
+        pending.append(buffer, static_cast<size_t>(received));
+      }
+      const size_t path_start = pending.find(' ') + 1;
+      if (pending.compare(path_start, 5, "/slow") == 0)
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      }
+      pending.erase(0, header_end + 4);
+      if (::send(fd, response.data(), response.size(), MSG_NOSIGNAL) <= 0)
+      {
+        return;
+      }
+    }
+  }
+
+  int listen_fd_ = -1;
+  int port_ = 0;
+  std::atomic<bool> stopping_{false};
+  std::thread acceptor_;
+  std::mutex mutex_;
+  std::vector<int> client_fds_;
+  std::vector<std::thread> workers_;
+};
+
+void run_http_gets(pixellib::bench::State &state, const ConnectionPoolOptions &pool)
+{
+  LoopbackServer server;
+  const std::string url = server.url("/bench");
+  Network::set_connection_pool_options(pool);
+  state.reset_timer();
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    do_not_optimize(Network::http_get(url));
+  }
+  state.set_items_processed(state.iterations());
+  state.stop_timer();
+  Network::clear_connection_pool();
+  Network::set_connection_pool_options({});
+}
+
+} // namespace
+
+PIXELLIB_BENCHMARK("network/http_get/pooled")
+{
+  run_http_gets(state, {});
+}
+
+// A fresh TCP connection per request. Loopback handshakes are cheap, so the
+// gap to pooled requests is far larger against real hosts.
+PIXELLIB_BENCHMARK("network/http_get/fresh")
+{
+  ConnectionPoolOptions no_reuse;
+  no_reuse.max_idle_per_host = 0;
+  run_http_gets(state, no_reuse);
+}
+
+// 16 requests to a host with 5ms of latency per response, one after another
+// with blocking http_get and then as one event-loop batch.
+PIXELLIB_BENCHMARK("network/http_get/sequential_slow")
+{
+  LoopbackServer server;
+  std::vector<std::string> urls;
+  for (int i = 0; i < 16; ++i)
+  {
+    urls.push_back(server.url("/slow" + std::to_string(i)));
+  }
+  state.reset_timer();
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    for (const auto &url : urls)
+    {
+      do_not_optimize(Network::http_get(url));
+    }
+  }
+  state.set_items_processed(urls.size() * state.iterations());
+  state.stop_timer();
+  Network::clear_connection_pool();
+}
+
+PIXELLIB_BENCHMARK("network/http_get_many/slow")
+{
+  LoopbackServer server;
+  std::vector<std::string> urls;
+  for (int i = 0; i < 16; ++i)
+  {
+    urls.push_back(server.url("/slow" + std::to_string(i)));
+  }
+  HttpBatchOptions options;
+  options.max_per_host = 16;
+  state.reset_timer();
+  for (uint64_t i = 0; i < state.iterations(); ++i)
+  {
+    do_not_optimize(Network::http_get_many(urls, [](const HttpBatchResult &) {}, options));
+  }
+  state.set_items_processed(urls.size() * state.iterations());
+  state.stop_timer();
+  Network::clear_connection_pool();
+}
+#endif
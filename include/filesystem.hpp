@@ -31,15 +31,30 @@
 #endif
 #endif
 
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
 #include <climits>
+#include <condition_variable>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
+#include <deque>
+#include <fcntl.h>
 #include <fstream>
+#include <functional>
 #include <ios>
+#include <iterator>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <sys/stat.h>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #ifdef _WIN32
@@ -58,12 +73,18 @@
 #define CHDIR(path) _chdir(path)
 #else
 #include <dirent.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #ifdef __APPLE__
+#include <copyfile.h>
+#include <sys/clonefile.h>
 #include <sys/syslimits.h>
 #else
 #include <limits.h>
 #endif
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
 #define MKDIR(path, mode) mkdir(path, mode)
 #define RMDIR(path) rmdir(path)
 #define GETCWD(buffer, length) getcwd(buffer, length)
@@ -73,6 +94,489 @@
 namespace pixellib::core::filesystem
 {
 
+// Read-only memory mapping of a whole file (mmap / CreateFileMapping). The
+// view stays valid until the object is closed, reassigned or destroyed; an
+// empty file opens successfully with an empty view.
+class MappedFile
+{
+public:
+  MappedFile() = default;
+
+  explicit MappedFile(const std::string &path)
+  {
+    open(path);
+  }
+
+  ~MappedFile()
+  {
+    close();
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  MappedFile(MappedFile &&other) noexcept
+  {
+    swap(other);
+  }
+
+  MappedFile &operator=(MappedFile &&other) noexcept
+  {
+    if (this != &other)
+    {
+      close();
+      swap(other);
+    }
+    return *this;
+  }
+
+  bool open(const std::string &path)
+  {
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+      return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || static_cast<unsigned long long>(size.QuadPart) > SIZE_MAX)
+    {
+      CloseHandle(file);
+      return false;
+    }
+    if (size.QuadPart > 0)
+    {
+      HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      CloseHandle(file);
+      if (!mapping)
+      {
+        return false;
+      }
+      void *address = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+      CloseHandle(mapping);
+      if (!address)
+      {
+        return false;
+      }
+      data_ = static_cast<const char *>(address);
+      size_ = static_cast<size_t>(size.QuadPart);
+    }
+    else
+    {
+      CloseHandle(file);
+    }
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+      return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || static_cast<unsigned long long>(info.st_size) > SIZE_MAX)
+    {
+      ::close(fd);
+      return false;
+    }
+    if (info.st_size > 0)
+    {
+      void *address = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+      if (address == MAP_FAILED)
+      {
+        ::close(fd);
+        return false;
+      }
+      data_ = static_cast<const char *>(address);
+      size_ = static_cast<size_t>(info.st_size);
+    }
+    // The mapping keeps the pages reachable without the descriptor.
+    ::close(fd);
+#endif
+    open_ = true;
+    return true;
+  }
+
+  void close()
+  {
+    if (data_)
+    {
+#ifdef _WIN32
+      UnmapViewOfFile(data_);
+#else
+      munmap(const_cast<char *>(data_), size_);
+#endif
+    }
+    data_ = nullptr;
+    size_ = 0;
+    open_ = false;
+  }
+
+  bool is_open() const
+  {
+    return open_;
+  }
+
+  const char *data() const
+  {
+    return data_;
+  }
+
+  size_t size() const
+  {
+    return size_;
+  }
+
+  std::string_view view() const
+  {
+    return data_ ? std::string_view(data_, size_) : std::string_view();
+  }
+
+private:
+  void swap(MappedFile &other) noexcept
+  {
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    std::swap(open_, other.open_);
+  }
+
+  const char *data_ = nullptr;
+  size_t size_ = 0;
+  bool open_ = false;
+};
+
+enum class FileType
+{
+  Unknown,
+  Regular,
+  Directory,
+  Symlink,
+  Other
+};
+
+// One entry produced by a directory walk. path is the walk root joined with
+// the entry's relative path; depth is 0 for the root's direct children.
+struct DirectoryEntry
+{
+  std::string path;
+  FileType type = FileType::Unknown;
+  size_t depth = 0;
+
+  std::string_view name() const
+  {
+    const size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? std::string_view(path) : std::string_view(path).substr(slash + 1);
+  }
+
+  bool is_directory() const
+  {
+    return type == FileType::Directory;
+  }
+
+  bool is_regular_file() const
+  {
+    return type == FileType::Regular;
+  }
+};
+
+// Options for DirectoryWalker and FileSystem::walk. Directories at depth
+// max_depth are reported but not entered. filter returning false drops an
+// entry and, for a directory, its whole subtree. With follow_symlinks, links
+// are reported as their target's type and linked directories are entered
+// (only max_depth bounds a link cycle). threads > 1 lets FileSystem::walk
+// read subdirectories on that many threads.
+struct WalkOptions
+{
+  size_t max_depth = SIZE_MAX;
+  bool follow_symlinks = false;
+  std::function<bool(const DirectoryEntry &)> filter;
+  size_t threads = 1;
+};
+
+namespace detail
+{
+
+// Reads the names and types of one directory's entries, skipping "." and
+// "..". Types come from d_type / WIN32_FIND_DATA; only file systems that
+// leave d_type unset cost an extra lstat for that entry.
+class DirectoryReader
+{
+public:
+  DirectoryReader() = default;
+  DirectoryReader(const DirectoryReader &) = delete;
+  DirectoryReader &operator=(const DirectoryReader &) = delete;
+
+  ~DirectoryReader()
+  {
+    close();
+  }
+
+  bool open(const std::string &path)
+  {
+    close();
+#ifdef _WIN32
+    handle_ = FindFirstFileExA((path + "\\*").c_str(), FindExInfoBasic, &data_, FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+    pending_ = handle_ != INVALID_HANDLE_VALUE;
+    return pending_;
+#else
+    dir_ = opendir(path.c_str());
+    return dir_ != nullptr;
+#endif
+  }
+
+  bool read(std::string &name, FileType &type)
+  {
+#ifdef _WIN32
+    while (pending_)
+    {
+      const char *entry = data_.cFileName;
+      const DWORD attributes = data_.dwFileAttributes;
+      const bool skip = std::strcmp(entry, ".") == 0 || std::strcmp(entry, "..") == 0;
+      if (!skip)
+      {
+        name = entry;
+        type = (attributes & FILE_ATTRIBUTE_REPARSE_POINT) ? FileType::Symlink
+               : (attributes & FILE_ATTRIBUTE_DIRECTORY)   ? FileType::Directory
+                                                           : FileType::Regular;
+      }
+      pending_ = FindNextFileA(handle_, &data_) != 0;
+      if (!skip)
+      {
+        return true;
+      }
+    }
+    return false;
+#else
+    if (!dir_)
+    {
+      return false;
+    }
+    while (const struct dirent *entry = readdir(dir_))
+    {
+      const char *entry_name = entry->d_name;
+      if (entry_name[0] == '.' && (entry_name[1] == '\0' || (entry_name[1] == '.' && entry_name[2] == '\0')))
+      {
+        continue;
+      }
+      name = entry_name;
+      switch (entry->d_type)
+      {
+      case DT_REG:
+        type = FileType::Regular;
+        break;
+      case DT_DIR:
+        type = FileType::Directory;
+        break;
+      case DT_LNK:
+        type = FileType::Symlink;
+        break;
+      case DT_UNKNOWN:
+      {
+        struct stat info;
+        type = fstatat(dirfd(dir_), entry_name, &info, AT_SYMLINK_NOFOLLOW) == 0 ? type_from_mode(info.st_mode) : FileType::Unknown;
+        break;
+      }
+      default:
+        type = FileType::Other;
+        break;
+      }
+      return true;
+    }
+    return false;
+#endif
+  }
+
+  void close()
+  {
+#ifdef _WIN32
+    if (handle_ != INVALID_HANDLE_VALUE)
+    {
+      FindClose(handle_);
+      handle_ = INVALID_HANDLE_VALUE;
+    }
+    pending_ = false;
+#else
+    if (DIR *dir = std::exchange(dir_, nullptr))
+    {
+      closedir(dir);
+    }
+#endif
+  }
+
+  static FileType type_from_mode(const unsigned mode)
+  {
+    if (S_ISREG(mode))
+      return FileType::Regular;
+    if (S_ISDIR(mode))
+      return FileType::Directory;
+#ifdef S_ISLNK
+    if (S_ISLNK(mode))
+      return FileType::Symlink;
+#endif
+    return FileType::Other;
+  }
+
+private:
+#ifdef _WIN32
+  HANDLE handle_ = INVALID_HANDLE_VALUE;
+  WIN32_FIND_DATAA data_{};
+  bool pending_ = false;
+#else
+  DIR *dir_ = nullptr;
+#endif
+};
+
+inline std::string join_path(const std::string &directory, const std::string &name)
+{
+  if (directory.empty() || directory.back() == '/' || directory.back() == '\\')
+  {
+    return directory + name;
+  }
+  return directory + "/" + name;
+}
+
+// Applies follow_symlinks and the filter; returns false to drop the entry.
+inline bool accept_entry(DirectoryEntry &entry, const WalkOptions &options)
+{
+  if (options.follow_symlinks && entry.type == FileType::Symlink)
+  {
+    struct stat info;
+    entry.type = stat(entry.path.c_str(), &info) == 0 ? DirectoryReader::type_from_mode(info.st_mode) : FileType::Unknown;
+  }
+  return !options.filter || options.filter(entry);
+}
+
+// Entries a parallel walk worker buffers before taking the visit lock.
+inline constexpr size_t walk_batch_size = 256;
+
+} // namespace detail
+
+// Lazy, depth-first (pre-order) recursive walk over everything below root.
+// Each increment reads at most up to the next entry; only one directory
+// handle per level of the current path is open. Unreadable subdirectories are
+// skipped. Usable as a range:
+//   for (const DirectoryEntry &entry : DirectoryWalker("assets")) ...
+class DirectoryWalker
+{
+public:
+  class iterator
+  {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = DirectoryEntry;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const DirectoryEntry *;
+    using reference = const DirectoryEntry &;
+
+    iterator() = default;
+    explicit iterator(DirectoryWalker *walker) : walker_(walker && walker->current() ? walker : nullptr) {}
+
+    reference operator*() const { return walker_->entry_; }
+    pointer operator->() const { return &walker_->entry_; }
+
+    iterator &operator++()
+    {
+      if (!walker_->next())
+      {
+        walker_ = nullptr;
+      }
+      return *this;
+    }
+
+    void operator++(int) { ++*this; }
+
+    bool operator==(const iterator &other) const { return walker_ == other.walker_; }
+    bool operator!=(const iterator &other) const { return walker_ != other.walker_; }
+
+  private:
+    DirectoryWalker *walker_ = nullptr;
+  };
+
+  explicit DirectoryWalker(std::string root, WalkOptions options = WalkOptions()) : options_(std::move(options))
+  {
+    auto frame = std::make_unique<Frame>();
+    frame->path = std::move(root);
+    if (frame->reader.open(frame->path))
+    {
+      opened_ = true;
+      stack_.push_back(std::move(frame));
+      next();
+    }
+  }
+
+  DirectoryWalker(const DirectoryWalker &) = delete;
+  DirectoryWalker &operator=(const DirectoryWalker &) = delete;
+  DirectoryWalker(DirectoryWalker &&) = default;
+  DirectoryWalker &operator=(DirectoryWalker &&) = default;
+
+  // Advances to the next entry; false once the walk is exhausted.
+  bool next()
+  {
+    if (has_current_ && descend_)
+    {
+      descend_ = false;
+      auto frame = std::make_unique<Frame>();
+      if (frame->reader.open(entry_.path))
+      {
+        frame->path = entry_.path;
+        frame->depth = entry_.depth + 1;
+        stack_.push_back(std::move(frame));
+      }
+    }
+    has_current_ = false;
+    std::string name;
+    while (!stack_.empty())
+    {
+      Frame &frame = *stack_.back();
+      if (!frame.reader.read(name, entry_.type))
+      {
+        stack_.pop_back();
+        continue;
+      }
+      entry_.path = detail::join_path(frame.path, name);
+      entry_.depth = frame.depth;
+      if (!detail::accept_entry(entry_, options_))
+      {
+        continue;
+      }
+      descend_ = entry_.type == FileType::Directory && entry_.depth < options_.max_depth;
+      has_current_ = true;
+      return true;
+    }
+    return false;
+  }
+
+  // The entry the walker is positioned on, or nullptr when exhausted.
+  const DirectoryEntry *current() const
+  {
+    return has_current_ ? &entry_ : nullptr;
+  }
+
+  // False when the walk root could not be opened as a directory.
+  bool is_open() const
+  {
+    return opened_;
+  }
+
+  iterator begin() { return iterator(this); }
+  iterator end() { return iterator(); }
+
+private:
+  struct Frame
+  {
+    detail::DirectoryReader reader;
+    std::string path;
+    size_t depth = 0;
+  };
+
+  WalkOptions options_;
+  std::vector<std::unique_ptr<Frame>> stack_;
+  DirectoryEntry entry_;
+  bool has_current_ = false;
+  bool descend_ = false;
+  bool opened_ = false;
+};
+
 class FileSystem
 {
 public:
@@ -110,14 +614,70 @@ public:
 
   static bool write_file(const std::string &path, const std::string &content)
   {
-    std::ofstream file(path, std::ios::binary);
-    if (file.is_open())
+    const int fd = open_for_write(path, O_TRUNC);
+    if (fd < 0)
     {
-      file << content;
-      file.close();
-      return true;
+      return false;
     }
-    return false;
+    const bool written = write_all(fd, content);
+    return close_fd(fd) && written;
+  }
+
+  // Writes content to a temporary file next to path, flushes it to disk and
+  // renames it over path, so readers see either the old or the new contents
+  // and never a partial file. An existing path keeps its permission bits. On
+  // POSIX the parent directory is synced after the rename so the new entry
+  // survives a crash. Returns false on error, leaving path untouched unless
+  // only that final directory sync failed.
+  static bool write_file_atomic(const std::string &path, std::string_view content)
+  {
+    static std::atomic<unsigned> counter{0};
+#ifdef _WIN32
+    const std::string temp = path + ".tmp." + std::to_string(GetCurrentProcessId()) + "." + std::to_string(counter++);
+#else
+    const std::string temp = path + ".tmp." + std::to_string(getpid()) + "." + std::to_string(counter++);
+#endif
+    const int fd = open_for_write(temp, O_EXCL);
+    if (fd < 0)
+    {
+      return false;
+    }
+    bool ok = true;
+#ifndef _WIN32
+    struct stat existing;
+    if (::stat(path.c_str(), &existing) == 0)
+    {
+      ok = ::fchmod(fd, existing.st_mode & 07777) == 0;
+    }
+#endif
+#ifdef __linux__
+    if (ok && !content.empty())
+    {
+      posix_fallocate(fd, 0, static_cast<off_t>(content.size())); // best effort: one extent, no growth per write
+    }
+#endif
+    ok = ok && write_all(fd, content);
+#ifdef _WIN32
+    ok = ok && _commit(fd) == 0;
+#else
+    ok = ok && fsync(fd) == 0;
+#endif
+    ok = close_fd(fd) && ok;
+#ifdef _WIN32
+    ok = ok && MoveFileExA(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    ok = ok && ::rename(temp.c_str(), path.c_str()) == 0;
+#endif
+    if (!ok)
+    {
+      ::remove(temp.c_str());
+      return false;
+    }
+#ifdef _WIN32
+    return true;
+#else
+    return sync_parent_directory(path);
+#endif
   }
 
   static bool create_directory(const std::string &path)
@@ -175,18 +735,43 @@ public:
     }
   }
 
+  // Copies source over destination inside the kernel where possible:
+  // CopyFile on Windows, clonefile/fcopyfile on macOS, copy_file_range then
+  // sendfile on Linux, with a plain read/write loop as the last resort.
   static bool copy_file(const std::string &source, const std::string &destination)
   {
-    std::ifstream src(source, std::ios::binary);
-    std::ofstream dst(destination, std::ios::binary);
-
-    if (!src.is_open() || !dst.is_open())
+#ifdef _WIN32
+    return CopyFileA(source.c_str(), destination.c_str(), FALSE) != 0;
+#else
+    const int in = ::open(source.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0)
     {
       return false;
     }
-
-    dst << src.rdbuf();
-    return src.good() && dst.good();
+    struct stat info;
+    if (fstat(in, &info) != 0 || !S_ISREG(info.st_mode))
+    {
+      ::close(in);
+      return false;
+    }
+#ifdef __APPLE__
+    // APFS clones share blocks with the source; clonefile needs a fresh destination.
+    if (!exists(destination) && clonefile(source.c_str(), destination.c_str(), 0) == 0)
+    {
+      ::close(in);
+      return true;
+    }
+#endif
+    const int out = open_for_write(destination, O_TRUNC);
+    if (out < 0)
+    {
+      ::close(in);
+      return false;
+    }
+    const bool copied = copy_contents(in, out, static_cast<unsigned long long>(info.st_size));
+    ::close(in);
+    return close_fd(out) && copied;
+#endif
   }
 
   static bool rename(const std::string &source, const std::string &destination)
@@ -253,6 +838,160 @@ public:
     return result;
   }
 
+  // Calls visit for every entry below root (see WalkOptions); visit returning
+  // false stops the walk. With options.threads > 1, subdirectories are read
+  // concurrently and entries arrive in no particular order. Each worker
+  // buffers up to 256 entries and hands them to visit in one go, so visit is
+  // never called concurrently but the lock serializing it is taken once per
+  // batch; options.filter runs on the reading threads and must be
+  // thread-safe. Returns false if root cannot be opened.
+  static bool walk(const std::string &root, const std::function<bool(const DirectoryEntry &)> &visit, const WalkOptions &options = WalkOptions())
+  {
+    if (options.threads <= 1)
+    {
+      DirectoryWalker walker(root, options);
+      if (!walker.is_open())
+      {
+        return false;
+      }
+      for (const DirectoryEntry *entry = walker.current(); entry; entry = walker.next() ? walker.current() : nullptr)
+      {
+        if (!visit(*entry))
+        {
+          break;
+        }
+      }
+      return true;
+    }
+
+    struct WalkQueue
+    {
+      std::mutex mutex;
+      std::condition_variable ready;
+      std::deque<std::pair<std::string, size_t>> pending;
+      size_t busy = 0;
+      bool stopped = false;
+      std::mutex visit_mutex;
+      bool visit_stopped = false; // guarded by visit_mutex
+    } queue;
+
+    detail::DirectoryReader root_reader;
+    if (!root_reader.open(root))
+    {
+      return false;
+    }
+    root_reader.close();
+    queue.pending.emplace_back(root, 0);
+
+    const auto worker = [&]
+    {
+      std::vector<std::pair<std::string, size_t>> subdirectories;
+      std::vector<DirectoryEntry> batch;
+      batch.reserve(detail::walk_batch_size);
+      detail::DirectoryReader reader;
+      DirectoryEntry entry;
+      std::string name;
+
+      // Queues the subdirectories found so far for other workers first, then
+      // delivers the buffered entries under the visit lock.
+      const auto deliver = [&]
+      {
+        if (!subdirectories.empty())
+        {
+          std::lock_guard<std::mutex> lock(queue.mutex);
+          for (auto &subdirectory : subdirectories)
+          {
+            queue.pending.push_back(std::move(subdirectory));
+          }
+          subdirectories.clear();
+          queue.ready.notify_all();
+        }
+        bool keep_going = true;
+        {
+          std::lock_guard<std::mutex> visit_lock(queue.visit_mutex);
+          for (const DirectoryEntry &buffered : batch)
+          {
+            if (queue.visit_stopped || !visit(buffered))
+            {
+              queue.visit_stopped = true;
+              keep_going = false;
+              break;
+            }
+          }
+        }
+        batch.clear();
+        return keep_going;
+      };
+
+      std::unique_lock<std::mutex> lock(queue.mutex);
+      for (;;)
+      {
+        queue.ready.wait(lock, [&] { return queue.stopped || !queue.pending.empty() || queue.busy == 0; });
+        if (queue.stopped || queue.pending.empty())
+        {
+          queue.ready.notify_all();
+          return;
+        }
+        auto [directory, depth] = std::move(queue.pending.front());
+        queue.pending.pop_front();
+        ++queue.busy;
+        lock.unlock();
+
+        bool keep_going = true;
+        if (reader.open(directory))
+        {
+          while (keep_going && reader.read(name, entry.type))
+          {
+            entry.path = detail::join_path(directory, name);
+            entry.depth = depth;
+            if (!detail::accept_entry(entry, options))
+            {
+              continue;
+            }
+            if (entry.type == FileType::Directory && depth < options.max_depth)
+            {
+              subdirectories.emplace_back(entry.path, depth + 1);
+            }
+            batch.push_back(std::move(entry));
+            if (batch.size() == detail::walk_batch_size)
+            {
+              keep_going = deliver();
+            }
+          }
+          reader.close();
+          if (keep_going)
+          {
+            keep_going = deliver();
+          }
+        }
+
+        lock.lock();
+        if (!keep_going)
+        {
+          queue.stopped = true;
+          queue.pending.clear();
+        }
+        subdirectories.clear();
+        batch.clear();
+        --queue.busy;
+        queue.ready.notify_all();
+      }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(options.threads - 1);
+    for (size_t i = 1; i < options.threads; ++i)
+    {
+      threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : threads)
+    {
+      thread.join();
+    }
+    return true;
+  }
+
   static std::string temp_directory_path()
   {
 #ifdef _WIN32
@@ -291,6 +1030,132 @@ public:
   {
     return CHDIR(path.c_str()) == 0;
   }
+
+private:
+  // Opens path write-only, creating it with default permissions; extra_flags
+  // is O_TRUNC to overwrite or O_EXCL to insist on a new file.
+  static int open_for_write(const std::string &path, const int extra_flags)
+  {
+#ifdef _WIN32
+    return _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_BINARY | extra_flags, _S_IREAD | _S_IWRITE);
+#else
+    return ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | extra_flags, 0666);
+#endif
+  }
+
+#ifndef _WIN32
+  // fsyncs the directory containing path, making a rename into it durable.
+  static bool sync_parent_directory(const std::string &path)
+  {
+    const size_t slash = path.find_last_of('/');
+    const std::string parent = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+    const int fd = ::open(parent.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+    {
+      return false;
+    }
+    const bool synced = fsync(fd) == 0;
+    return close_fd(fd) && synced;
+  }
+#endif
+
+  static bool close_fd(const int fd)
+  {
+#ifdef _WIN32
+    return _close(fd) == 0;
+#else
+    return ::close(fd) == 0;
+#endif
+  }
+
+  static bool write_all(const int fd, std::string_view data)
+  {
+    while (!data.empty())
+    {
+#ifdef _WIN32
+      const int chunk = static_cast<int>(std::min<size_t>(data.size(), INT_MAX));
+      const int written = _write(fd, data.data(), static_cast<unsigned>(chunk));
+#else
+      const ssize_t written = ::write(fd, data.data(), data.size());
+      if (written < 0 && errno == EINTR)
+      {
+        continue;
+      }
+#endif
+      if (written <= 0)
+      {
+        return false;
+      }
+      data.remove_prefix(static_cast<size_t>(written));
+    }
+    return true;
+  }
+
+#ifndef _WIN32
+  static bool copy_contents(const int in, const int out, const unsigned long long size)
+  {
+    unsigned long long copied = 0;
+#ifdef __APPLE__
+    if (fcopyfile(in, out, nullptr, COPYFILE_DATA) == 0)
+    {
+      return true;
+    }
+#elif defined(__linux__)
+    // copy_file_range can reflink on btrfs/XFS and stays in the kernel
+    // elsewhere; it refuses some pairs (EXDEV before 5.3, special files), so
+    // fall back to sendfile and finally to user-space copying.
+    while (copied < size)
+    {
+      const ssize_t n = copy_file_range(in, nullptr, out, nullptr, static_cast<size_t>(std::min<unsigned long long>(size - copied, 1ULL << 30)), 0);
+      if (n < 0 && errno == EINTR)
+      {
+        continue;
+      }
+      if (n <= 0)
+      {
+        break;
+      }
+      copied += static_cast<unsigned long long>(n);
+    }
+    while (copied < size)
+    {
+      const ssize_t n = sendfile(out, in, nullptr, static_cast<size_t>(std::min<unsigned long long>(size - copied, 1ULL << 30)));
+      if (n < 0 && errno == EINTR)
+      {
+        continue;
+      }
+      if (n <= 0)
+      {
+        break;
+      }
+      copied += static_cast<unsigned long long>(n);
+    }
+#endif
+    // The file may also have grown since fstat; copy until end of file.
+    std::vector<char> buffer(128 * 1024);
+    for (;;)
+    {
+      const ssize_t n = ::read(in, buffer.data(), buffer.size());
+      if (n < 0 && errno == EINTR)
+      {
+        continue;
+      }
+      if (n < 0)
+      {
+        return false;
+      }
+      if (n == 0)
+      {
+        return true;
+      }
+      if (!write_all(out, std::string_view(buffer.data(), static_cast<size_t>(n))))
+      {
+        return false;
+      }
+      copied += static_cast<unsigned long long>(n);
+    }
+  }
+#endif
 };
 
 } // namespace pixellib::core::filesystem
@@ -34,21 +34,43 @@
 
 #include <doctest/doctest.h>
 
+#include <algorithm>
+#include <atomic>
+#include <bit>
 #include <cctype>
+#include <charconv>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
-#include <iomanip>
-#include <ios>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <initializer_list>
 #include <limits>
+#include <memory_resource>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <type_traits>
 #include <utility>
 #include <variant>
 #include <vector>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define PIXELLIB_JSON_AVX2 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PIXELLIB_JSON_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define PIXELLIB_JSON_NEON 1
+#endif
+
 namespace pixellib::core::json
 {
 
@@ -60,6 +82,22 @@ struct JsonError
   std::string message;
 };
 
+struct ParseOptions
+{
+  // When set, string and number nodes without escapes reference the input
+  // buffer instead of owning a copy. The buffer must outlive the DOM (or the
+  // DOM must be materialize()d before the buffer goes away).
+  bool borrow{false};
+  // Resource used for every array and object container, object key and
+  // decoded string built by the parser, e.g. a
+  // std::pmr::monotonic_buffer_resource so the tree's storage is released in
+  // one go. It must outlive the DOM. Strings from a resource are read with
+  // JSON::as_string_view() without copying; as_string() works too but keeps
+  // a one-time heap copy per string. nullptr uses the default resource
+  // (global heap) and std::string values.
+  std::pmr::memory_resource *resource{nullptr};
+};
+
 struct StringifyOptions
 {
   bool pretty{false};
@@ -82,97 +120,441 @@ public:
 
   struct Number
   {
-    std::string repr;
+    enum class Kind : uint8_t
+    {
+      Unclassified, // built from text alone; converted on each call
+      Int64,
+      Uint64,     // non-negative integer above INT64_MAX
+      BigInteger, // integer syntax beyond 64 bits; value kept as a double
+      Double,
+      Invalid
+    };
+
+    union Value
+    {
+      int64_t i64;
+      uint64_t u64;
+      double f64;
+    };
+
+    Value value{0};
+    Kind kind{Kind::Unclassified};
+
+    Number() = default;
+    explicit Number(std::string_view text)
+    {
+      assign(text);
+    }
+
+    Number(const Number &other) : value(other.value), kind(other.kind)
+    {
+      copy_text(other);
+    }
+
+    Number(Number &&other) noexcept : value(other.value), kind(other.kind), tag_(other.tag_)
+    {
+      std::memcpy(bytes_, other.bytes_, sizeof(bytes_));
+      other.tag_ = 0;
+    }
+
+    Number &operator=(const Number &other)
+    {
+      if (this != &other)
+      {
+        release();
+        value = other.value;
+        kind = other.kind;
+        copy_text(other);
+      }
+      return *this;
+    }
+
+    Number &operator=(Number &&other) noexcept
+    {
+      if (this != &other)
+      {
+        release();
+        value = other.value;
+        kind = other.kind;
+        tag_ = other.tag_;
+        std::memcpy(bytes_, other.bytes_, sizeof(bytes_));
+        other.tag_ = 0;
+      }
+      return *this;
+    }
+
+    ~Number()
+    {
+      release();
+    }
+
+    // Classify and convert text once with the locale-independent from_chars family
+    static Number from_text(std::string_view text, bool borrow = false)
+    {
+      Number number;
+      if (borrow)
+      {
+        number.set_ref(text.data(), text.size(), borrowed_tag);
+      }
+      else
+      {
+        number.assign(text);
+      }
+      const Classified classified = classify(text);
+      number.kind = classified.kind;
+      number.value = classified.value;
+      return number;
+    }
+
+    static Number from_double(double v)
+    {
+      // Shortest representation that reads back as exactly the same double
+      char buffer[32];
+      const auto result = std::to_chars(buffer, buffer + sizeof(buffer), v);
+      const std::string_view text(buffer, static_cast<size_t>(result.ptr - buffer));
+      if (text.find_first_of(".en") == std::string_view::npos)
+      {
+        return from_text(text); // integral spelling, e.g. 42.0 -> "42"
+      }
+      Number number(text);
+      number.kind = Kind::Double;
+      number.value.f64 = v;
+      return number;
+    }
+
+    static Number from_int64(int64_t v)
+    {
+      char buffer[24];
+      const auto result = std::to_chars(buffer, buffer + sizeof(buffer), v);
+      Number number(std::string_view(buffer, static_cast<size_t>(result.ptr - buffer)));
+      number.kind = Kind::Int64;
+      number.value.i64 = v;
+      return number;
+    }
+
+    static Number from_uint64(uint64_t v)
+    {
+      if (v <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max()))
+      {
+        return from_int64(static_cast<int64_t>(v));
+      }
+      char buffer[24];
+      const auto result = std::to_chars(buffer, buffer + sizeof(buffer), v);
+      Number number(std::string_view(buffer, static_cast<size_t>(result.ptr - buffer)));
+      number.kind = Kind::Uint64;
+      number.value.u64 = v;
+      return number;
+    }
+
+    std::string_view text() const
+    {
+      if (tag_ <= inline_capacity)
+      {
+        return std::string_view(bytes_, tag_);
+      }
+      const char *data = nullptr;
+      size_t size = 0;
+      std::memcpy(&data, bytes_, sizeof(data));
+      std::memcpy(&size, bytes_ + sizeof(data), sizeof(size));
+      return std::string_view(data, size);
+    }
+
+    // True when text() points into the caller's buffer
+    bool is_borrowed() const
+    {
+      return tag_ == borrowed_tag;
+    }
+
+    // Copy borrowed text into storage owned by this number
+    void materialize()
+    {
+      if (is_borrowed())
+      {
+        assign(text());
+      }
+    }
+
+    // kind, with Unclassified numbers converted on the fly
+    Kind resolved_kind() const
+    {
+      return kind == Kind::Unclassified ? classify(text()).kind : kind;
+    }
 
     double to_double(double fallback = 0.0) const
     {
-      char *end = nullptr;
-      const double v = std::strtod(repr.c_str(), &end);
-      return (end && *end == '\0') ? v : fallback;
+      const Classified number = resolved();
+      switch (number.kind)
+      {
+      case Kind::Int64:
+        return static_cast<double>(number.value.i64);
+      case Kind::Uint64:
+        return static_cast<double>(number.value.u64);
+      case Kind::BigInteger:
+      case Kind::Double:
+        return number.value.f64;
+      default:
+        return fallback;
+      }
     }
 
+    // Integers outside the int64 range saturate; non-integers return fallback
     int64_t to_int64(int64_t fallback = 0) const
     {
-      char *end = nullptr;
-      const long long v = std::strtoll(repr.c_str(), &end, 10);
-      if (!end || *end != '\0')
+      const Classified number = resolved();
+      switch (number.kind)
       {
+      case Kind::Int64:
+        return number.value.i64;
+      case Kind::Uint64:
+        return std::numeric_limits<int64_t>::max();
+      case Kind::BigInteger:
+        return number.value.f64 < 0 ? std::numeric_limits<int64_t>::min() : std::numeric_limits<int64_t>::max();
+      default:
         return fallback;
       }
-      if (v < std::numeric_limits<int64_t>::min())
+    }
+
+    // Non-negative integers that fit in 64 bits; anything else returns fallback
+    uint64_t to_uint64(uint64_t fallback = 0) const
+    {
+      const Classified number = resolved();
+      if (number.kind == Kind::Uint64)
       {
-        return fallback;
+        return number.value.u64;
       }
-      if (v > std::numeric_limits<int64_t>::max())
+      if (number.kind == Kind::Int64 && number.value.i64 >= 0)
       {
-        return fallback;
+        return static_cast<uint64_t>(number.value.i64);
       }
-      return static_cast<int64_t>(v);
+      return fallback;
     }
 
     bool is_integral() const
     {
-      char *end = nullptr;
-      (void)std::strtoll(repr.c_str(), &end, 10);
-      return end && *end == '\0';
+      const Kind k = resolved_kind();
+      return k == Kind::Int64 || k == Kind::Uint64 || k == Kind::BigInteger;
+    }
+
+  private:
+    // Text lives in bytes_: inline when short (tag_ is the length), otherwise
+    // a pointer and size to a heap copy or to the caller's buffer. This keeps
+    // a Number at 32 bytes, the size of the std::string it replaces.
+    static constexpr size_t inline_capacity = 22;
+    static constexpr uint8_t heap_tag = 0xFE;
+    static constexpr uint8_t borrowed_tag = 0xFF;
+
+    uint8_t tag_{0};
+    char bytes_[inline_capacity]{};
+
+    struct Classified
+    {
+      Kind kind;
+      Value value;
+    };
+
+    // The stored classification, or a fresh one for Unclassified numbers;
+    // either way no text is copied
+    Classified resolved() const
+    {
+      if (kind != Kind::Unclassified)
+      {
+        return {kind, value};
+      }
+      return classify(text());
+    }
+
+    void set_ref(const char *data, size_t size, uint8_t tag)
+    {
+      std::memcpy(bytes_, &data, sizeof(data));
+      std::memcpy(bytes_ + sizeof(data), &size, sizeof(size));
+      tag_ = tag;
+    }
+
+    // Own a copy of text; may be called with a view of our own borrowed text
+    void assign(std::string_view text)
+    {
+      const uint8_t previous = tag_;
+      char *previous_heap = nullptr;
+      if (previous == heap_tag)
+      {
+        std::memcpy(&previous_heap, bytes_, sizeof(previous_heap));
+      }
+      if (text.size() <= inline_capacity)
+      {
+        std::memmove(bytes_, text.data(), text.size());
+        tag_ = static_cast<uint8_t>(text.size());
+      }
+      else
+      {
+        char *heap = new char[text.size()];
+        std::memcpy(heap, text.data(), text.size());
+        set_ref(heap, text.size(), heap_tag);
+      }
+      delete[] previous_heap;
+    }
+
+    void copy_text(const Number &other)
+    {
+      tag_ = 0;
+      if (other.tag_ == heap_tag)
+      {
+        assign(other.text());
+        return;
+      }
+      tag_ = other.tag_;
+      std::memcpy(bytes_, other.bytes_, sizeof(bytes_));
+    }
+
+    void release()
+    {
+      if (tag_ == heap_tag)
+      {
+        char *heap = nullptr;
+        std::memcpy(&heap, bytes_, sizeof(heap));
+        delete[] heap;
+      }
+      tag_ = 0;
+    }
+
+    static Classified classify(std::string_view text)
+    {
+      const char *first = text.data();
+      const char *last = first + text.size();
+      Classified out{Kind::Invalid, {0}};
+      if (text.empty())
+      {
+        return out;
+      }
+
+      int64_t i64 = 0;
+      const auto int_result = std::from_chars(first, last, i64);
+      if (int_result.ec == std::errc() && int_result.ptr == last)
+      {
+        out.kind = Kind::Int64;
+        out.value.i64 = i64;
+        return out;
+      }
+      // from_chars reports out_of_range only after matching the whole digit run
+      const bool integer_syntax = int_result.ec == std::errc::result_out_of_range && int_result.ptr == last;
+      if (integer_syntax && *first != '-')
+      {
+        uint64_t u64 = 0;
+        const auto uint_result = std::from_chars(first, last, u64);
+        if (uint_result.ec == std::errc() && uint_result.ptr == last)
+        {
+          out.kind = Kind::Uint64;
+          out.value.u64 = u64;
+          return out;
+        }
+      }
+
+      double f64 = 0.0;
+      const auto float_result = std::from_chars(first, last, f64);
+      if (float_result.ptr != last)
+      {
+        return out;
+      }
+      if (float_result.ec == std::errc::result_out_of_range)
+      {
+        // Overflow goes to infinity and underflow to zero, as strtod does
+        const size_t exponent = text.find_first_of("eE");
+        const bool underflow = exponent != std::string_view::npos && exponent + 1 < text.size() &&
+                               text[exponent + 1] == '-';
+        f64 = underflow ? 0.0 : std::numeric_limits<double>::infinity();
+        f64 = *first == '-' ? -f64 : f64;
+      }
+      else if (float_result.ec != std::errc())
+      {
+        return out;
+      }
+      out.kind = integer_syntax ? Kind::BigInteger : Kind::Double;
+      out.value.f64 = f64;
+      return out;
     }
   };
 
-  using array_t = std::vector<JSON>;
-  using object_t = std::vector<std::pair<std::string, JSON>>;
+  // Containers and object keys carry a polymorphic allocator; default-
+  // constructed ones use the global heap, parser-built ones use
+  // ParseOptions::resource. Copies always go back to the default resource,
+  // moves keep the source's resource.
+  //
+  // Source compatibility: these were std::vector / std::string before. Code
+  // that spells the types through the aliases is unaffected; code that hands
+  // a std::vector to array()/object() or binds a key to std::string & must
+  // switch to the aliases (or std::string_view for keys).
+  using object_key_t = std::pmr::string;
+  using array_t = std::pmr::vector<JSON>;
+  using object_t = std::pmr::vector<std::pair<object_key_t, JSON>>;
 
-  JSON() : type_(Type::Null), data_(std::monostate{}) {}
-  explicit JSON(std::nullptr_t) : type_(Type::Null), data_(std::monostate{}) {}
-  explicit JSON(bool value) : type_(Type::Bool), data_(value) {}
-  explicit JSON(Number number) : type_(Type::Number), data_(std::move(number)) {}
-  explicit JSON(double number) : type_(Type::Number), data_(Number{format_number(number)}) {}
-  explicit JSON(std::string value) : type_(Type::String), data_(std::move(value)) {}
+  JSON() : data_(std::monostate{}) {}
+  explicit JSON(std::nullptr_t) : data_(std::monostate{}) {}
+  explicit JSON(bool value) : data_(value) {}
+  explicit JSON(Number number) : data_(std::move(number)) {}
+  explicit JSON(double number) : data_(Number::from_double(number)) {}
+  explicit JSON(std::string value) : data_(std::move(value)) {}
   static JSON array(array_t values)
   {
-    return JSON(Type::Array, std::move(values));
+    return JSON(std::in_place, std::move(values));
   }
   static JSON object(object_t values)
   {
-    return JSON(Type::Object, std::move(values));
+    return JSON(std::in_place, ObjectNode{std::move(values), {}});
   }
   static JSON number(std::string_view repr)
   {
-    return JSON(Type::Number, Number{std::string(repr)});
+    return JSON(std::in_place, Number::from_text(repr));
+  }
+
+  // Borrowed nodes reference caller-owned memory; see ParseOptions::borrow.
+  static JSON borrowed_string(std::string_view value)
+  {
+    return JSON(std::in_place, value);
+  }
+  // String whose bytes are allocated from resource, which must outlive it
+  static JSON string(std::string_view value, std::pmr::memory_resource *resource)
+  {
+    return JSON(std::in_place, ResourceString(value, resource));
+  }
+  static JSON borrowed_number(std::string_view repr)
+  {
+    return JSON(std::in_place, Number::from_text(repr, true));
   }
 
   Type type() const
   {
-    return type_;
+    // In storage_t order; owned, borrowed and resource strings are all String
+    static constexpr Type types[] = {Type::Null, Type::Bool, Type::Number, Type::String, Type::String, Type::String, Type::Array, Type::Object};
+    return types[data_.index()];
   }
 
   bool is_null() const
   {
-    return type_ == Type::Null;
+    return type() == Type::Null;
   }
   bool is_bool() const
   {
-    return type_ == Type::Bool;
+    return type() == Type::Bool;
   }
   bool is_number() const
   {
-    return type_ == Type::Number;
+    return type() == Type::Number;
   }
   bool is_string() const
   {
-    return type_ == Type::String;
+    return type() == Type::String;
   }
   bool is_array() const
   {
-    return type_ == Type::Array;
+    return type() == Type::Array;
   }
   bool is_object() const
   {
-    return type_ == Type::Object;
+    return type() == Type::Object;
   }
 
   bool as_bool(bool fallback = false) const
   {
-    if (type_ != Type::Bool)
+    if (type() != Type::Bool)
     {
       return fallback;
     }
@@ -181,7 +563,7 @@ public:
 
   const Number &as_number() const
   {
-    if (type_ != Type::Number)
+    if (type() != Type::Number)
     {
       throw std::logic_error("Not a number");
     }
@@ -190,16 +572,57 @@ public:
 
   const std::string &as_string() const
   {
-    if (type_ != Type::String)
+    if (type() != Type::String)
+    {
+      throw std::logic_error("Not a string");
+    }
+    if (std::holds_alternative<std::string_view>(data_))
+    {
+      throw std::logic_error("Borrowed string; use as_string_view()");
+    }
+    if (const auto *text = std::get_if<ResourceString>(&data_))
+    {
+      return text->str();
+    }
+    return std::get<std::string>(data_);
+  }
+
+  // Works for owned, borrowed and resource strings.
+  std::string_view as_string_view() const
+  {
+    if (type() != Type::String)
     {
       throw std::logic_error("Not a string");
     }
+    if (const auto *view = std::get_if<std::string_view>(&data_))
+    {
+      return *view;
+    }
+    if (const auto *text = std::get_if<ResourceString>(&data_))
+    {
+      return text->view();
+    }
     return std::get<std::string>(data_);
   }
 
+  // True when this node (not its children) references caller-owned memory.
+  bool is_borrowed() const
+  {
+    if (std::holds_alternative<std::string_view>(data_))
+    {
+      return true;
+    }
+    const auto *number = std::get_if<Number>(&data_);
+    return number && number->is_borrowed();
+  }
+
+  // Copy every borrowed string/number in this subtree into owned storage so
+  // the DOM no longer depends on the input buffer.
+  void materialize();
+
   const array_t &as_array() const
   {
-    if (type_ != Type::Array)
+    if (type() != Type::Array)
     {
       throw std::logic_error("Not an array");
     }
@@ -208,7 +631,7 @@ public:
 
   array_t &as_array()
   {
-    if (type_ != Type::Array)
+    if (type() != Type::Array)
     {
       throw std::logic_error("Not an array");
     }
@@ -217,20 +640,35 @@ public:
 
   const object_t &as_object() const
   {
-    if (type_ != Type::Object)
+    if (type() != Type::Object)
     {
       throw std::logic_error("Not an object");
     }
-    return std::get<object_t>(data_);
+    return std::get<ObjectNode>(data_).members;
   }
 
+  // Callers may mutate the returned container freely, even through a
+  // reference kept across later lookups, so handing it out stops key
+  // indexing for this node: lookups scan until reindex() is called.
   object_t &as_object()
   {
-    if (type_ != Type::Object)
+    if (type() != Type::Object)
     {
       throw std::logic_error("Not an object");
     }
-    return std::get<object_t>(data_);
+    auto &node = std::get<ObjectNode>(data_);
+    node.index.disable();
+    return node.members;
+  }
+
+  // Resume indexed lookups once edits through as_object() are finished;
+  // references obtained earlier must no longer be used to change keys.
+  void reindex()
+  {
+    if (auto *node = std::get_if<ObjectNode>(&data_))
+    {
+      node->index.reset();
+    }
   }
 
   JSON &push_back(JSON value)
@@ -241,15 +679,23 @@ public:
 
   JSON &operator[](std::string_view key)
   {
-    auto &obj = as_object();
-    for (auto &entry : obj)
+    if (type() != Type::Object)
     {
-      if (entry.first == key)
-      {
-        return entry.second;
-      }
+      throw std::logic_error("Not an object");
+    }
+    auto &node = std::get<ObjectNode>(data_);
+    auto &obj = node.members;
+    const size_t found = find_position(key);
+    if (found != npos)
+    {
+      return obj[found].second;
     }
     obj.emplace_back(std::string(key), JSON());
+    // Keep an existing index in step with the append instead of dropping it
+    if (KeyIndex *index = node.index.get())
+    {
+      index->insert(obj, obj.size() - 1);
+    }
     return obj.back().second;
   }
 
@@ -259,626 +705,3688 @@ public:
     {
       return nullptr;
     }
-    for (const auto &entry : std::get<object_t>(data_))
-    {
-      if (entry.first == key)
-      {
-        return &entry.second;
-      }
-    }
-    return nullptr;
+    const size_t found = find_position(key);
+    return found == npos ? nullptr : &std::get<ObjectNode>(data_).members[found].second;
   }
 
-  static bool parse(const std::string &text, JSON &out, JsonError *error = nullptr);
-  static JSON parse_or_throw(const std::string &text);
-  static bool validate(const std::string &text);
-
-  std::string stringify(const StringifyOptions &options = {}) const;
-
-private:
-  Type type_;
-  std::variant<std::monostate, bool, Number, std::string, array_t, object_t> data_;
-
-  JSON(Type type, std::variant<std::monostate, bool, Number, std::string, array_t, object_t> data) : type_(type), data_(std::move(data)) {}
+  // Objects with at least this many members get a hash index on first
+  // lookup; smaller ones are scanned linearly.
+  static constexpr size_t index_threshold = 32;
 
-  static std::string format_number(double value)
+  bool has_key_index() const
   {
-    std::ostringstream oss;
-    oss.setf(std::ios::fmtflags(0), std::ios::floatfield);
-    oss << std::setprecision(15) << value;
-    return oss.str();
+    const auto *node = std::get_if<ObjectNode>(&data_);
+    return node && node->index.get() != nullptr;
   }
 
-  static std::string escape_string(const std::string &input, bool escape_solidus);
-  static void stringify_impl(const JSON &node, const StringifyOptions &options, std::string &out, int depth);
-};
+  static bool parse(std::string_view text, JSON &out, JsonError *error = nullptr);
+  static bool parse(std::string_view text, JSON &out, const ParseOptions &options, JsonError *error = nullptr);
+  static JSON parse_or_throw(std::string_view text);
+  static bool validate(std::string_view text);
 
-class Parser
-{
-public:
-  explicit Parser(const std::string &text) : input(text) {}
+  std::string stringify(const StringifyOptions &options = {}) const;
 
-  bool parse(JSON &out)
+  // Compact binary encoding (CBOR, RFC 8949); object member order is preserved
+  std::string to_cbor() const;
+  void append_cbor(std::string &out) const;
+  static bool from_cbor(std::string_view data, JSON &out, JsonError *error = nullptr);
+  static bool from_cbor(std::string_view data, JSON &out, const ParseOptions &options, JsonError *error = nullptr);
+
+private:
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  /*
+   * Open-addressing table mapping key hashes to positions in object_t.
+   * Slots hold positions rather than pointers or views, so the table stays
+   * valid when the vector reallocates; every probe confirms the key against
+   * the vector itself. Only the first occurrence of a duplicated key is
+   * indexed, matching the linear scan.
+   */
+  class KeyIndex
   {
-    skip_ws();
-    if (!parse_value(out))
+  public:
+    KeyIndex() = default;
+    explicit KeyIndex(const object_t &obj)
     {
-      return false;
+      rehash(obj, obj.size());
     }
-    skip_ws();
-    if (pos != input.size())
+
+    size_t find(const object_t &obj, std::string_view key) const
     {
-      return fail("Trailing characters after JSON value");
+      const size_t mask = slots_.size() - 1;
+      for (size_t i = hash(key) & mask;; i = (i + 1) & mask)
+      {
+        const uint32_t slot = slots_[i];
+        if (slot == 0)
+        {
+          return npos;
+        }
+        if (obj[slot - 1].first == key)
+        {
+          return slot - 1;
+        }
+      }
     }
-    return true;
-  }
-
-  JsonError error;
-
-private:
-  const std::string &input;
-  size_t pos{0};
 
-  bool fail(std::string message)
-  {
-    error = {pos, std::move(message)};
-    return false;
-  }
+    void insert(const object_t &obj, size_t position)
+    {
+      if (obj.size() * 2 > slots_.size())
+      {
+        rehash(obj, obj.size());
+        return;
+      }
+      place(obj, position);
+    }
 
-  char peek() const
-  {
-    return pos < input.size() ? input[pos] : '\0';
-  }
+  private:
+    std::vector<uint32_t> slots_; // position + 1, 0 marks an empty slot
 
-  bool consume(char expected)
-  {
-    if (peek() != expected)
+    static size_t hash(std::string_view key)
     {
-      return false;
+      return std::hash<std::string_view>{}(key);
     }
-    ++pos;
-    return true;
-  }
 
-  void skip_ws()
-  {
-    while (pos < input.size() && std::isspace(static_cast<unsigned char>(input[pos])))
+    void place(const object_t &obj, size_t position)
     {
-      ++pos;
+      const std::string_view key = obj[position].first;
+      const size_t mask = slots_.size() - 1;
+      for (size_t i = hash(key) & mask;; i = (i + 1) & mask)
+      {
+        if (slots_[i] == 0)
+        {
+          slots_[i] = static_cast<uint32_t>(position + 1);
+          return;
+        }
+        if (obj[slots_[i] - 1].first == key)
+        {
+          return; // keep the earlier duplicate
+        }
+      }
     }
-  }
 
-  bool parse_value(JSON &out)
-  {
-    const char c = peek();
-    switch (c)
-    {
-    case 'n':
-      return parse_literal("null", JSON(std::nullptr_t{}), out);
-    case 't':
-      return parse_literal("true", JSON(true), out);
-    case 'f':
-      return parse_literal("false", JSON(false), out);
-    case '"':
+    void rehash(const object_t &obj, size_t count)
     {
-      std::string value;
-      if (!parse_string(value))
+      size_t capacity = 16;
+      while (capacity < count * 2 + 2)
       {
-        return false;
+        capacity <<= 1;
+      }
+      slots_.assign(capacity, 0);
+      for (size_t i = 0; i < count; ++i)
+      {
+        place(obj, i);
       }
-      out = JSON(std::move(value));
-      return true;
     }
-    case '{':
-      return parse_object(out);
-    case '[':
-      return parse_array(out);
-    default:
-      if (c == '-' || std::isdigit(static_cast<unsigned char>(c)))
+  };
+
+  /*
+   * Owning, lazily published pointer to a KeyIndex. Const lookups may build
+   * the index concurrently, so it is installed with a compare-exchange and
+   * the loser discards its copy. A disabled slot holds a shared marker
+   * instead, so the state costs no space. Copies of a node start without an
+   * index; moves carry it (or the marker) along with the container.
+   */
+  class KeyIndexSlot
+  {
+  public:
+    KeyIndexSlot() = default;
+    KeyIndexSlot(const KeyIndexSlot &) {}
+    KeyIndexSlot(KeyIndexSlot &&other) noexcept : ptr_(other.ptr_.exchange(nullptr)) {}
+    KeyIndexSlot &operator=(const KeyIndexSlot &other)
+    {
+      if (this != &other)
       {
-        return parse_number(out);
+        reset();
       }
-      return fail("Unexpected character while parsing value");
+      return *this;
     }
-  }
-
-  bool parse_literal(std::string_view literal, JSON value, JSON &out)
-  {
-    if (input.compare(pos, literal.size(), literal) != 0)
+    KeyIndexSlot &operator=(KeyIndexSlot &&other) noexcept
     {
-      return fail("Invalid literal");
+      if (this != &other)
+      {
+        dispose(ptr_.exchange(other.ptr_.exchange(nullptr)));
+      }
+      return *this;
+    }
+    ~KeyIndexSlot()
+    {
+      dispose(ptr_.load());
     }
-    pos += literal.size();
-    out = std::move(value);
-    return true;
-  }
 
-  static int hex_to_int(char c)
-  {
-    if (c >= '0' && c <= '9')
-      return c - '0';
-    if (c >= 'a' && c <= 'f')
-      return 10 + (c - 'a');
-    if (c >= 'A' && c <= 'F')
-      return 10 + (c - 'A');
-    return -1;
-  }
+    // The live index, or nullptr when none is built or indexing is disabled
+    KeyIndex *get() const
+    {
+      KeyIndex *index = ptr_.load(std::memory_order_acquire);
+      return index == disabled_marker() ? nullptr : index;
+    }
 
-  static bool append_codepoint(uint32_t codepoint, std::string &out)
-  {
-    if (codepoint <= 0x7F)
+    bool disabled() const
     {
-      out.push_back(static_cast<char>(codepoint));
-      return true;
+      return ptr_.load(std::memory_order_acquire) == disabled_marker();
     }
-    if (codepoint <= 0x7FF)
+
+    KeyIndex *publish(KeyIndex *index) const
     {
-      out.push_back(static_cast<char>(0xC0 | ((codepoint >> 6) & 0x1F)));
-      out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
-      return true;
+      KeyIndex *expected = nullptr;
+      if (ptr_.compare_exchange_strong(expected, index, std::memory_order_acq_rel))
+      {
+        return index;
+      }
+      delete index;
+      return expected == disabled_marker() ? nullptr : expected;
     }
-    if (codepoint <= 0xFFFF)
+
+    // Drop the index; the next lookup may build a fresh one
+    void reset()
     {
-      out.push_back(static_cast<char>(0xE0 | ((codepoint >> 12) & 0x0F)));
-      out.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
-      out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
-      return true;
+      dispose(ptr_.exchange(nullptr));
     }
-    if (codepoint <= 0x10FFFF)
+
+    // Drop the index and keep lookups on linear scans until reset()
+    void disable()
     {
-      out.push_back(static_cast<char>(0xF0 | ((codepoint >> 18) & 0x07)));
-      out.push_back(static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F)));
-      out.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
-      out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
-      return true;
+      dispose(ptr_.exchange(disabled_marker()));
     }
-    return false;
-  }
 
-  bool parse_unicode_escape(std::string &out)
-  {
-    if (pos + 4 > input.size())
+  private:
+    mutable std::atomic<KeyIndex *> ptr_{nullptr};
+
+    static KeyIndex *disabled_marker()
     {
-      return fail("Incomplete unicode escape");
+      static KeyIndex marker;
+      return &marker;
     }
 
-    uint32_t code_unit = 0;
-    for (int i = 0; i < 4; ++i)
+    static void dispose(KeyIndex *index)
     {
-      const int v = hex_to_int(input[pos + i]);
-      if (v < 0)
+      if (index != disabled_marker())
       {
-        return fail("Invalid hex in unicode escape");
+        delete index;
       }
-      code_unit = (code_unit << 4) | static_cast<uint32_t>(v);
     }
-    pos += 4;
+  };
 
-    if (code_unit >= 0xD800 && code_unit <= 0xDBFF)
+  /*
+   * String bytes allocated from a memory resource. It is smaller than a
+   * std::pmr::string (no inline buffer), which keeps a JSON node at 48
+   * bytes. Copies allocate from the default resource. str() serves
+   * JSON::as_string() from a heap std::string built on first use and
+   * published atomically, so concurrent readers of a const tree are safe.
+   */
+  class ResourceString
+  {
+  public:
+    ResourceString(std::string_view text, std::pmr::memory_resource *resource) : resource_(resource), size_(text.size())
     {
-      if (pos + 2 > input.size() || input[pos] != '\\' || input[pos + 1] != 'u')
-      {
-        return fail("Missing low surrogate for unicode escape");
-      }
-      pos += 2;
-      if (pos + 4 > input.size())
+      if (size_ > 0)
       {
-        return fail("Incomplete unicode escape");
+        data_ = static_cast<char *>(resource_->allocate(size_, 1));
+        std::memcpy(data_, text.data(), size_);
       }
-      uint32_t low = 0;
-      for (int i = 0; i < 4; ++i)
+    }
+    ResourceString(const ResourceString &other) : ResourceString(other.view(), std::pmr::get_default_resource()) {}
+    ResourceString(ResourceString &&other) noexcept
+        : resource_(other.resource_), data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)),
+          owned_(other.owned_.exchange(nullptr))
+    {
+    }
+    ResourceString &operator=(const ResourceString &other)
+    {
+      if (this != &other)
       {
-        const int v = hex_to_int(input[pos + i]);
-        if (v < 0)
-        {
-          return fail("Invalid hex in unicode escape");
-        }
-        low = (low << 4) | static_cast<uint32_t>(v);
+        *this = ResourceString(other);
       }
-      pos += 4;
-      if (low < 0xDC00 || low > 0xDFFF)
+      return *this;
+    }
+    ResourceString &operator=(ResourceString &&other) noexcept
+    {
+      if (this != &other)
       {
-        return fail("Invalid low surrogate in unicode escape");
+        release();
+        resource_ = other.resource_;
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        owned_.store(other.owned_.exchange(nullptr));
       }
-      const uint32_t codepoint = 0x10000 + (((code_unit - 0xD800) << 10) | (low - 0xDC00));
-      return append_codepoint(codepoint, out) ? true : fail("Invalid unicode codepoint");
+      return *this;
+    }
+    ~ResourceString()
+    {
+      release();
     }
 
-    return append_codepoint(code_unit, out) ? true : fail("Invalid unicode codepoint");
-  }
-
-  bool parse_string(std::string &out)
-  {
-    if (!consume('"'))
+    std::string_view view() const
     {
-      return fail("Expected opening quote for string");
+      return std::string_view(data_, size_);
     }
 
-    while (pos < input.size())
+    const std::string &str() const
     {
-      const char c = input[pos++];
-      if (c == '"')
-      {
-        return true;
-      }
-      if (static_cast<unsigned char>(c) < 0x20)
-      {
-        return fail("Control character in string");
-      }
-      if (c == '\\')
+      std::string *text = owned_.load(std::memory_order_acquire);
+      if (!text)
       {
-        if (pos >= input.size())
+        auto *built = new std::string(view());
+        if (owned_.compare_exchange_strong(text, built, std::memory_order_acq_rel))
         {
-          return fail("Unterminated escape sequence");
+          text = built;
         }
-        const char esc = input[pos++];
-        switch (esc)
+        else
         {
-        case '"':
-          out.push_back('"');
-          break;
-        case '\\':
-          out.push_back('\\');
-          break;
-        case '/':
-          out.push_back('/');
-          break;
-        case 'b':
-          out.push_back('\b');
-          break;
-        case 'f':
-          out.push_back('\f');
-          break;
-        case 'n':
-          out.push_back('\n');
-          break;
-        case 'r':
-          out.push_back('\r');
-          break;
-        case 't':
-          out.push_back('\t');
-          break;
-        case 'u':
-          if (!parse_unicode_escape(out))
-          {
-            return false;
-          }
-          break;
-        default:
-          return fail("Invalid escape sequence in string");
+          delete built;
         }
       }
-      else
-      {
-        out.push_back(c);
-      }
+      return *text;
     }
 
-    return fail("Unterminated string literal");
-  }
-
-  bool parse_number(JSON &out)
-  {
-    const size_t start = pos;
-    if (peek() == '-')
-    {
-      ++pos;
-    }
+  private:
+    std::pmr::memory_resource *resource_;
+    char *data_{nullptr};
+    size_t size_{0};
+    mutable std::atomic<std::string *> owned_{nullptr};
 
-    if (peek() == '0')
-    {
-      ++pos;
-    }
-    else if (std::isdigit(static_cast<unsigned char>(peek())))
+    void release()
     {
-      while (std::isdigit(static_cast<unsigned char>(peek())))
+      if (data_)
       {
-        ++pos;
+        resource_->deallocate(data_, size_, 1);
+        data_ = nullptr;
       }
+      delete owned_.exchange(nullptr);
     }
-    else
-    {
-      return fail("Invalid number format");
-    }
+  };
 
-    if (peek() == '.')
+  // Object members together with their lookup index
+  struct ObjectNode
+  {
+    object_t members;
+    KeyIndexSlot index;
+  };
+
+  using storage_t = std::variant<std::monostate, bool, Number, std::string, std::string_view, ResourceString, array_t, ObjectNode>;
+
+  storage_t data_;
+
+  size_t find_position(std::string_view key) const
+  {
+    const auto &node = std::get<ObjectNode>(data_);
+    const auto &obj = node.members;
+    if (obj.size() >= index_threshold && !node.index.disabled())
     {
-      ++pos;
-      if (!std::isdigit(static_cast<unsigned char>(peek())))
+      const KeyIndex *index = node.index.get();
+      if (!index)
       {
-        return fail("Invalid fraction in number");
+        index = node.index.publish(new KeyIndex(obj));
       }
-      while (std::isdigit(static_cast<unsigned char>(peek())))
+      if (index)
       {
-        ++pos;
+        return index->find(obj, key);
       }
     }
-
-    if (peek() == 'e' || peek() == 'E')
+    for (size_t i = 0; i < obj.size(); ++i)
     {
-      ++pos;
-      if (peek() == '+' || peek() == '-')
-      {
-        ++pos;
-      }
-      if (!std::isdigit(static_cast<unsigned char>(peek())))
-      {
-        return fail("Invalid exponent in number");
-      }
-      while (std::isdigit(static_cast<unsigned char>(peek())))
+      if (obj[i].first == key)
       {
-        ++pos;
+        return i;
       }
     }
+    return npos;
+  }
+
+  template <typename T> JSON(std::in_place_t, T &&data) : data_(std::forward<T>(data)) {}
+
+  friend class JsonWriter;
+
+  static void append_escaped(std::string &out, std::string_view input, bool escape_solidus);
+  static void stringify_impl(const JSON &node, const StringifyOptions &options, std::string &out, int depth);
+};
+
+// Escape and whitespace helpers shared by Parser and StreamingParser
+namespace detail
+{
+
+inline bool is_whitespace(char c)
+{
+  return std::isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+inline int hex_to_int(char c)
+{
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return 10 + (c - 'a');
+  if (c >= 'A' && c <= 'F')
+    return 10 + (c - 'A');
+  return -1;
+}
 
-    const std::string repr = input.substr(start, pos - start);
-    out = JSON::number(repr);
+// Decode a single-character escape (the character after the backslash).
+// Returns false for 'u' and for invalid escapes.
+inline bool decode_simple_escape(char esc, char &out)
+{
+  switch (esc)
+  {
+  case '"':
+    out = '"';
+    return true;
+  case '\\':
+    out = '\\';
     return true;
+  case '/':
+    out = '/';
+    return true;
+  case 'b':
+    out = '\b';
+    return true;
+  case 'f':
+    out = '\f';
+    return true;
+  case 'n':
+    out = '\n';
+    return true;
+  case 'r':
+    out = '\r';
+    return true;
+  case 't':
+    out = '\t';
+    return true;
+  default:
+    return false;
   }
+}
 
-  bool parse_array(JSON &out)
+inline bool append_codepoint(uint32_t codepoint, std::string &out)
+{
+  if (codepoint <= 0x7F)
   {
-    if (!consume('['))
-    {
-      return fail("Expected '[' to start array");
-    }
-    JSON::array_t elements;
-    skip_ws();
-    if (consume(']'))
-    {
-      out = JSON::array(std::move(elements));
-      return true;
-    }
+    out.push_back(static_cast<char>(codepoint));
+    return true;
+  }
+  if (codepoint <= 0x7FF)
+  {
+    out.push_back(static_cast<char>(0xC0 | ((codepoint >> 6) & 0x1F)));
+    out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    return true;
+  }
+  if (codepoint <= 0xFFFF)
+  {
+    out.push_back(static_cast<char>(0xE0 | ((codepoint >> 12) & 0x0F)));
+    out.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    return true;
+  }
+  if (codepoint <= 0x10FFFF)
+  {
+    out.push_back(static_cast<char>(0xF0 | ((codepoint >> 18) & 0x07)));
+    out.push_back(static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    return true;
+  }
+  return false;
+}
 
-    while (true)
+inline bool is_string_special(char c)
+{
+  return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20;
+}
+
+/**
+ * @brief Find the first quote, backslash, control character or @p extra in [first, last)
+ *
+ * Scans 32 (AVX2) or 16 (SSE2/NEON) bytes per step and finishes the tail one
+ * byte at a time. Pass '"' as @p extra when there is no additional character
+ * to stop at. Returns @p last when nothing matches.
+ */
+inline const char *find_string_special(const char *first, const char *last, char extra = '"')
+{
+#if defined(PIXELLIB_JSON_AVX2)
+  {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i other = _mm256_set1_epi8(extra);
+    const __m256i control_max = _mm256_set1_epi8(0x1F);
+    while (last - first >= 32)
     {
-      JSON value;
-      skip_ws();
-      if (!parse_value(value))
+      const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(first));
+      // max_epu8(v, 0x1F) == 0x1F exactly when v <= 0x1F (unsigned)
+      const __m256i hits = _mm256_or_si256(
+          _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash)),
+          _mm256_or_si256(_mm256_cmpeq_epi8(v, other), _mm256_cmpeq_epi8(_mm256_max_epu8(v, control_max), control_max)));
+      const auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(hits));
+      if (mask != 0)
       {
-        return false;
+        return first + std::countr_zero(mask);
       }
-      elements.push_back(std::move(value));
-      skip_ws();
-      if (consume(']'))
+      first += 32;
+    }
+  }
+#endif
+#if defined(PIXELLIB_JSON_SSE2)
+  {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i other = _mm_set1_epi8(extra);
+    const __m128i control_max = _mm_set1_epi8(0x1F);
+    while (last - first >= 16)
+    {
+      const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first));
+      const __m128i hits =
+          _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+                       _mm_or_si128(_mm_cmpeq_epi8(v, other), _mm_cmpeq_epi8(_mm_max_epu8(v, control_max), control_max)));
+      const auto mask = static_cast<uint32_t>(_mm_movemask_epi8(hits));
+      if (mask != 0)
       {
-        out = JSON::array(std::move(elements));
-        return true;
+        return first + std::countr_zero(mask);
       }
-      if (!consume(','))
+      first += 16;
+    }
+  }
+#elif defined(PIXELLIB_JSON_NEON)
+  {
+    const uint8x16_t quote = vdupq_n_u8('"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    const uint8x16_t other = vdupq_n_u8(static_cast<uint8_t>(extra));
+    const uint8x16_t control_end = vdupq_n_u8(0x20);
+    while (last - first >= 16)
+    {
+      const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(first));
+      const uint8x16_t hits = vorrq_u8(vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, backslash)),
+                                       vorrq_u8(vceqq_u8(v, other), vcltq_u8(v, control_end)));
+      if (vmaxvq_u8(hits) != 0)
       {
-        return fail("Expected ',' between array elements");
+        break; // the scalar loop below locates the byte within this block
       }
-      skip_ws();
+      first += 16;
     }
   }
+#endif
+  while (first != last && !is_string_special(*first) && *first != extra)
+  {
+    ++first;
+  }
+  return first;
+}
 
-  bool parse_object(JSON &out)
+class QueryScanner;
+
+} // namespace detail
+
+class Parser
+{
+  friend class detail::QueryScanner;
+
+public:
+  explicit Parser(std::string_view text, ParseOptions opts = {})
+      : input(text), options(opts), resource(opts.resource ? opts.resource : std::pmr::get_default_resource())
+  {
+  }
+
+  bool parse(JSON &out)
+  {
+    skip_ws();
+    if (!parse_value(out))
+    {
+      return false;
+    }
+    skip_ws();
+    if (pos != input.size())
+    {
+      return fail("Trailing characters after JSON value");
+    }
+    return true;
+  }
+
+  JsonError error;
+
+private:
+  std::string_view input;
+  ParseOptions options;
+  std::pmr::memory_resource *resource;
+  size_t pos{0};
+  std::string scratch_; // decode buffer for keys, and for strings copied into resource
+
+  bool fail(std::string message)
+  {
+    error = {pos, std::move(message)};
+    return false;
+  }
+
+  char peek() const
+  {
+    return pos < input.size() ? input[pos] : '\0';
+  }
+
+  bool consume(char expected)
+  {
+    if (peek() != expected)
+    {
+      return false;
+    }
+    ++pos;
+    return true;
+  }
+
+  void skip_ws()
+  {
+    while (pos < input.size() && detail::is_whitespace(input[pos]))
+    {
+      ++pos;
+    }
+  }
+
+  bool parse_value(JSON &out)
+  {
+    const char c = peek();
+    switch (c)
+    {
+    case 'n':
+      return parse_literal("null", JSON(std::nullptr_t{}), out);
+    case 't':
+      return parse_literal("true", JSON(true), out);
+    case 'f':
+      return parse_literal("false", JSON(false), out);
+    case '"':
+      return parse_string_value(out);
+    case '{':
+      return parse_object(out);
+    case '[':
+      return parse_array(out);
+    default:
+      if (c == '-' || std::isdigit(static_cast<unsigned char>(c)))
+      {
+        return parse_number(out);
+      }
+      return fail("Unexpected character while parsing value");
+    }
+  }
+
+  bool parse_literal(std::string_view literal, JSON value, JSON &out)
+  {
+    if (input.compare(pos, literal.size(), literal) != 0)
+    {
+      return fail("Invalid literal");
+    }
+    pos += literal.size();
+    out = std::move(value);
+    return true;
+  }
+
+  bool parse_unicode_escape(std::string &out)
+  {
+    if (pos + 4 > input.size())
+    {
+      return fail("Incomplete unicode escape");
+    }
+
+    uint32_t code_unit = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+      const int v = detail::hex_to_int(input[pos + i]);
+      if (v < 0)
+      {
+        return fail("Invalid hex in unicode escape");
+      }
+      code_unit = (code_unit << 4) | static_cast<uint32_t>(v);
+    }
+    pos += 4;
+
+    if (code_unit >= 0xD800 && code_unit <= 0xDBFF)
+    {
+      if (pos + 2 > input.size() || input[pos] != '\\' || input[pos + 1] != 'u')
+      {
+        return fail("Missing low surrogate for unicode escape");
+      }
+      pos += 2;
+      if (pos + 4 > input.size())
+      {
+        return fail("Incomplete unicode escape");
+      }
+      uint32_t low = 0;
+      for (int i = 0; i < 4; ++i)
+      {
+        const int v = detail::hex_to_int(input[pos + i]);
+        if (v < 0)
+        {
+          return fail("Invalid hex in unicode escape");
+        }
+        low = (low << 4) | static_cast<uint32_t>(v);
+      }
+      pos += 4;
+      if (low < 0xDC00 || low > 0xDFFF)
+      {
+        return fail("Invalid low surrogate in unicode escape");
+      }
+      const uint32_t codepoint = 0x10000 + (((code_unit - 0xD800) << 10) | (low - 0xDC00));
+      return detail::append_codepoint(codepoint, out) ? true : fail("Invalid unicode codepoint");
+    }
+
+    return detail::append_codepoint(code_unit, out) ? true : fail("Invalid unicode codepoint");
+  }
+
+  // Index of the first quote, backslash or control character at or after from
+  size_t scan_string_run(size_t from) const
+  {
+    const char *base = input.data();
+    return static_cast<size_t>(detail::find_string_special(base + from, base + input.size()) - base);
+  }
+
+  bool parse_string_value(JSON &out)
+  {
+    if (!consume('"'))
+    {
+      return fail("Expected opening quote for string");
+    }
+
+    const size_t start = pos;
+    const size_t run_end = scan_string_run(start);
+    if (options.borrow && run_end < input.size() && input[run_end] == '"')
+    {
+      // Escape-free string: reference the input directly
+      pos = run_end + 1;
+      out = JSON::borrowed_string(input.substr(start, run_end - start));
+      return true;
+    }
+
+    if (options.resource)
+    {
+      scratch_.assign(input.substr(start, run_end - start));
+      pos = run_end;
+      if (!parse_string_tail(scratch_))
+      {
+        return false;
+      }
+      out = JSON::string(scratch_, resource);
+      return true;
+    }
+    std::string value(input.substr(start, run_end - start));
+    pos = run_end;
+    if (!parse_string_tail(value))
+    {
+      return false;
+    }
+    out = JSON(std::move(value));
+    return true;
+  }
+
+  bool parse_string(std::string &out)
+  {
+    if (!consume('"'))
+    {
+      return fail("Expected opening quote for string");
+    }
+    return parse_string_tail(out);
+  }
+
+  // Parse the remainder of a string whose opening quote has been consumed.
+  // Unescaped runs are appended in bulk rather than one character at a time.
+  bool parse_string_tail(std::string &out)
+  {
+    while (pos < input.size())
+    {
+      const size_t run_end = scan_string_run(pos);
+      out.append(input.data() + pos, run_end - pos);
+      pos = run_end;
+      if (pos >= input.size())
+      {
+        break;
+      }
+
+      const char c = input[pos++];
+      if (c == '"')
+      {
+        return true;
+      }
+      if (static_cast<unsigned char>(c) < 0x20)
+      {
+        return fail("Control character in string");
+      }
+      if (c == '\\')
+      {
+        if (pos >= input.size())
+        {
+          return fail("Unterminated escape sequence");
+        }
+        const char esc = input[pos++];
+        char decoded = 0;
+        if (detail::decode_simple_escape(esc, decoded))
+        {
+          out.push_back(decoded);
+        }
+        else if (esc == 'u')
+        {
+          if (!parse_unicode_escape(out))
+          {
+            return false;
+          }
+        }
+        else
+        {
+          return fail("Invalid escape sequence in string");
+        }
+      }
+    }
+
+    return fail("Unterminated string literal");
+  }
+
+  bool parse_number(JSON &out)
+  {
+    const size_t start = pos;
+    if (!scan_number())
+    {
+      return false;
+    }
+    const std::string_view repr = input.substr(start, pos - start);
+    out = options.borrow ? JSON::borrowed_number(repr) : JSON::number(repr);
+    return true;
+  }
+
+  // Advance over a number, checking the grammar without converting it
+  bool scan_number()
+  {
+    if (peek() == '-')
+    {
+      ++pos;
+    }
+
+    if (peek() == '0')
+    {
+      ++pos;
+    }
+    else if (std::isdigit(static_cast<unsigned char>(peek())))
+    {
+      while (std::isdigit(static_cast<unsigned char>(peek())))
+      {
+        ++pos;
+      }
+    }
+    else
+    {
+      return fail("Invalid number format");
+    }
+
+    if (peek() == '.')
+    {
+      ++pos;
+      if (!std::isdigit(static_cast<unsigned char>(peek())))
+      {
+        return fail("Invalid fraction in number");
+      }
+      while (std::isdigit(static_cast<unsigned char>(peek())))
+      {
+        ++pos;
+      }
+    }
+
+    if (peek() == 'e' || peek() == 'E')
+    {
+      ++pos;
+      if (peek() == '+' || peek() == '-')
+      {
+        ++pos;
+      }
+      if (!std::isdigit(static_cast<unsigned char>(peek())))
+      {
+        return fail("Invalid exponent in number");
+      }
+      while (std::isdigit(static_cast<unsigned char>(peek())))
+      {
+        ++pos;
+      }
+    }
+    return true;
+  }
+
+  // Skip mode: validate a value and advance past it without building anything
+  bool skip_value()
+  {
+    const char c = peek();
+    switch (c)
+    {
+    case 'n':
+      return skip_literal("null");
+    case 't':
+      return skip_literal("true");
+    case 'f':
+      return skip_literal("false");
+    case '"':
+      return skip_string();
+    case '{':
+      return skip_container('}');
+    case '[':
+      return skip_container(']');
+    default:
+      if (c == '-' || std::isdigit(static_cast<unsigned char>(c)))
+      {
+        return scan_number();
+      }
+      return fail("Unexpected character while parsing value");
+    }
+  }
+
+  bool skip_literal(std::string_view literal)
+  {
+    if (input.compare(pos, literal.size(), literal) != 0)
+    {
+      return fail("Invalid literal");
+    }
+    pos += literal.size();
+    return true;
+  }
+
+  bool skip_string()
+  {
+    if (!consume('"'))
+    {
+      return fail("Expected opening quote for string");
+    }
+    while (true)
+    {
+      pos = scan_string_run(pos);
+      if (pos >= input.size())
+      {
+        return fail("Unterminated string literal");
+      }
+      const char c = input[pos++];
+      if (c == '"')
+      {
+        return true;
+      }
+      if (c != '\\')
+      {
+        return fail("Control character in string");
+      }
+      if (pos >= input.size())
+      {
+        return fail("Unterminated escape sequence");
+      }
+      const char esc = input[pos++];
+      char decoded = 0;
+      if (esc == 'u')
+      {
+        // Surrogate pairing rules are shared with the decoding path
+        std::string scratch;
+        if (!parse_unicode_escape(scratch))
+        {
+          return false;
+        }
+      }
+      else if (!detail::decode_simple_escape(esc, decoded))
+      {
+        return fail("Invalid escape sequence in string");
+      }
+    }
+  }
+
+  bool skip_container(char close)
+  {
+    const bool object = close == '}';
+    ++pos;
+    skip_ws();
+    if (consume(close))
+    {
+      return true;
+    }
+    while (true)
+    {
+      skip_ws();
+      if (object)
+      {
+        if (!skip_string())
+        {
+          return false;
+        }
+        skip_ws();
+        if (!consume(':'))
+        {
+          return fail("Expected ':' after object key");
+        }
+        skip_ws();
+      }
+      if (!skip_value())
+      {
+        return false;
+      }
+      skip_ws();
+      if (consume(close))
+      {
+        return true;
+      }
+      if (!consume(','))
+      {
+        return fail(object ? "Expected ',' between object members" : "Expected ',' between array elements");
+      }
+    }
+  }
+
+  bool parse_array(JSON &out)
+  {
+    if (!consume('['))
+    {
+      return fail("Expected '[' to start array");
+    }
+    JSON::array_t elements(resource);
+    skip_ws();
+    if (consume(']'))
+    {
+      out = JSON::array(std::move(elements));
+      return true;
+    }
+
+    while (true)
+    {
+      JSON value;
+      skip_ws();
+      if (!parse_value(value))
+      {
+        return false;
+      }
+      elements.push_back(std::move(value));
+      skip_ws();
+      if (consume(']'))
+      {
+        out = JSON::array(std::move(elements));
+        return true;
+      }
+      if (!consume(','))
+      {
+        return fail("Expected ',' between array elements");
+      }
+      skip_ws();
+    }
+  }
+
+  bool parse_object(JSON &out)
   {
     if (!consume('{'))
     {
-      return fail("Expected '{' to start object");
+      return fail("Expected '{' to start object");
+    }
+    JSON::object_t members(resource);
+    skip_ws();
+    if (consume('}'))
+    {
+      out = JSON::object(std::move(members));
+      return true;
+    }
+
+    while (true)
+    {
+      skip_ws();
+      scratch_.clear();
+      if (!parse_string(scratch_))
+      {
+        return false;
+      }
+      JSON::object_key_t key(scratch_, resource);
+      skip_ws();
+      if (!consume(':'))
+      {
+        return fail("Expected ':' after object key");
+      }
+      skip_ws();
+      JSON value;
+      if (!parse_value(value))
+      {
+        return false;
+      }
+      members.emplace_back(std::move(key), std::move(value));
+      skip_ws();
+      if (consume('}'))
+      {
+        out = JSON::object(std::move(members));
+        return true;
+      }
+      if (!consume(','))
+      {
+        return fail("Expected ',' between object members");
+      }
+      skip_ws();
+    }
+  }
+};
+
+/**
+ * @brief SAX-style callbacks invoked by StreamingParser
+ *
+ * Every callback returns true to continue or false to stop parsing (the
+ * parser then fails with "Parsing cancelled by handler"). String, key and
+ * number views are only valid for the duration of the callback; copy them if
+ * they need to be kept. Numbers are reported as their source text.
+ */
+class JsonHandler
+{
+public:
+  virtual ~JsonHandler() = default;
+
+  virtual bool on_null()
+  {
+    return true;
+  }
+
+  virtual bool on_bool(bool)
+  {
+    return true;
+  }
+
+  virtual bool on_number(std::string_view)
+  {
+    return true;
+  }
+
+  virtual bool on_string(std::string_view)
+  {
+    return true;
+  }
+
+  virtual bool on_key(std::string_view)
+  {
+    return true;
+  }
+
+  virtual bool on_start_object()
+  {
+    return true;
+  }
+
+  virtual bool on_end_object()
+  {
+    return true;
+  }
+
+  virtual bool on_start_array()
+  {
+    return true;
+  }
+
+  virtual bool on_end_array()
+  {
+    return true;
+  }
+
+  // Called after each complete top-level value
+  virtual bool on_document_end()
+  {
+    return true;
+  }
+};
+
+/**
+ * @brief Incremental JSON parser that accepts input in arbitrary chunks
+ *
+ * Input is driven through a byte-level state machine, so a value may be split
+ * anywhere (even inside an escape sequence) across feed() calls. Strings and
+ * numbers that start and end within one chunk are reported as views into that
+ * chunk; only tokens that straddle a chunk boundary or contain escapes are
+ * copied into an internal buffer that is reused between tokens.
+ *
+ * Without a handler the parser only checks the grammar and never decodes or
+ * buffers anything; JSON::validate() uses it that way. With multiple_values
+ * set, any number of whitespace-separated top-level values are accepted
+ * (NDJSON / JSON Lines), each followed by JsonHandler::on_document_end();
+ * a value that starts right after the previous one ("1{}", "truefalse") is
+ * an error.
+ *
+ * Error positions are byte offsets from the start of the whole stream.
+ */
+class StreamingParser
+{
+public:
+  explicit StreamingParser(JsonHandler *handler = nullptr, bool multiple_values = false)
+      : handler_(handler), multiple_values_(multiple_values)
+  {
+  }
+
+  // Parse the next chunk; returns false once the stream is known to be invalid
+  bool feed(std::string_view chunk);
+
+  // Signal end of input; fails if the stream ends inside a value
+  bool finish();
+
+  // Prepare for a new stream, keeping the handler and buffers
+  void reset()
+  {
+    state_ = State::Start;
+    escape_ = Escape::None;
+    stack_.clear();
+    token_.clear();
+    consumed_ = 0;
+    values_ = 0;
+    error_ = {};
+  }
+
+  bool failed() const
+  {
+    return state_ == State::Failed;
+  }
+
+  const JsonError &error() const
+  {
+    return error_;
+  }
+
+  // Number of complete top-level values seen so far
+  size_t values() const
+  {
+    return values_;
+  }
+
+private:
+  enum class State : uint8_t
+  {
+    Start,       // top level, before a value
+    Done,        // top level, after the only value
+    Separator,   // top level, after a value of a multi-value stream, before whitespace
+    Value,       // after ',' in an array or ':' in an object
+    ArrayFirst,  // after '['
+    ObjectFirst, // after '{'
+    Key,         // after ',' in an object
+    Colon,       // after an object key
+    AfterValue,  // after a value inside a container
+    String,
+    Number,
+    Literal,
+    Failed
+  };
+
+  enum class Escape : uint8_t
+  {
+    None,
+    Backslash,    // after '\'
+    Hex,          // inside \uXXXX
+    LowBackslash, // after a high surrogate, expecting '\'
+    LowU,         // after a high surrogate and '\', expecting 'u'
+    LowHex        // inside the low surrogate's XXXX
+  };
+
+  enum class NumberState : uint8_t
+  {
+    Sign,     // after '-'
+    Zero,     // after a leading '0'
+    Int,      // inside the integer part
+    Dot,      // after '.'
+    Frac,     // inside the fraction
+    Exp,      // after 'e' / 'E'
+    ExpSign,  // after the exponent sign
+    ExpDigits // inside the exponent
+  };
+
+  JsonHandler *handler_;
+  bool multiple_values_;
+  State state_{State::Start};
+  Escape escape_{Escape::None};
+  NumberState number_{NumberState::Int};
+  bool in_key_{false};
+  // Open containers as '{' / '['; a string keeps shallow documents allocation-free
+  std::string stack_;
+  std::string token_;
+  std::string_view chunk_;
+  size_t token_start_{0}; // start of the unbuffered part of the token in chunk_
+  size_t token_offset_{0};
+  size_t consumed_{0};
+  size_t values_{0};
+  std::string_view literal_;
+  size_t literal_pos_{0};
+  uint32_t code_unit_{0};
+  uint32_t high_surrogate_{0};
+  int hex_count_{0};
+  JsonError error_;
+
+  size_t offset(size_t i) const
+  {
+    return consumed_ + i;
+  }
+
+  bool fail(const char *message, size_t position)
+  {
+    state_ = State::Failed;
+    error_ = {position, message};
+    return false;
+  }
+
+  bool cancelled(size_t i)
+  {
+    return fail("Parsing cancelled by handler", offset(i));
+  }
+
+  bool value_complete(size_t i)
+  {
+    if (!stack_.empty())
+    {
+      state_ = State::AfterValue;
+      return true;
+    }
+    ++values_;
+    state_ = multiple_values_ ? State::Separator : State::Done;
+    return !handler_ || handler_->on_document_end() || cancelled(i);
+  }
+
+  bool begin_value(char c, size_t &i)
+  {
+    switch (c)
+    {
+    case '{':
+      ++i;
+      stack_.push_back('{');
+      state_ = State::ObjectFirst;
+      return !handler_ || handler_->on_start_object() || cancelled(i);
+    case '[':
+      ++i;
+      stack_.push_back('[');
+      state_ = State::ArrayFirst;
+      return !handler_ || handler_->on_start_array() || cancelled(i);
+    case '"':
+      ++i;
+      begin_string(false, i);
+      return true;
+    case 'n':
+      return begin_literal("null", i);
+    case 't':
+      return begin_literal("true", i);
+    case 'f':
+      return begin_literal("false", i);
+    default:
+      if (c == '-' || (c >= '0' && c <= '9'))
+      {
+        state_ = State::Number;
+        number_ = c == '-' ? NumberState::Sign : (c == '0' ? NumberState::Zero : NumberState::Int);
+        token_start_ = i++;
+        return true;
+      }
+      return fail("Unexpected character while parsing value", offset(i));
+    }
+  }
+
+  bool begin_literal(std::string_view literal, size_t &i)
+  {
+    state_ = State::Literal;
+    literal_ = literal;
+    literal_pos_ = 1;
+    token_offset_ = offset(i++);
+    return true;
+  }
+
+  void begin_string(bool key, size_t i)
+  {
+    state_ = State::String;
+    escape_ = Escape::None;
+    in_key_ = key;
+    token_start_ = i;
+  }
+
+  bool close_container(size_t i)
+  {
+    const bool object = stack_.back() == '{';
+    stack_.pop_back();
+    if (handler_ && !(object ? handler_->on_end_object() : handler_->on_end_array()))
+    {
+      return cancelled(i);
+    }
+    return value_complete(i);
+  }
+
+  bool structural_step(char c, size_t &i)
+  {
+    switch (state_)
+    {
+    case State::ArrayFirst:
+      if (c == ']')
+      {
+        return close_container(++i);
+      }
+      return begin_value(c, i);
+    case State::Start:
+    case State::Value:
+      return begin_value(c, i);
+    case State::ObjectFirst:
+      if (c == '}')
+      {
+        return close_container(++i);
+      }
+      [[fallthrough]];
+    case State::Key:
+      if (c != '"')
+      {
+        return fail("Expected opening quote for string", offset(i));
+      }
+      begin_string(true, ++i);
+      return true;
+    case State::Colon:
+      if (c != ':')
+      {
+        return fail("Expected ':' after object key", offset(i));
+      }
+      ++i;
+      state_ = State::Value;
+      return true;
+    case State::AfterValue:
+    {
+      const bool object = stack_.back() == '{';
+      if (c == ',')
+      {
+        ++i;
+        state_ = object ? State::Key : State::Value;
+        return true;
+      }
+      if (c == (object ? '}' : ']'))
+      {
+        return close_container(++i);
+      }
+      return fail(object ? "Expected ',' between object members" : "Expected ',' between array elements", offset(i));
+    }
+    case State::Separator:
+      return fail("Expected whitespace between top-level values", offset(i));
+    default:
+      return fail("Trailing characters after JSON value", offset(i));
+    }
+  }
+
+  bool literal_step(char c, size_t &i)
+  {
+    if (c != literal_[literal_pos_])
+    {
+      return fail("Invalid literal", token_offset_);
+    }
+    ++i;
+    if (++literal_pos_ < literal_.size())
+    {
+      return true;
+    }
+    if (handler_)
+    {
+      const bool ok = literal_[0] == 'n' ? handler_->on_null() : handler_->on_bool(literal_[0] == 't');
+      if (!ok)
+      {
+        return cancelled(i);
+      }
+    }
+    return value_complete(i);
+  }
+
+  bool string_step(size_t &i)
+  {
+    const std::string_view chunk = chunk_;
+    while (i < chunk.size())
+    {
+      if (escape_ != Escape::None)
+      {
+        if (!escape_step(chunk[i], i))
+        {
+          return false;
+        }
+        token_start_ = ++i;
+        continue;
+      }
+
+      i = static_cast<size_t>(detail::find_string_special(chunk.data() + i, chunk.data() + chunk.size()) - chunk.data());
+      if (i == chunk.size())
+      {
+        return true;
+      }
+
+      const char c = chunk[i];
+      if (c == '"')
+      {
+        std::string_view value;
+        if (handler_)
+        {
+          if (token_.empty())
+          {
+            value = chunk.substr(token_start_, i - token_start_);
+          }
+          else
+          {
+            token_.append(chunk.data() + token_start_, i - token_start_);
+            value = token_;
+          }
+        }
+        return end_string(value, ++i);
+      }
+      if (c != '\\')
+      {
+        return fail("Control character in string", offset(i));
+      }
+      if (handler_)
+      {
+        token_.append(chunk.data() + token_start_, i - token_start_);
+      }
+      escape_ = Escape::Backslash;
+      ++i;
+    }
+    return true;
+  }
+
+  bool end_string(std::string_view value, size_t i)
+  {
+    const bool key = in_key_;
+    state_ = key ? State::Colon : State::AfterValue;
+    if (handler_)
+    {
+      const bool ok = key ? handler_->on_key(value) : handler_->on_string(value);
+      token_.clear();
+      if (!ok)
+      {
+        return cancelled(i);
+      }
+    }
+    return key || value_complete(i);
+  }
+
+  bool escape_step(char c, size_t i)
+  {
+    switch (escape_)
+    {
+    case Escape::Backslash:
+    {
+      if (c == 'u')
+      {
+        escape_ = Escape::Hex;
+        code_unit_ = 0;
+        hex_count_ = 0;
+        return true;
+      }
+      char decoded = 0;
+      if (!detail::decode_simple_escape(c, decoded))
+      {
+        return fail("Invalid escape sequence in string", offset(i));
+      }
+      if (handler_)
+      {
+        token_.push_back(decoded);
+      }
+      escape_ = Escape::None;
+      return true;
+    }
+    case Escape::LowBackslash:
+      if (c != '\\')
+      {
+        return fail("Missing low surrogate for unicode escape", offset(i));
+      }
+      escape_ = Escape::LowU;
+      return true;
+    case Escape::LowU:
+      if (c != 'u')
+      {
+        return fail("Missing low surrogate for unicode escape", offset(i));
+      }
+      escape_ = Escape::LowHex;
+      code_unit_ = 0;
+      hex_count_ = 0;
+      return true;
+    default:
+      break;
+    }
+
+    const int v = detail::hex_to_int(c);
+    if (v < 0)
+    {
+      return fail("Invalid hex in unicode escape", offset(i));
+    }
+    code_unit_ = (code_unit_ << 4) | static_cast<uint32_t>(v);
+    if (++hex_count_ < 4)
+    {
+      return true;
+    }
+
+    uint32_t codepoint = code_unit_;
+    if (escape_ == Escape::Hex && code_unit_ >= 0xD800 && code_unit_ <= 0xDBFF)
+    {
+      high_surrogate_ = code_unit_;
+      escape_ = Escape::LowBackslash;
+      return true;
+    }
+    if (escape_ == Escape::LowHex)
+    {
+      if (code_unit_ < 0xDC00 || code_unit_ > 0xDFFF)
+      {
+        return fail("Invalid low surrogate in unicode escape", offset(i));
+      }
+      codepoint = 0x10000 + (((high_surrogate_ - 0xD800) << 10) | (code_unit_ - 0xDC00));
+    }
+    escape_ = Escape::None;
+    if (handler_ && !detail::append_codepoint(codepoint, token_))
+    {
+      return fail("Invalid unicode codepoint", offset(i));
+    }
+    return true;
+  }
+
+  bool number_step(size_t &i)
+  {
+    const std::string_view chunk = chunk_;
+    for (; i < chunk.size(); ++i)
+    {
+      const char c = chunk[i];
+      const bool digit = c >= '0' && c <= '9';
+      const bool exponent = c == 'e' || c == 'E';
+      switch (number_)
+      {
+      case NumberState::Sign:
+        if (!digit)
+        {
+          return fail("Invalid number format", offset(i));
+        }
+        number_ = c == '0' ? NumberState::Zero : NumberState::Int;
+        break;
+      case NumberState::Zero:
+      case NumberState::Int:
+        if (digit && number_ == NumberState::Int)
+        {
+          break;
+        }
+        if (c == '.')
+        {
+          number_ = NumberState::Dot;
+        }
+        else if (exponent)
+        {
+          number_ = NumberState::Exp;
+        }
+        else
+        {
+          return end_number(i);
+        }
+        break;
+      case NumberState::Dot:
+        if (!digit)
+        {
+          return fail("Invalid fraction in number", offset(i));
+        }
+        number_ = NumberState::Frac;
+        break;
+      case NumberState::Frac:
+        if (exponent)
+        {
+          number_ = NumberState::Exp;
+        }
+        else if (!digit)
+        {
+          return end_number(i);
+        }
+        break;
+      case NumberState::Exp:
+        if (c == '+' || c == '-')
+        {
+          number_ = NumberState::ExpSign;
+          break;
+        }
+        [[fallthrough]];
+      case NumberState::ExpSign:
+        if (!digit)
+        {
+          return fail("Invalid exponent in number", offset(i));
+        }
+        number_ = NumberState::ExpDigits;
+        break;
+      case NumberState::ExpDigits:
+        if (!digit)
+        {
+          return end_number(i);
+        }
+        break;
+      }
+    }
+    return true;
+  }
+
+  // Emit the number ending just before chunk_[i]; the byte at i is not consumed
+  bool end_number(size_t i)
+  {
+    switch (number_)
+    {
+    case NumberState::Sign:
+      return fail("Invalid number format", offset(i));
+    case NumberState::Dot:
+      return fail("Invalid fraction in number", offset(i));
+    case NumberState::Exp:
+    case NumberState::ExpSign:
+      return fail("Invalid exponent in number", offset(i));
+    default:
+      break;
+    }
+    if (handler_)
+    {
+      std::string_view repr;
+      if (token_.empty())
+      {
+        repr = chunk_.substr(token_start_, i - token_start_);
+      }
+      else
+      {
+        token_.append(chunk_.data() + token_start_, i - token_start_);
+        repr = token_;
+      }
+      const bool ok = handler_->on_number(repr);
+      token_.clear();
+      if (!ok)
+      {
+        return cancelled(i);
+      }
+    }
+    return value_complete(i);
+  }
+};
+
+inline bool StreamingParser::feed(std::string_view chunk)
+{
+  if (state_ == State::Failed)
+  {
+    return false;
+  }
+
+  chunk_ = chunk;
+  token_start_ = 0;
+  size_t i = 0;
+  bool ok = true;
+  while (ok && i < chunk.size())
+  {
+    switch (state_)
+    {
+    case State::String:
+      ok = string_step(i);
+      break;
+    case State::Number:
+      ok = number_step(i);
+      break;
+    case State::Literal:
+      ok = literal_step(chunk[i], i);
+      break;
+    default:
+      if (detail::is_whitespace(chunk[i]))
+      {
+        if (state_ == State::Separator)
+        {
+          state_ = State::Start;
+        }
+        ++i;
+      }
+      else
+      {
+        ok = structural_step(chunk[i], i);
+      }
+      break;
+    }
+  }
+
+  // Carry the unfinished part of a token over to the next chunk
+  if (ok && handler_ && (state_ == State::String || state_ == State::Number) && escape_ == Escape::None)
+  {
+    token_.append(chunk.data() + token_start_, chunk.size() - token_start_);
+  }
+  consumed_ += chunk.size();
+  chunk_ = {};
+  return ok;
+}
+
+inline bool StreamingParser::finish()
+{
+  if (state_ == State::Failed)
+  {
+    return false;
+  }
+
+  chunk_ = {};
+  token_start_ = 0;
+  if (state_ == State::Number && !end_number(0))
+  {
+    return false;
+  }
+
+  const size_t end = consumed_;
+  switch (state_)
+  {
+  case State::Done:
+  case State::Separator:
+    return true;
+  case State::Start:
+    return values_ > 0 || fail("Unexpected character while parsing value", end);
+  case State::Value:
+  case State::ArrayFirst:
+    return fail("Unexpected character while parsing value", end);
+  case State::ObjectFirst:
+  case State::Key:
+    return fail("Expected opening quote for string", end);
+  case State::Colon:
+    return fail("Expected ':' after object key", end);
+  case State::AfterValue:
+    return fail(stack_.back() == '{' ? "Expected ',' between object members" : "Expected ',' between array elements",
+                end);
+  case State::Literal:
+    return fail("Invalid literal", token_offset_);
+  case State::String:
+    switch (escape_)
+    {
+    case Escape::None:
+      return fail("Unterminated string literal", end);
+    case Escape::Backslash:
+      return fail("Unterminated escape sequence", end);
+    case Escape::LowBackslash:
+    case Escape::LowU:
+      return fail("Missing low surrogate for unicode escape", end);
+    default:
+      return fail("Incomplete unicode escape", end);
+    }
+  default:
+    return false;
+  }
+}
+
+inline bool JSON::parse(std::string_view text, JSON &out, JsonError *error)
+{
+  return parse(text, out, ParseOptions{}, error);
+}
+
+inline bool JSON::parse(std::string_view text, JSON &out, const ParseOptions &options, JsonError *error)
+{
+  Parser parser(text, options);
+  const bool ok = parser.parse(out);
+  if (!ok && error)
+  {
+    *error = parser.error;
+  }
+  return ok;
+}
+
+inline JSON JSON::parse_or_throw(std::string_view text)
+{
+  JSON value;
+  JsonError err;
+  if (!parse(text, value, &err))
+  {
+    std::ostringstream oss;
+    oss << "JSON parse error at position " << err.position << ": " << err.message;
+    throw std::invalid_argument(oss.str());
+  }
+  return value;
+}
+
+inline bool JSON::validate(std::string_view text)
+{
+  // Grammar check only: no DOM, no decoded strings
+  StreamingParser parser;
+  return parser.feed(text) && parser.finish();
+}
+
+inline void JSON::materialize()
+{
+  switch (type())
+  {
+  case Type::String:
+    if (const auto *view = std::get_if<std::string_view>(&data_))
+    {
+      data_ = std::string(*view);
+    }
+    return;
+  case Type::Number:
+  {
+    std::get<Number>(data_).materialize();
+    return;
+  }
+  case Type::Array:
+    for (auto &element : std::get<array_t>(data_))
+    {
+      element.materialize();
+    }
+    return;
+  case Type::Object:
+    for (auto &member : std::get<ObjectNode>(data_).members)
+    {
+      member.second.materialize();
+    }
+    return;
+  default:
+    return;
+  }
+}
+
+/**
+ * @brief A JSON tree together with the monotonic arena it is allocated from
+ *
+ * Every array and object container is bump-allocated from the arena, and
+ * the whole tree is released at once when the document is destroyed or
+ * re-parsed. Keeping the arena and the root in one object ensures the arena
+ * cannot be freed while nodes still point into it; copy nodes out (copies
+ * use the global heap) if they need to outlive the document.
+ */
+class JsonDocument
+{
+public:
+  explicit JsonDocument(size_t initial_size = 64 * 1024) : arena_(initial_size) {}
+
+  JsonDocument(const JsonDocument &) = delete;
+  JsonDocument &operator=(const JsonDocument &) = delete;
+
+  bool parse(std::string_view text, JsonError *error = nullptr, ParseOptions options = {})
+  {
+    root_ = JSON();
+    arena_.release();
+    options.resource = &arena_;
+    return JSON::parse(text, root_, options, error);
+  }
+
+  JSON &root()
+  {
+    return root_;
+  }
+
+  const JSON &root() const
+  {
+    return root_;
+  }
+
+  std::pmr::memory_resource *resource()
+  {
+    return &arena_;
+  }
+
+private:
+  std::pmr::monotonic_buffer_resource arena_;
+  JSON root_;
+};
+
+namespace detail
+{
+
+struct PointerSegment
+{
+  std::string key;
+  size_t index{0};
+  bool is_index{false}; // key is a valid array index ("0" or no leading zero)
+  bool wildcard{false};
+};
+
+struct CompiledPointer
+{
+  std::vector<PointerSegment> segments;
+  bool wildcard{false};
+};
+
+// Walks a document once, descending only into members that some pointer can
+// still match and skipping everything else in the parser's validating skip mode
+class QueryScanner
+{
+public:
+  QueryScanner(std::string_view text, const std::vector<CompiledPointer> &pointers, ParseOptions options,
+               std::vector<std::vector<JSON>> &matches)
+      : parser_(text, options), pointers_(pointers), matches_(matches), found_(pointers.size(), 0)
+  {
+    for (const CompiledPointer &pointer : pointers_)
+    {
+      remaining_ += pointer.wildcard ? 0 : 1;
+      wildcards_ = wildcards_ || pointer.wildcard;
+    }
+  }
+
+  bool run()
+  {
+    matches_.assign(pointers_.size(), {});
+    for (size_t i = 0; i < pointers_.size(); ++i)
+    {
+      active_.push_back(static_cast<uint32_t>(i));
+    }
+    parser_.skip_ws();
+    if (!visit(0, active_.size(), 0))
+    {
+      return false;
+    }
+    if (finished())
+    {
+      // Every pointer has its (first) match; the rest of the input is not examined
+      return true;
+    }
+    parser_.skip_ws();
+    if (parser_.pos != parser_.input.size())
+    {
+      return parser_.fail("Trailing characters after JSON value");
+    }
+    return true;
+  }
+
+  const JsonError &error() const
+  {
+    return parser_.error;
+  }
+
+private:
+  Parser parser_;
+  const std::vector<CompiledPointer> &pointers_;
+  std::vector<std::vector<JSON>> &matches_;
+  std::vector<char> found_;
+  // Candidate pointer indices; each nesting level appends its subset and truncates on return
+  std::vector<uint32_t> active_;
+  std::string key_;
+  size_t remaining_{0};
+  bool wildcards_{false};
+
+  bool finished() const
+  {
+    return remaining_ == 0 && !wildcards_;
+  }
+
+  bool live(uint32_t index) const
+  {
+    return pointers_[index].wildcard || !found_[index];
+  }
+
+  bool visit(size_t begin, size_t end, size_t depth)
+  {
+    bool deeper = false;
+    const std::vector<JSON> *materialized = nullptr;
+    const size_t start = parser_.pos;
+    for (size_t k = begin; k < end; ++k)
+    {
+      const uint32_t index = active_[k];
+      if (!live(index))
+      {
+        continue;
+      }
+      if (pointers_[index].segments.size() > depth)
+      {
+        deeper = true;
+        continue;
+      }
+      if (!materialized)
+      {
+        JSON value;
+        if (!parser_.parse_value(value))
+        {
+          return false;
+        }
+        matches_[index].push_back(std::move(value));
+        materialized = &matches_[index];
+      }
+      else
+      {
+        // Several pointers selecting the same value share one parse
+        matches_[index].push_back(materialized->back());
+      }
+      if (!pointers_[index].wildcard)
+      {
+        found_[index] = 1;
+        --remaining_;
+      }
+    }
+    const bool matched = materialized != nullptr;
+
+    if (!deeper || finished())
+    {
+      return matched || parser_.skip_value();
+    }
+    parser_.pos = start;
+    switch (parser_.peek())
+    {
+    case '{':
+      return visit_object(begin, end, depth);
+    case '[':
+      return visit_array(begin, end, depth);
+    default:
+      return parser_.skip_value();
+    }
+  }
+
+  bool visit_child(size_t begin, size_t end, size_t depth, std::string_view key, size_t index, bool object)
+  {
+    const size_t child_begin = active_.size();
+    for (size_t k = begin; k < end; ++k)
+    {
+      const uint32_t candidate = active_[k];
+      const CompiledPointer &pointer = pointers_[candidate];
+      if (!live(candidate) || pointer.segments.size() <= depth)
+      {
+        continue;
+      }
+      const PointerSegment &segment = pointer.segments[depth];
+      if (segment.wildcard || (object ? segment.key == key : segment.is_index && segment.index == index))
+      {
+        active_.push_back(candidate);
+      }
+    }
+    const bool ok =
+        child_begin == active_.size() ? parser_.skip_value() : visit(child_begin, active_.size(), depth + 1);
+    active_.resize(child_begin);
+    return ok;
+  }
+
+  bool visit_object(size_t begin, size_t end, size_t depth)
+  {
+    ++parser_.pos;
+    parser_.skip_ws();
+    if (parser_.consume('}'))
+    {
+      return true;
+    }
+    while (true)
+    {
+      parser_.skip_ws();
+      std::string_view key;
+      if (!scan_key(key))
+      {
+        return false;
+      }
+      parser_.skip_ws();
+      if (!parser_.consume(':'))
+      {
+        return parser_.fail("Expected ':' after object key");
+      }
+      parser_.skip_ws();
+      if (!visit_child(begin, end, depth, key, 0, true))
+      {
+        return false;
+      }
+      if (finished())
+      {
+        return true;
+      }
+      parser_.skip_ws();
+      if (parser_.consume('}'))
+      {
+        return true;
+      }
+      if (!parser_.consume(','))
+      {
+        return parser_.fail("Expected ',' between object members");
+      }
+    }
+  }
+
+  bool visit_array(size_t begin, size_t end, size_t depth)
+  {
+    ++parser_.pos;
+    parser_.skip_ws();
+    if (parser_.consume(']'))
+    {
+      return true;
+    }
+    for (size_t index = 0;; ++index)
+    {
+      parser_.skip_ws();
+      if (!visit_child(begin, end, depth, {}, index, false))
+      {
+        return false;
+      }
+      if (finished())
+      {
+        return true;
+      }
+      parser_.skip_ws();
+      if (parser_.consume(']'))
+      {
+        return true;
+      }
+      if (!parser_.consume(','))
+      {
+        return parser_.fail("Expected ',' between array elements");
+      }
+    }
+  }
+
+  // Escape-free keys are compared in place; others are decoded into key_
+  bool scan_key(std::string_view &key)
+  {
+    const std::string_view input = parser_.input;
+    if (parser_.peek() == '"')
+    {
+      const size_t start = parser_.pos + 1;
+      const size_t run_end = parser_.scan_string_run(start);
+      if (run_end < input.size() && input[run_end] == '"')
+      {
+        key = input.substr(start, run_end - start);
+        parser_.pos = run_end + 1;
+        return true;
+      }
+    }
+    key_.clear();
+    if (!parser_.parse_string(key_))
+    {
+      return false;
+    }
+    key = key_;
+    return true;
+  }
+};
+
+} // namespace detail
+
+/**
+ * @brief Compiled JSON Pointer queries evaluated without building the full DOM
+ *
+ * Pointers follow RFC 6901 ("/user/id", "~1" for '/', "~0" for '~'), with one
+ * extension: a "*" segment matches every array element or object member. The
+ * document is scanned once; subtrees no pointer can match are skipped in the
+ * parser's validating skip mode and only matched values are materialized.
+ *
+ * A pointer without wildcards yields its first match, consistent with
+ * JSON::find() on duplicate keys. Once every pointer has such a match and
+ * none uses a wildcard, scanning stops and the rest of the input is not
+ * validated.
+ */
+class JsonQuery
+{
+public:
+  JsonQuery() = default;
+
+  // Throws std::invalid_argument on a malformed pointer
+  JsonQuery(std::initializer_list<std::string_view> pointers)
+  {
+    for (std::string_view pointer : pointers)
+    {
+      JsonError err;
+      if (!add(pointer, &err))
+      {
+        throw std::invalid_argument("Invalid JSON pointer '" + std::string(pointer) + "': " + err.message);
+      }
+    }
+  }
+
+  // Compile a pointer; its matches are reported at index size() - 1
+  bool add(std::string_view pointer, JsonError *error = nullptr)
+  {
+    detail::CompiledPointer compiled;
+    if (!pointer.empty() && pointer.front() != '/')
+    {
+      return fail(error, 0, "JSON pointer must be empty or start with '/'");
+    }
+    size_t pos = 0;
+    while (pos < pointer.size())
+    {
+      const size_t start = pos + 1;
+      const size_t next = std::min(pointer.find('/', start), pointer.size());
+      detail::PointerSegment segment;
+      for (size_t i = start; i < next; ++i)
+      {
+        if (pointer[i] != '~')
+        {
+          segment.key.push_back(pointer[i]);
+          continue;
+        }
+        if (i + 1 >= next || (pointer[i + 1] != '0' && pointer[i + 1] != '1'))
+        {
+          return fail(error, i, "Invalid '~' escape in JSON pointer");
+        }
+        segment.key.push_back(pointer[++i] == '0' ? '~' : '/');
+      }
+      segment.wildcard = pointer.substr(start, next - start) == "*";
+      segment.is_index = parse_index(segment.key, segment.index);
+      compiled.wildcard = compiled.wildcard || segment.wildcard;
+      compiled.segments.push_back(std::move(segment));
+      pos = next;
+    }
+    pointers_.push_back(std::move(compiled));
+    return true;
+  }
+
+  size_t size() const
+  {
+    return pointers_.size();
+  }
+
+  /**
+   * @brief Evaluate every pointer against a document
+   *
+   * matches[i] receives the values for the i-th pointer in document order.
+   * ParseOptions apply to the materialized values (e.g. borrow or resource).
+   */
+  bool run(std::string_view text, std::vector<std::vector<JSON>> &matches, JsonError *error = nullptr,
+           const ParseOptions &options = {}) const
+  {
+    detail::QueryScanner scanner(text, pointers_, options, matches);
+    const bool ok = scanner.run();
+    if (!ok && error)
+    {
+      *error = scanner.error();
+    }
+    return ok;
+  }
+
+private:
+  std::vector<detail::CompiledPointer> pointers_;
+
+  static bool fail(JsonError *error, size_t position, const char *message)
+  {
+    if (error)
+    {
+      *error = {position, message};
+    }
+    return false;
+  }
+
+  static bool parse_index(std::string_view key, size_t &index)
+  {
+    if (key.empty() || (key.size() > 1 && key.front() == '0'))
+    {
+      return false;
+    }
+    const auto result = std::from_chars(key.data(), key.data() + key.size(), index);
+    return result.ec == std::errc() && result.ptr == key.data() + key.size();
+  }
+};
+
+struct NdjsonOptions
+{
+  // Worker threads; 0 uses std::thread::hardware_concurrency()
+  size_t threads{0};
+  // Bytes of input each worker takes per round. Records of one round are
+  // delivered before the next round is parsed, which bounds memory use.
+  size_t batch_bytes{4 * 1024 * 1024};
+  // Applied to every record. A resource must be safe for concurrent use
+  // (e.g. std::pmr::synchronized_pool_resource); borrow is ignored for files.
+  ParseOptions parse{};
+};
+
+struct NdjsonError
+{
+  size_t line{0};   // 1-based line number
+  size_t offset{0}; // byte offset of the line in the input
+  JsonError error;  // position is relative to the start of the line
+};
+
+/**
+ * @brief Parses newline-delimited JSON in parallel while keeping record order
+ *
+ * Input is split on line boundaries into one slice per worker, the slices
+ * are parsed concurrently and the records are then delivered on the calling
+ * thread in input order. Blank lines are skipped; lines that fail to parse
+ * are reported as NdjsonError and parsing continues with the next line.
+ */
+class NdjsonParser
+{
+public:
+  // Receives each record with its 1-based line number; return false to stop
+  using RecordCallback = std::function<bool(size_t line, JSON &&value)>;
+
+  explicit NdjsonParser(NdjsonOptions options = {}) : options_(options)
+  {
+    if (options_.threads == 0)
+    {
+      options_.threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    options_.batch_bytes = std::max<size_t>(1, options_.batch_bytes);
+  }
+
+  // Returns false if any line failed to parse
+  bool parse(std::string_view text, std::vector<JSON> &records, std::vector<NdjsonError> *errors = nullptr) const
+  {
+    return parse(
+        text,
+        [&records](size_t, JSON &&value) {
+          records.push_back(std::move(value));
+          return true;
+        },
+        errors);
+  }
+
+  // Returns false if any line failed to parse or the callback stopped early
+  bool parse(std::string_view text, const RecordCallback &callback, std::vector<NdjsonError> *errors = nullptr) const
+  {
+    State state;
+    const size_t round_bytes = options_.threads * options_.batch_bytes;
+    size_t begin = 0;
+    while (begin < text.size() && !state.stopped)
+    {
+      const size_t end = line_boundary(text, begin + round_bytes);
+      run_round(text.substr(begin, end - begin), begin, options_.parse, callback, errors, state);
+      begin = end;
+    }
+    return state.ok && !state.stopped;
+  }
+
+  // Stream a file through in rounds so it never has to fit in memory at once
+  bool parse_file(const std::string &path, const RecordCallback &callback,
+                  std::vector<NdjsonError> *errors = nullptr) const
+  {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+      if (errors)
+      {
+        errors->push_back({0, 0, {0, "Unable to open file: " + path}});
+      }
+      return false;
+    }
+
+    ParseOptions parse_options = options_.parse;
+    parse_options.borrow = false; // the read buffer is reused between rounds
+    State state;
+    std::string buffer;
+    size_t buffer_offset = 0;
+    const size_t round_bytes = options_.threads * options_.batch_bytes;
+    while (!state.stopped)
+    {
+      const size_t carried = buffer.size();
+      buffer.resize(carried + round_bytes);
+      file.read(buffer.data() + carried, static_cast<std::streamsize>(round_bytes));
+      buffer.resize(carried + static_cast<size_t>(file.gcount()));
+      const bool eof = !file;
+
+      const size_t last_newline = buffer.rfind('\n');
+      const size_t complete = eof ? buffer.size() : (last_newline == std::string::npos ? 0 : last_newline + 1);
+      run_round(std::string_view(buffer).substr(0, complete), buffer_offset, parse_options, callback, errors, state);
+      buffer.erase(0, complete);
+      buffer_offset += complete;
+      if (eof)
+      {
+        break;
+      }
+    }
+    return state.ok && !state.stopped;
+  }
+
+private:
+  struct State
+  {
+    size_t line_base{0};
+    bool ok{true};
+    bool stopped{false};
+  };
+
+  struct Slice
+  {
+    std::string_view text;
+    size_t offset{0};
+    size_t lines{0};
+    std::vector<std::pair<size_t, JSON>> records; // (line within slice, value)
+    std::vector<NdjsonError> errors;
+  };
+
+  NdjsonOptions options_;
+
+  // First line start at or after pos (or the end of text)
+  static size_t line_boundary(std::string_view text, size_t pos)
+  {
+    if (pos >= text.size())
+    {
+      return text.size();
+    }
+    const size_t newline = text.find('\n', pos == 0 ? 0 : pos - 1);
+    return newline == std::string_view::npos ? text.size() : newline + 1;
+  }
+
+  static void parse_slice(Slice &slice, const ParseOptions &options)
+  {
+    size_t begin = 0;
+    while (begin < slice.text.size())
+    {
+      const size_t newline = slice.text.find('\n', begin);
+      const size_t end = newline == std::string_view::npos ? slice.text.size() : newline;
+      const std::string_view line = slice.text.substr(begin, end - begin);
+      const size_t line_index = slice.lines++;
+      if (std::any_of(line.begin(), line.end(), [](char c) { return !detail::is_whitespace(c); }))
+      {
+        JSON value;
+        JsonError error;
+        if (JSON::parse(line, value, options, &error))
+        {
+          slice.records.emplace_back(line_index, std::move(value));
+        }
+        else
+        {
+          slice.errors.push_back({line_index, slice.offset + begin, std::move(error)});
+        }
+      }
+      begin = end + 1;
+    }
+  }
+
+  void run_round(std::string_view text, size_t offset, const ParseOptions &parse_options,
+                 const RecordCallback &callback, std::vector<NdjsonError> *errors, State &state) const
+  {
+    if (text.empty())
+    {
+      return;
+    }
+
+    std::vector<Slice> slices;
+    const size_t slice_bytes = std::max<size_t>(1, text.size() / options_.threads);
+    size_t begin = 0;
+    while (begin < text.size())
+    {
+      const size_t end = slices.size() + 1 == options_.threads ? text.size() : line_boundary(text, begin + slice_bytes);
+      Slice slice;
+      slice.text = text.substr(begin, end - begin);
+      slice.offset = offset + begin;
+      slices.push_back(std::move(slice));
+      begin = end;
+    }
+
+    if (slices.size() == 1)
+    {
+      parse_slice(slices.front(), parse_options);
+    }
+    else
+    {
+      std::vector<std::thread> workers;
+      workers.reserve(slices.size());
+      for (Slice &slice : slices)
+      {
+        workers.emplace_back([&slice, &parse_options] { parse_slice(slice, parse_options); });
+      }
+      for (std::thread &worker : workers)
+      {
+        worker.join();
+      }
+    }
+
+    for (Slice &slice : slices)
+    {
+      for (NdjsonError &error : slice.errors)
+      {
+        state.ok = false;
+        if (errors)
+        {
+          error.line += state.line_base + 1;
+          errors->push_back(std::move(error));
+        }
+      }
+      for (auto &record : slice.records)
+      {
+        if (!state.stopped && !callback(state.line_base + record.first + 1, std::move(record.second)))
+        {
+          state.stopped = true;
+        }
+      }
+      state.line_base += slice.lines;
+    }
+  }
+};
+
+inline void JSON::append_escaped(std::string &out, std::string_view input, bool escape_solidus)
+{
+  const char *cursor = input.data();
+  const char *const end = cursor + input.size();
+  const char extra = escape_solidus ? '/' : '"';
+  while (cursor != end)
+  {
+    // Copy the run up to the next character that needs escaping in one go
+    const char *special = detail::find_string_special(cursor, end, extra);
+    out.append(cursor, static_cast<size_t>(special - cursor));
+    if (special == end)
+    {
+      break;
+    }
+    cursor = special + 1;
+
+    const auto c = static_cast<unsigned char>(*special);
+    switch (c)
+    {
+    case '"':
+      out += "\\\"";
+      break;
+    case '\\':
+      out += "\\\\";
+      break;
+    case '\b':
+      out += "\\b";
+      break;
+    case '\f':
+      out += "\\f";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    case '\r':
+      out += "\\r";
+      break;
+    case '\t':
+      out += "\\t";
+      break;
+    case '/':
+      out += "\\/";
+      break;
+    default:
+    {
+      constexpr char hex[] = "0123456789ABCDEF";
+      out += "\\u00";
+      out.push_back(hex[(c >> 4) & 0xF]);
+      out.push_back(hex[c & 0xF]);
+      break;
+    }
+    }
+  }
+}
+
+inline void JSON::stringify_impl(const JSON &node, const StringifyOptions &options, std::string &out, int depth)
+{
+  switch (node.type())
+  {
+  case Type::Null:
+    out += "null";
+    return;
+  case Type::Bool:
+    out += node.as_bool() ? "true" : "false";
+    return;
+  case Type::Number:
+    out += node.as_number().text();
+    return;
+  case Type::String:
+    out += '"';
+    append_escaped(out, node.as_string_view(), options.escape_solidus);
+    out += '"';
+    return;
+  case Type::Array:
+  {
+    const auto &arr = node.as_array();
+    out += "[";
+    if (arr.empty())
+    {
+      out += "]";
+      return;
+    }
+    if (options.pretty)
+    {
+      out += "\n";
+    }
+    for (size_t i = 0; i < arr.size(); ++i)
+    {
+      if (options.pretty)
+      {
+        out.append((depth + 1) * options.indent, ' ');
+      }
+      stringify_impl(arr[i], options, out, depth + 1);
+      if (i + 1 < arr.size())
+      {
+        out += options.pretty ? ",\n" : ",";
+      }
+    }
+    if (options.pretty)
+    {
+      out += "\n";
+      out.append(depth * options.indent, ' ');
+    }
+    out += "]";
+    return;
+  }
+  case Type::Object:
+  {
+    const auto &obj = node.as_object();
+    out += "{";
+    if (obj.empty())
+    {
+      out += "}";
+      return;
+    }
+    if (options.pretty)
+    {
+      out += "\n";
+    }
+    for (size_t i = 0; i < obj.size(); ++i)
+    {
+      if (options.pretty)
+      {
+        out.append((depth + 1) * options.indent, ' ');
+      }
+      out += '"';
+      append_escaped(out, obj[i].first, options.escape_solidus);
+      out += options.pretty ? "" : "";
+      out += '"';
+      out += options.pretty ? ": " : ":";
+      stringify_impl(obj[i].second, options, out, depth + 1);
+      if (i + 1 < obj.size())
+      {
+        out += options.pretty ? ",\n" : ",";
+      }
+    }
+    if (options.pretty)
+    {
+      out += "\n";
+      out.append(depth * options.indent, ' ');
+    }
+    out += "}";
+    return;
+  }
+  }
+}
+
+inline std::string JSON::stringify(const StringifyOptions &options) const
+{
+  std::string out;
+  stringify_impl(*this, options, out, 0);
+  return out;
+}
+
+/**
+ * @brief Streaming JSON serializer that writes without building a DOM
+ *
+ * Output is appended to a caller-supplied string (which can be cleared and
+ * reused across documents so its capacity is kept), or buffered and handed to
+ * a sink callback whenever the buffer reaches flush_threshold bytes between
+ * values, so large arrays are emitted incrementally. The layout matches
+ * JSON::stringify() for the same StringifyOptions.
+ *
+ * Calls that would produce malformed JSON (a value where a key is expected,
+ * mismatched end_* calls, a second top-level value) throw std::logic_error.
+ */
+class JsonWriter
+{
+public:
+  using Sink = std::function<void(std::string_view)>;
+
+  explicit JsonWriter(std::string &out, StringifyOptions options = {}) : out_(&out), options_(options) {}
+
+  explicit JsonWriter(Sink sink, StringifyOptions options = {}, size_t flush_threshold = 64 * 1024)
+      : out_(&buffer_), options_(options), sink_(std::move(sink)), flush_threshold_(flush_threshold)
+  {
+    buffer_.reserve(flush_threshold_);
+  }
+
+  JsonWriter(const JsonWriter &) = delete;
+  JsonWriter &operator=(const JsonWriter &) = delete;
+
+  ~JsonWriter()
+  {
+    try
+    {
+      flush();
+    }
+    catch (...)
+    {
+      // A throwing sink must not escape a destructor
+    }
+  }
+
+  JsonWriter &begin_object()
+  {
+    before_value();
+    *out_ += '{';
+    frames_.push_back({true, false, false});
+    return *this;
+  }
+
+  JsonWriter &end_object()
+  {
+    return end_container(true);
+  }
+
+  JsonWriter &begin_array()
+  {
+    before_value();
+    *out_ += '[';
+    frames_.push_back({false, false, false});
+    return *this;
+  }
+
+  JsonWriter &end_array()
+  {
+    return end_container(false);
+  }
+
+  JsonWriter &key(std::string_view name)
+  {
+    if (frames_.empty() || !frames_.back().object || frames_.back().after_key)
+    {
+      throw std::logic_error("JsonWriter: key() is only valid inside an object before a value");
+    }
+    begin_item();
+    *out_ += '"';
+    JSON::append_escaped(*out_, name, options_.escape_solidus);
+    *out_ += options_.pretty ? "\": " : "\":";
+    frames_.back().after_key = true;
+    return *this;
+  }
+
+  JsonWriter &value(std::nullptr_t)
+  {
+    return raw("null");
+  }
+
+  JsonWriter &value(bool flag)
+  {
+    return raw(flag ? "true" : "false");
+  }
+
+  template <typename T>
+    requires(std::is_integral_v<T> && !std::is_same_v<T, bool>)
+  JsonWriter &value(T number)
+  {
+    char digits[24];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    return raw(std::string_view(digits, static_cast<size_t>(result.ptr - digits)));
+  }
+
+  JsonWriter &value(double number)
+  {
+    char digits[32];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    return raw(std::string_view(digits, static_cast<size_t>(result.ptr - digits)));
+  }
+
+  JsonWriter &value(std::string_view text)
+  {
+    before_value();
+    *out_ += '"';
+    JSON::append_escaped(*out_, text, options_.escape_solidus);
+    *out_ += '"';
+    return after_value();
+  }
+
+  JsonWriter &value(const char *text)
+  {
+    return value(std::string_view(text));
+  }
+
+  JsonWriter &value(const std::string &text)
+  {
+    return value(std::string_view(text));
+  }
+
+  // Write an existing DOM subtree in place
+  JsonWriter &value(const JSON &node)
+  {
+    before_value();
+    JSON::stringify_impl(node, options_, *out_, static_cast<int>(frames_.size()));
+    return after_value();
+  }
+
+  // Write a pre-formatted number without re-encoding it (e.g. from JSON::Number::text())
+  JsonWriter &number(std::string_view repr)
+  {
+    return raw(repr);
+  }
+
+  // Hand buffered output to the sink; no-op when writing to a caller string
+  void flush()
+  {
+    if (sink_ && !buffer_.empty())
+    {
+      sink_(buffer_);
+      buffer_.clear();
+    }
+  }
+
+  // True once a top-level value has been written and every container closed
+  bool complete() const
+  {
+    return done_;
+  }
+
+private:
+  struct Frame
+  {
+    bool object;
+    bool has_items;
+    bool after_key;
+  };
+
+  std::string buffer_;
+  std::string *out_;
+  StringifyOptions options_;
+  Sink sink_;
+  size_t flush_threshold_{0};
+  std::vector<Frame> frames_;
+  bool done_{false};
+
+  void indent(size_t depth)
+  {
+    if (options_.pretty)
+    {
+      out_->append(depth * static_cast<size_t>(options_.indent), ' ');
+    }
+  }
+
+  // Separator, newline and indentation before an array element or object key
+  void begin_item()
+  {
+    Frame &frame = frames_.back();
+    if (frame.has_items)
+    {
+      *out_ += ',';
+    }
+    if (options_.pretty)
+    {
+      *out_ += '\n';
+    }
+    frame.has_items = true;
+    indent(frames_.size());
+  }
+
+  void before_value()
+  {
+    if (frames_.empty())
+    {
+      if (done_)
+      {
+        throw std::logic_error("JsonWriter: document already has a top-level value");
+      }
+      return;
+    }
+    Frame &frame = frames_.back();
+    if (frame.object)
+    {
+      if (!frame.after_key)
+      {
+        throw std::logic_error("JsonWriter: object members need a key() first");
+      }
+      frame.after_key = false;
+      return;
+    }
+    begin_item();
+  }
+
+  JsonWriter &after_value()
+  {
+    if (frames_.empty())
+    {
+      done_ = true;
+    }
+    if (sink_ && buffer_.size() >= flush_threshold_)
+    {
+      flush();
+    }
+    return *this;
+  }
+
+  JsonWriter &raw(std::string_view text)
+  {
+    before_value();
+    *out_ += text;
+    return after_value();
+  }
+
+  JsonWriter &end_container(bool object)
+  {
+    if (frames_.empty() || frames_.back().object != object || frames_.back().after_key)
+    {
+      throw std::logic_error(object ? "JsonWriter: end_object() without a matching begin_object()"
+                                    : "JsonWriter: end_array() without a matching begin_array()");
+    }
+    const bool has_items = frames_.back().has_items;
+    frames_.pop_back();
+    if (has_items && options_.pretty)
+    {
+      *out_ += '\n';
+      indent(frames_.size());
+    }
+    *out_ += object ? '}' : ']';
+    return after_value();
+  }
+};
+
+namespace detail
+{
+
+// Decimal digits of a JSON number split into sign, significant digits and a
+// power-of-ten exponent, e.g. "-12.50e3" -> {true, "125", 2}
+struct DecimalParts
+{
+  bool negative{false};
+  std::string digits;
+  int64_t exponent{0};
+};
+
+inline bool split_decimal(std::string_view text, DecimalParts &parts)
+{
+  size_t pos = 0;
+  parts = {};
+  if (pos < text.size() && text[pos] == '-')
+  {
+    parts.negative = true;
+    ++pos;
+  }
+  bool any_digit = false;
+  bool fraction = false;
+  for (; pos < text.size(); ++pos)
+  {
+    const char c = text[pos];
+    if (c == '.' && !fraction)
+    {
+      fraction = true;
+    }
+    else if (c >= '0' && c <= '9')
+    {
+      any_digit = true;
+      if (!parts.digits.empty() || c != '0')
+      {
+        parts.digits.push_back(c);
+      }
+      parts.exponent -= fraction ? 1 : 0;
+    }
+    else
+    {
+      break;
+    }
+  }
+  if (!any_digit)
+  {
+    return false;
+  }
+  if (pos < text.size())
+  {
+    if (text[pos] != 'e' && text[pos] != 'E')
+    {
+      return false;
+    }
+    ++pos;
+    int64_t exponent = 0;
+    if (pos < text.size() && text[pos] == '+')
+    {
+      ++pos;
+    }
+    const auto result = std::from_chars(text.data() + pos, text.data() + text.size(), exponent);
+    if (result.ec != std::errc() || result.ptr != text.data() + text.size())
+    {
+      return false;
+    }
+    parts.exponent += exponent;
+  }
+  while (!parts.digits.empty() && parts.digits.back() == '0')
+  {
+    parts.digits.pop_back();
+    ++parts.exponent;
+  }
+  if (parts.digits.empty())
+  {
+    parts.digits = "0";
+    parts.exponent = 0;
+  }
+  return true;
+}
+
+// Big-endian magnitude of an unsigned decimal string
+inline std::string decimal_to_bytes(std::string_view digits)
+{
+  std::string bytes; // little-endian while accumulating
+  for (char c : digits)
+  {
+    unsigned carry = static_cast<unsigned>(c - '0');
+    for (char &byte : bytes)
+    {
+      const unsigned v = static_cast<unsigned char>(byte) * 10u + carry;
+      byte = static_cast<char>(v & 0xFF);
+      carry = v >> 8;
+    }
+    if (carry != 0)
+    {
+      bytes.push_back(static_cast<char>(carry));
+    }
+  }
+  return std::string(bytes.rbegin(), bytes.rend());
+}
+
+// Decimal string of a big-endian magnitude, optionally plus one (CBOR negative bignums)
+inline std::string bytes_to_decimal(std::string_view bytes, bool add_one)
+{
+  std::string digits; // little-endian decimal digits while accumulating
+  auto add = [&digits](unsigned carry, size_t from) {
+    for (size_t i = from; carry != 0; ++i)
+    {
+      if (i == digits.size())
+      {
+        digits.push_back(0);
+      }
+      const unsigned v = static_cast<unsigned>(digits[i]) + carry;
+      digits[i] = static_cast<char>(v % 10);
+      carry = v / 10;
+    }
+  };
+  for (char byte : bytes)
+  {
+    unsigned carry = 0;
+    for (char &digit : digits)
+    {
+      const unsigned v = static_cast<unsigned>(digit) * 256u + carry;
+      digit = static_cast<char>(v % 10);
+      carry = v / 10;
+    }
+    add(carry, digits.size());
+    add(static_cast<unsigned char>(byte), 0);
+  }
+  if (add_one)
+  {
+    add(1, 0);
+  }
+  if (digits.empty())
+  {
+    return "0";
+  }
+  std::string out;
+  out.reserve(digits.size());
+  for (auto it = digits.rbegin(); it != digits.rend(); ++it)
+  {
+    out.push_back(static_cast<char>('0' + *it));
+  }
+  return out;
+}
+
+inline void cbor_head(std::string &out, uint8_t major, uint64_t value)
+{
+  const auto type = static_cast<char>(major << 5);
+  if (value < 24)
+  {
+    out.push_back(static_cast<char>(type | static_cast<char>(value)));
+    return;
+  }
+  int bytes = 8;
+  char info = 27;
+  if (value <= 0xFF)
+  {
+    bytes = 1;
+    info = 24;
+  }
+  else if (value <= 0xFFFF)
+  {
+    bytes = 2;
+    info = 25;
+  }
+  else if (value <= 0xFFFFFFFF)
+  {
+    bytes = 4;
+    info = 26;
+  }
+  out.push_back(static_cast<char>(type | info));
+  for (int shift = (bytes - 1) * 8; shift >= 0; shift -= 8)
+  {
+    out.push_back(static_cast<char>((value >> shift) & 0xFF));
+  }
+}
+
+inline void cbor_integer(std::string &out, bool negative, std::string_view digits)
+{
+  uint64_t magnitude = 0;
+  const auto result = std::from_chars(digits.data(), digits.data() + digits.size(), magnitude);
+  if (result.ec == std::errc() && result.ptr == digits.data() + digits.size() && (!negative || magnitude != 0))
+  {
+    // Negative integers are stored as -1 - n
+    cbor_head(out, negative ? 1 : 0, negative ? magnitude - 1 : magnitude);
+    return;
+  }
+  std::string bytes = decimal_to_bytes(digits);
+  if (negative)
+  {
+    // Tag 3 stores -1 - n; subtract one from the big-endian magnitude
+    for (auto it = bytes.rbegin(); it != bytes.rend(); ++it)
+    {
+      if ((*it)-- != 0)
+      {
+        break;
+      }
+    }
+  }
+  bytes.erase(0, std::min(bytes.find_first_not_of('\0'), bytes.size()));
+  if (negative && bytes.size() <= 8)
+  {
+    // -2^64 still fits major type 1 once the -1 offset is applied
+    uint64_t value = 0;
+    for (char byte : bytes)
+    {
+      value = (value << 8) | static_cast<unsigned char>(byte);
+    }
+    cbor_head(out, 1, value);
+    return;
+  }
+  cbor_head(out, 6, negative ? 3 : 2);
+  cbor_head(out, 2, bytes.size());
+  out += bytes;
+}
+
+inline void cbor_double(std::string &out, double value)
+{
+  if (std::isnan(value))
+  {
+    out += "\xF9\x7E\x00"; // canonical half-precision NaN
+    return;
+  }
+  const auto single = static_cast<float>(value);
+  if (static_cast<double>(single) == value)
+  {
+    out.push_back(static_cast<char>(0xFA));
+    const auto bits = std::bit_cast<uint32_t>(single);
+    for (int shift = 24; shift >= 0; shift -= 8)
+    {
+      out.push_back(static_cast<char>((bits >> shift) & 0xFF));
+    }
+    return;
+  }
+  out.push_back(static_cast<char>(0xFB));
+  const auto bits = std::bit_cast<uint64_t>(value);
+  for (int shift = 56; shift >= 0; shift -= 8)
+  {
+    out.push_back(static_cast<char>((bits >> shift) & 0xFF));
+  }
+}
+
+} // namespace detail
+
+inline void JSON::append_cbor(std::string &out) const
+{
+  switch (type())
+  {
+  case Type::Null:
+    out.push_back(static_cast<char>(0xF6));
+    return;
+  case Type::Bool:
+    out.push_back(static_cast<char>(as_bool() ? 0xF5 : 0xF4));
+    return;
+  case Type::Number:
+  {
+    const Number &number = as_number();
+    const Number::Kind kind = number.resolved_kind();
+    switch (kind)
+    {
+    case Number::Kind::Int64:
+    {
+      const int64_t v = number.to_int64();
+      // -1 - v cannot overflow for negative v
+      detail::cbor_head(out, v < 0 ? 1 : 0, v < 0 ? static_cast<uint64_t>(-(v + 1)) : static_cast<uint64_t>(v));
+      return;
+    }
+    case Number::Kind::Uint64:
+      detail::cbor_head(out, 0, number.to_uint64());
+      return;
+    default:
+      break;
+    }
+
+    const std::string_view text = number.text();
+    if (kind == Number::Kind::BigInteger)
+    {
+      const bool negative = text.front() == '-';
+      detail::cbor_integer(out, negative, text.substr(negative ? 1 : 0));
+      return;
+    }
+    detail::DecimalParts parts;
+    if (!detail::split_decimal(text, parts))
+    {
+      out.push_back(static_cast<char>(0xF6)); // not a number at all
+      return;
+    }
+    const double value = number.to_double();
+    // Up to 15 significant digits always survive a trip through a double
+    if (parts.digits.size() <= 15 && std::isfinite(value) && (value != 0.0 || parts.digits == "0"))
+    {
+      detail::cbor_double(out, value);
+      return;
+    }
+    // Otherwise keep the exact decimal as a tag 4 decimal fraction [exponent, mantissa]
+    detail::cbor_head(out, 6, 4);
+    detail::cbor_head(out, 4, 2);
+    detail::cbor_head(out, parts.exponent < 0 ? 1 : 0,
+                      parts.exponent < 0 ? static_cast<uint64_t>(-(parts.exponent + 1))
+                                         : static_cast<uint64_t>(parts.exponent));
+    detail::cbor_integer(out, parts.negative, parts.digits);
+    return;
+  }
+  case Type::String:
+  {
+    const std::string_view text = as_string_view();
+    detail::cbor_head(out, 3, text.size());
+    out += text;
+    return;
+  }
+  case Type::Array:
+  {
+    const auto &arr = as_array();
+    detail::cbor_head(out, 4, arr.size());
+    for (const JSON &element : arr)
+    {
+      element.append_cbor(out);
+    }
+    return;
+  }
+  case Type::Object:
+  {
+    const auto &obj = as_object();
+    detail::cbor_head(out, 5, obj.size());
+    for (const auto &member : obj)
+    {
+      detail::cbor_head(out, 3, member.first.size());
+      out += member.first;
+      member.second.append_cbor(out);
+    }
+    return;
+  }
+  }
+}
+
+inline std::string JSON::to_cbor() const
+{
+  std::string out;
+  append_cbor(out);
+  return out;
+}
+
+// Decodes CBOR (RFC 8949) into JSON nodes; mirrors Parser's structure and error reporting
+class CborDecoder
+{
+public:
+  explicit CborDecoder(std::string_view data, ParseOptions opts = {})
+      : input(data), options(opts), resource(opts.resource ? opts.resource : std::pmr::get_default_resource())
+  {
+  }
+
+  bool decode(JSON &out)
+  {
+    if (!decode_value(out))
+    {
+      return false;
+    }
+    if (pos != input.size())
+    {
+      return fail("Trailing bytes after CBOR value");
+    }
+    return true;
+  }
+
+  JsonError error;
+
+private:
+  static constexpr uint64_t indefinite = ~uint64_t{0};
+  // Arrays, maps and tags nest by recursion; deeper input is rejected
+  static constexpr size_t max_depth = 512;
+  // Declared lengths are untrusted, so containers pre-size at most this much
+  static constexpr uint64_t max_reserve = 64;
+
+  std::string_view input;
+  ParseOptions options;
+  std::pmr::memory_resource *resource;
+  size_t pos{0};
+  size_t depth{0};
+
+  bool fail(std::string message)
+  {
+    error = {pos, std::move(message)};
+    return false;
+  }
+
+  // Read the initial byte and its argument; indefinite lengths yield `indefinite`
+  bool read_head(uint8_t &major, uint8_t &info, uint64_t &value)
+  {
+    if (pos >= input.size())
+    {
+      return fail("Unexpected end of CBOR data");
+    }
+    const auto initial = static_cast<uint8_t>(input[pos++]);
+    major = initial >> 5;
+    info = initial & 0x1F;
+    if (info < 24)
+    {
+      value = info;
+      return true;
+    }
+    if (info == 31)
+    {
+      value = indefinite;
+      // Only strings, arrays, maps and the break code have an indefinite form
+      return (major >= 2 && major != 6) ? true : fail("Invalid CBOR additional information");
+    }
+    if (info > 27)
+    {
+      return fail("Invalid CBOR additional information");
+    }
+    const size_t bytes = size_t{1} << (info - 24);
+    if (input.size() - pos < bytes)
+    {
+      return fail("Unexpected end of CBOR data");
+    }
+    value = 0;
+    for (size_t i = 0; i < bytes; ++i)
+    {
+      value = (value << 8) | static_cast<uint8_t>(input[pos++]);
     }
-    JSON::object_t members;
-    skip_ws();
-    if (consume('}'))
+    return true;
+  }
+
+  bool at_break()
+  {
+    if (pos < input.size() && static_cast<uint8_t>(input[pos]) == 0xFF)
     {
-      out = JSON::object(std::move(members));
+      ++pos;
       return true;
     }
+    return false;
+  }
 
-    while (true)
+  // Definite or indefinite string of the given major type; definite ones are views into the input
+  bool read_string(uint8_t major, uint64_t length, std::string_view &view, std::string &owned, bool &is_view)
+  {
+    if (length != indefinite)
     {
-      skip_ws();
-      std::string key;
-      if (!parse_string(key))
-      {
-        return false;
-      }
-      skip_ws();
-      if (!consume(':'))
+      if (input.size() - pos < length)
       {
-        return fail("Expected ':' after object key");
+        return fail("Unexpected end of CBOR data");
       }
-      skip_ws();
-      JSON value;
-      if (!parse_value(value))
+      view = input.substr(pos, static_cast<size_t>(length));
+      pos += static_cast<size_t>(length);
+      is_view = true;
+      return true;
+    }
+    is_view = false;
+    owned.clear();
+    while (!at_break())
+    {
+      uint8_t chunk_major = 0;
+      uint8_t info = 0;
+      uint64_t chunk_length = 0;
+      if (!read_head(chunk_major, info, chunk_length))
       {
         return false;
       }
-      members.emplace_back(std::move(key), std::move(value));
-      skip_ws();
-      if (consume('}'))
+      if (chunk_major != major || chunk_length == indefinite)
       {
-        out = JSON::object(std::move(members));
-        return true;
+        return fail("Invalid chunk in indefinite-length CBOR string");
       }
-      if (!consume(','))
+      std::string_view chunk;
+      std::string unused;
+      bool chunk_is_view = false;
+      if (!read_string(major, chunk_length, chunk, unused, chunk_is_view))
       {
-        return fail("Expected ',' between object members");
+        return false;
       }
-      skip_ws();
+      owned += chunk;
     }
+    view = owned;
+    return true;
   }
-};
 
-inline bool JSON::parse(const std::string &text, JSON &out, JsonError *error)
-{
-  Parser parser(text);
-  const bool ok = parser.parse(out);
-  if (!ok && error)
+  // Integer (major 0/1) or bignum (tag 2/3) as decimal text
+  bool read_integer_text(std::string &text)
   {
-    *error = parser.error;
+    uint8_t major = 0;
+    uint8_t info = 0;
+    uint64_t value = 0;
+    if (!read_head(major, info, value))
+    {
+      return false;
+    }
+    if (major == 0 || major == 1)
+    {
+      // Major type 1 encodes -1 - value; only -2^64 falls outside uint64 after negation
+      char digits[24];
+      if (major == 1 && value == std::numeric_limits<uint64_t>::max())
+      {
+        text = "-18446744073709551616";
+        return true;
+      }
+      const uint64_t magnitude = major == 0 ? value : value + 1;
+      const auto result = std::to_chars(digits, digits + sizeof(digits), magnitude);
+      text.assign(major == 0 ? "" : "-");
+      text.append(digits, result.ptr);
+      return true;
+    }
+    if (major == 6 && (value == 2 || value == 3))
+    {
+      return read_bignum(value == 3, text);
+    }
+    return fail("Expected CBOR integer");
   }
-  return ok;
-}
 
-inline JSON JSON::parse_or_throw(const std::string &text)
-{
-  JSON value;
-  JsonError err;
-  if (!parse(text, value, &err))
+  bool read_bignum(bool negative, std::string &text)
   {
-    std::ostringstream oss;
-    oss << "JSON parse error at position " << err.position << ": " << err.message;
-    throw std::invalid_argument(oss.str());
+    uint8_t major = 0;
+    uint8_t info = 0;
+    uint64_t length = 0;
+    if (!read_head(major, info, length))
+    {
+      return false;
+    }
+    if (major != 2)
+    {
+      return fail("CBOR bignum must be a byte string");
+    }
+    std::string_view bytes;
+    std::string owned;
+    bool is_view = false;
+    if (!read_string(2, length, bytes, owned, is_view))
+    {
+      return false;
+    }
+    text = negative ? "-" + detail::bytes_to_decimal(bytes, true) : detail::bytes_to_decimal(bytes, false);
+    return true;
   }
-  return value;
-}
-
-inline bool JSON::validate(const std::string &text)
-{
-  JSON value;
-  return parse(text, value, nullptr);
-}
 
-inline std::string JSON::escape_string(const std::string &input, bool escape_solidus)
-{
-  std::string out;
-  out.reserve(input.size() + input.size() / 4);
-  for (unsigned char c : input)
+  bool decode_float(uint8_t info, uint64_t bits, JSON &out)
   {
-    switch (c)
+    double value = 0.0;
+    if (info == 25)
     {
-    case '"':
-      out += "\\\"";
-      break;
-    case '\\':
-      out += "\\\\";
-      break;
-    case '\b':
-      out += "\\b";
-      break;
-    case '\f':
-      out += "\\f";
-      break;
-    case '\n':
-      out += "\\n";
-      break;
-    case '\r':
-      out += "\\r";
-      break;
-    case '\t':
-      out += "\\t";
-      break;
-    case '/':
-      out += escape_solidus ? "\\/" : "/";
-      break;
-    default:
-      if (c < 0x20)
+      // IEEE 754 half precision
+      const auto half = static_cast<unsigned>(bits);
+      const int exponent = static_cast<int>((half >> 10) & 0x1F);
+      const double mantissa = half & 0x3FF;
+      if (exponent == 0)
       {
-        constexpr char hex[] = "0123456789ABCDEF";
-        out += "\\u00";
-        out.push_back(hex[(c >> 4) & 0xF]);
-        out.push_back(hex[c & 0xF]);
+        value = std::ldexp(mantissa, -24);
+      }
+      else if (exponent == 31)
+      {
+        value = mantissa == 0 ? std::numeric_limits<double>::infinity() : std::numeric_limits<double>::quiet_NaN();
       }
       else
       {
-        out.push_back(static_cast<char>(c));
+        value = std::ldexp(mantissa + 1024, exponent - 25);
       }
-      break;
+      value = (half & 0x8000) ? -value : value;
+    }
+    else if (info == 26)
+    {
+      value = std::bit_cast<float>(static_cast<uint32_t>(bits));
+    }
+    else
+    {
+      value = std::bit_cast<double>(bits);
     }
+    // Non-finite values have no JSON number spelling
+    out = std::isfinite(value) ? JSON(value) : JSON();
+    return true;
   }
-  return out;
-}
 
-inline void JSON::stringify_impl(const JSON &node, const StringifyOptions &options, std::string &out, int depth)
-{
-  switch (node.type_)
-  {
-  case Type::Null:
-    out += "null";
-    return;
-  case Type::Bool:
-    out += node.as_bool() ? "true" : "false";
-    return;
-  case Type::Number:
-    out += node.as_number().repr;
-    return;
-  case Type::String:
-    out += '"';
-    out += escape_string(node.as_string(), options.escape_solidus);
-    out += '"';
-    return;
-  case Type::Array:
+  bool decode_value(JSON &out)
   {
-    const auto &arr = node.as_array();
-    out += "[";
-    if (arr.empty())
+    uint8_t major = 0;
+    uint8_t info = 0;
+    uint64_t value = 0;
+    const size_t start = pos;
+    if (!read_head(major, info, value))
     {
-      out += "]";
-      return;
+      return false;
     }
-    if (options.pretty)
+    switch (major)
     {
-      out += "\n";
-    }
-    for (size_t i = 0; i < arr.size(); ++i)
+    case 0:
+      out = JSON(JSON::Number::from_uint64(value));
+      return true;
+    case 1:
+      if (value <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max()))
+      {
+        out = JSON(JSON::Number::from_int64(-1 - static_cast<int64_t>(value)));
+        return true;
+      }
+      pos = start;
+      {
+        std::string text;
+        if (!read_integer_text(text))
+        {
+          return false;
+        }
+        out = JSON::number(text);
+        return true;
+      }
+    case 2:
+      pos = start;
+      return fail("Unsupported CBOR byte string");
+    case 3:
     {
-      if (options.pretty)
+      std::string_view view;
+      std::string owned;
+      bool is_view = false;
+      if (!read_string(3, value, view, owned, is_view))
       {
-        out.append((depth + 1) * options.indent, ' ');
+        return false;
       }
-      stringify_impl(arr[i], options, out, depth + 1);
-      if (i + 1 < arr.size())
+      if (is_view && options.borrow)
       {
-        out += options.pretty ? ",\n" : ",";
+        out = JSON::borrowed_string(view);
+      }
+      else if (options.resource)
+      {
+        out = JSON::string(is_view ? view : std::string_view(owned), resource);
+      }
+      else
+      {
+        out = JSON(is_view ? std::string(view) : std::move(owned));
       }
+      return true;
     }
-    if (options.pretty)
+    case 4:
+    case 5:
+    case 6:
     {
-      out += "\n";
-      out.append(depth * options.indent, ' ');
+      if (depth == max_depth)
+      {
+        pos = start;
+        return fail("CBOR nesting too deep");
+      }
+      ++depth;
+      const bool ok = major == 4 ? decode_array(value, out) : major == 5 ? decode_map(value, out) : decode_tag(value, out);
+      --depth;
+      return ok;
+    }
+    default:
+      return decode_simple(info, value, out);
     }
-    out += "]";
-    return;
   }
-  case Type::Object:
+
+  bool decode_tag(uint64_t tag, JSON &out)
   {
-    const auto &obj = node.as_object();
-    out += "{";
-    if (obj.empty())
-    {
-      out += "}";
-      return;
-    }
-    if (options.pretty)
+    if (tag == 2 || tag == 3)
     {
-      out += "\n";
+      std::string text;
+      if (!read_bignum(tag == 3, text))
+      {
+        return false;
+      }
+      out = JSON::number(text);
+      return true;
     }
-    for (size_t i = 0; i < obj.size(); ++i)
+    if (tag == 4)
     {
-      if (options.pretty)
+      // Decimal fraction [exponent, mantissa], kept exact as "<mantissa>e<exponent>"
+      uint8_t major = 0;
+      uint8_t info = 0;
+      uint64_t length = 0;
+      if (!read_head(major, info, length))
       {
-        out.append((depth + 1) * options.indent, ' ');
+        return false;
       }
-      out += '"';
-      out += escape_string(obj[i].first, options.escape_solidus);
-      out += options.pretty ? "" : "";
-      out += '"';
-      out += options.pretty ? ": " : ":";
-      stringify_impl(obj[i].second, options, out, depth + 1);
-      if (i + 1 < obj.size())
+      if (major != 4 || length != 2)
       {
-        out += options.pretty ? ",\n" : ",";
+        return fail("Invalid CBOR decimal fraction");
+      }
+      std::string exponent;
+      std::string mantissa;
+      if (!read_integer_text(exponent) || !read_integer_text(mantissa))
+      {
+        return false;
       }
+      out = JSON::number(exponent == "0" ? mantissa : mantissa + "e" + exponent);
+      return true;
     }
-    if (options.pretty)
+    // Other tags (dates, URIs, ...) carry no JSON meaning; decode the tagged item
+    return decode_value(out);
+  }
+
+  bool decode_simple(uint8_t info, uint64_t value, JSON &out)
+  {
+    switch (info)
     {
-      out += "\n";
-      out.append(depth * options.indent, ' ');
+    case 20:
+      out = JSON(false);
+      return true;
+    case 21:
+      out = JSON(true);
+      return true;
+    case 22:
+    case 23: // undefined
+      out = JSON();
+      return true;
+    case 25:
+    case 26:
+    case 27:
+      return decode_float(info, value, out);
+    case 31:
+      --pos;
+      return fail("Unexpected CBOR break");
+    default:
+      --pos;
+      return fail("Unsupported CBOR simple value");
     }
-    out += "}";
-    return;
   }
+
+  bool decode_array(uint64_t length, JSON &out)
+  {
+    JSON::array_t elements(resource);
+    if (length != indefinite)
+    {
+      elements.reserve(static_cast<size_t>(std::min(length, max_reserve)));
+    }
+    for (uint64_t i = 0; length == indefinite ? !at_break() : i < length; ++i)
+    {
+      JSON element;
+      if (!decode_value(element))
+      {
+        return false;
+      }
+      elements.push_back(std::move(element));
+    }
+    out = JSON::array(std::move(elements));
+    return true;
+  }
+
+  bool decode_map(uint64_t length, JSON &out)
+  {
+    JSON::object_t members(resource);
+    if (length != indefinite)
+    {
+      members.reserve(static_cast<size_t>(std::min(length, max_reserve)));
+    }
+    for (uint64_t i = 0; length == indefinite ? !at_break() : i < length; ++i)
+    {
+      const size_t key_start = pos;
+      uint8_t major = 0;
+      uint8_t info = 0;
+      uint64_t key_length = 0;
+      if (!read_head(major, info, key_length))
+      {
+        return false;
+      }
+      if (major != 3)
+      {
+        pos = key_start;
+        return fail("CBOR map keys must be text strings");
+      }
+      std::string_view view;
+      std::string owned;
+      bool is_view = false;
+      if (!read_string(3, key_length, view, owned, is_view))
+      {
+        return false;
+      }
+      JSON::object_key_t key(is_view ? view : std::string_view(owned), resource);
+      JSON value;
+      if (!decode_value(value))
+      {
+        return false;
+      }
+      members.emplace_back(std::move(key), std::move(value));
+    }
+    out = JSON::object(std::move(members));
+    return true;
   }
+};
+
+inline bool JSON::from_cbor(std::string_view data, JSON &out, JsonError *error)
+{
+  return from_cbor(data, out, ParseOptions{}, error);
 }
 
-inline std::string JSON::stringify(const StringifyOptions &options) const
+inline bool JSON::from_cbor(std::string_view data, JSON &out, const ParseOptions &options, JsonError *error)
 {
-  std::string out;
-  stringify_impl(*this, options, out, 0);
-  return out;
+  CborDecoder decoder(data, options);
+  const bool ok = decoder.decode(out);
+  if (!ok && error)
+  {
+    *error = decoder.error;
+  }
+  return ok;
 }
 
 } // namespace pixellib::core::json
@@ -26,17 +26,29 @@
 #ifndef PIXELLIB_CORE_NETWORK_HPP
 #define PIXELLIB_CORE_NETWORK_HPP
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <cctype>
+#include <charconv>
 #include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
 #include <fstream>
 #include <functional>
 #include <iomanip>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 #include <optional>
@@ -48,15 +60,27 @@
 #ifdef _WIN32
 #include <winsock2.h>
 #include <ws2tcpip.h>
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
 #pragma comment(lib, "ws2_32.lib")
 #else
 #include <arpa/inet.h>
 #include <cerrno>
 #include <cstdio>
+#include <fcntl.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <poll.h>
 #include <sys/socket.h>
 #include <unistd.h>
+#if defined(__linux__)
+#include <sys/epoll.h>
+#define PIXELLIB_NETWORK_USE_EPOLL 1
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__NetBSD__)
+#include <sys/event.h>
+#define PIXELLIB_NETWORK_USE_KQUEUE 1
+#endif
 #endif
 
 namespace pixellib::core::network
@@ -70,93 +94,140 @@ struct NetworkResult
   NetworkResult(const bool success_param, const int error_code_param, std::string message_param) : success(success_param), error_code(error_code_param), message(std::move(message_param)) {}
 };
 
-  // Implement URL encoding/decoding inside the library namespace
-  inline std::string url_encode(const std::string& value) {
-    static const char* hex = "0123456789ABCDEF";
-    std::string result;
-    for (unsigned char c : value) {
-      // Unreserved characters according to RFC3986
-      if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.' || c == '~') {
-        result.push_back(static_cast<char>(c));
-      } else {
-        result.push_back('%');
-        result.push_back(hex[c >> 4]);
-        result.push_back(hex[c & 0x0F]);
+// Non-owning URL parse: every component is a view into the parsed string,
+// which must outlive the view, so parsing allocates nothing. Accepts the same
+// forms as Url::parse; a URL without a path gets the path "/".
+struct UrlView
+{
+  std::string_view scheme;
+  std::string_view userinfo;
+  std::string_view host;
+  int port = 0;
+  std::string_view path;
+  std::string_view query;
+  std::string_view fragment;
+
+  static int default_port_for_scheme(const std::string_view scheme)
+  {
+    if (scheme == "http") return 80;
+    if (scheme == "https") return 443;
+    return 0;
+  }
+
+  static bool parse(const std::string_view url, UrlView &out)
+  {
+    out = UrlView();
+    const size_t scheme_end = url.find("://");
+    if (scheme_end == std::string_view::npos)
+    {
+      return false;
+    }
+    out.scheme = url.substr(0, scheme_end);
+
+    // authority = [userinfo@]host[:port]
+    const size_t authority_start = scheme_end + 3;
+    const size_t path_start = url.find_first_of("/?#", authority_start);
+    std::string_view hostport = url.substr(authority_start, path_start == std::string_view::npos ? std::string_view::npos : path_start - authority_start);
+    if (const size_t at_pos = hostport.find('@'); at_pos != std::string_view::npos)
+    {
+      out.userinfo = hostport.substr(0, at_pos);
+      hostport.remove_prefix(at_pos + 1);
+      if (out.userinfo.empty())
+      {
+        return false;
       }
     }
-    return result;
-  }
 
-  inline std::string url_decode(const std::string& value) {
-    std::string result;
-    size_t i = 0;
-    auto tohex = [](char ch) -> int {
-      if (ch >= '0' && ch <= '9') return ch - '0';
-      if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
-      if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
-      return 0;
-    };
-    while (i < value.size()) {
-      if (value[i] == '%' && i + 2 < value.size()) {
-        int high = tohex(value[i+1]);
-        int low  = tohex(value[i+2]);
-        unsigned char ch = static_cast<unsigned char>((high << 4) | low);
-        result.push_back(static_cast<char>(ch));
-        i += 3;
-      } else if (value[i] == '+') {
-        result.push_back(' ');
-        ++i;
-      } else {
-        result.push_back(value[i]);
-        ++i;
+    std::string_view port_str;
+    bool has_port = false;
+    if (!hostport.empty() && hostport.front() == '[')
+    {
+      // IPv6 literal [::1]
+      const size_t rb = hostport.find(']');
+      if (rb == std::string_view::npos)
+      {
+        return false;
+      }
+      out.host = hostport.substr(1, rb - 1);
+      if (rb + 1 < hostport.size())
+      {
+        if (hostport[rb + 1] != ':')
+        {
+          return false;
+        }
+        has_port = true;
+        port_str = hostport.substr(rb + 2);
       }
     }
-    return result;
-  }
+    else if (const size_t colon_pos = hostport.rfind(':'); colon_pos != std::string_view::npos && hostport.find(':') == colon_pos)
+    {
+      // host[:port] - a single colon separates the port; several mean a bare IPv6 host
+      out.host = hostport.substr(0, colon_pos);
+      has_port = true;
+      port_str = hostport.substr(colon_pos + 1);
+    }
+    else
+    {
+      out.host = hostport;
+    }
 
-  // Also provide a global namespace wrappers to preserve existing API surface in tests
-  // Global free-function wrappers to ensure tests in the global namespace see them
-  inline std::string url_encode(const std::string& value) {
-    static const char* hex = "0123456789ABCDEF";
-    std::string result;
-    for (unsigned char c : value) {
-      if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.' || c == '~') {
-        result.push_back(static_cast<char>(c));
-      } else {
-        result.push_back('%');
-        result.push_back(hex[c >> 4]);
-        result.push_back(hex[c & 0x0F]);
+    if (has_port)
+    {
+      const auto [end, ec] = std::from_chars(port_str.data(), port_str.data() + port_str.size(), out.port);
+      if (port_str.empty() || port_str.front() == '-' || ec != std::errc() || end != port_str.data() + port_str.size())
+      {
+        return false;
       }
     }
-    return result;
+    if (out.host.empty())
+    {
+      return false;
+    }
+    if (out.port == 0)
+    {
+      out.port = default_port_for_scheme(out.scheme);
+    }
+
+    if (path_start == std::string_view::npos)
+    {
+      out.path = "/";
+      return true;
+    }
+    std::string_view rest = url.substr(path_start);
+    if (const size_t hash = rest.find('#'); hash != std::string_view::npos)
+    {
+      out.fragment = rest.substr(hash + 1);
+      rest = rest.substr(0, hash);
+    }
+    if (const size_t question = rest.find('?'); question != std::string_view::npos)
+    {
+      out.query = rest.substr(question + 1);
+      rest = rest.substr(0, question);
+    }
+    out.path = rest;
+    return true;
   }
 
-  inline std::string url_decode(const std::string& value) {
-    std::string result;
-    size_t i = 0;
-    auto tohex = [](char ch) -> int {
-      if (ch >= '0' && ch <= '9') return ch - '0';
-      if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
-      if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
-      return 0;
-    };
-    while (i < value.size()) {
-      if (value[i] == '%' && i + 2 < value.size()) {
-        int high = tohex(value[i+1]);
-        int low  = tohex(value[i+2]);
-        unsigned char ch = static_cast<unsigned char>((high << 4) | low);
-        result.push_back(static_cast<char>(ch));
-        i += 3;
-      } else if (value[i] == '+') {
-        result.push_back(' ');
-        ++i;
-      } else {
-        result.push_back(value[i]);
-        ++i;
+  // Raw (still percent-encoded) value of the first name=value pair in the
+  // query whose name matches exactly; a bare "name" yields an empty value.
+  std::optional<std::string_view> query_parameter(const std::string_view name) const
+  {
+    std::string_view rest = query;
+    while (!rest.empty())
+    {
+      const size_t amp = rest.find('&');
+      const std::string_view pair = rest.substr(0, amp);
+      rest = amp == std::string_view::npos ? std::string_view() : rest.substr(amp + 1);
+      const size_t eq = pair.find('=');
+      if (pair.substr(0, eq) == name)
+      {
+        return eq == std::string_view::npos ? std::string_view() : pair.substr(eq + 1);
       }
     }
-    return result;
+    return std::nullopt;
   }
+};
+
 // Production-grade URL representation and parser
 struct Url
 {
@@ -182,225 +253,2559 @@ struct Url
     return a;
   }
 
-  std::string to_string() const
+  std::string to_string() const
+  {
+    std::string out = scheme + "://" + authority();
+    out += (path.empty() ? "/" : path);
+    if (!query.empty()) out += "?" + query;
+    if (!fragment.empty()) out += "#" + fragment;
+    return out;
+  }
+
+  static int default_port_for_scheme(const std::string_view scheme)
+  {
+    return UrlView::default_port_for_scheme(scheme);
+  }
+
+  // Parse a URL. Returns NetworkResult (success==false uses error_code 6 for invalid format to match existing API)
+  static NetworkResult parse(const std::string &url_str, Url &out)
+  {
+    UrlView view;
+    if (!UrlView::parse(url_str, view))
+    {
+      return {false, 6, "Invalid URL format"};
+    }
+    out.scheme.assign(view.scheme);
+    out.userinfo.assign(view.userinfo);
+    out.host.assign(view.host);
+    out.port = view.port;
+    out.path.assign(view.path);
+    out.query.assign(view.query);
+    out.fragment.assign(view.fragment);
+    return {true, 0, "OK"};
+  }
+};
+
+// Limits for the keep-alive connection pool behind Network::http_get/http_post.
+// A max_idle_per_host of 0 disables reuse (every request sends Connection: close);
+// a max_connections_per_host of 0 leaves concurrent connections per host unbounded.
+struct ConnectionPoolOptions
+{
+  size_t max_idle_per_host = 4;
+  size_t max_idle_connections = 32;
+  size_t max_connections_per_host = 8;
+  std::chrono::milliseconds idle_timeout{30000};
+  std::chrono::milliseconds acquire_timeout{10000};
+};
+
+struct ConnectionPoolStats
+{
+  uint64_t connections_created = 0;
+  uint64_t connections_reused = 0;
+  uint64_t connections_closed = 0;
+  size_t idle_connections = 0;
+  size_t active_connections = 0;
+};
+
+// Resolver cache shared by resolve_hostname, create_socket_connection,
+// download_file and everything built on them. Failed lookups are cached for
+// negative_ttl; a max_entries of 0 disables caching (concurrent lookups of the
+// same name are still coalesced).
+struct ResolverCacheOptions
+{
+  std::chrono::milliseconds ttl{60000};
+  std::chrono::milliseconds negative_ttl{5000};
+  size_t max_entries = 256;
+};
+
+struct ResolverCacheStats
+{
+  uint64_t hits = 0;
+  uint64_t negative_hits = 0;
+  uint64_t misses = 0;    // lookups that reached getaddrinfo
+  uint64_t coalesced = 0; // callers that waited on an in-flight lookup instead
+  uint64_t evictions = 0;
+  size_t entries = 0;
+};
+
+// Options for Network::download_file. With segments > 1 and a server that
+// honours Range requests, the file is fetched as that many parallel ranges
+// (never smaller than min_segment_size) written in place. With resume, an
+// existing partial destination is continued instead of restarted; segmented
+// downloads track their progress in "<destination>.progress".
+struct DownloadOptions
+{
+  size_t segments = 1;
+  size_t min_segment_size = 1024 * 1024;
+  bool resume = false;
+  int timeout_sec = 30;
+};
+
+// Limits for Network::http_get_many. Requests beyond max_concurrency (or
+// max_per_host for one host:port) wait in a queue; the timeout is a per-request
+// deadline measured from the moment the request leaves the queue. Zero limits
+// are treated as 1.
+struct HttpBatchOptions
+{
+  size_t max_concurrency = 64;
+  size_t max_per_host = 8;
+  std::chrono::milliseconds timeout{10000};
+};
+
+// Outcome of one request of a batch. error_code follows the rest of Network:
+// 2 resolution failed, 3 timed out, 6 invalid URL, 8 connect/send/receive error.
+struct HttpBatchResult
+{
+  size_t index = 0; // position in the urls vector
+  std::string url;
+  bool success = false;
+  int error_code = 0;
+  std::string message;
+  std::string response; // full response as returned by Network::http_get
+  std::chrono::microseconds elapsed{0};
+};
+
+struct HttpHeaderView
+{
+  std::string_view name;
+  std::string_view value;
+};
+
+// Parsed response of Network::http_get_response / http_get_stream. success
+// reports the transport (a complete response arrived); status is the HTTP
+// code. head holds the status line and header fields and the views returned
+// by headers()/header() point into it, so they stay valid while the response
+// is alive and unmodified. body is the decoded payload (chunked framing
+// removed) and stays empty for streamed responses.
+struct HttpResponse
+{
+  bool success = false;
+  int error_code = 0;
+  std::string message;
+  int status = 0;
+  std::string head;
+  std::string body;
+
+  bool ok() const { return status >= 200 && status < 300; }
+
+  std::string_view reason() const
+  {
+    const std::string_view line = std::string_view(head).substr(0, head.find("\r\n"));
+    return line.size() > 13 ? line.substr(13) : std::string_view();
+  }
+
+  std::vector<HttpHeaderView> headers() const
+  {
+    std::vector<HttpHeaderView> fields;
+    const std::string_view view(head);
+    size_t line_start = view.find("\r\n");
+    while (line_start != std::string_view::npos)
+    {
+      line_start += 2;
+      const size_t line_end = view.find("\r\n", line_start);
+      const std::string_view line = view.substr(line_start, line_end == std::string_view::npos ? std::string_view::npos : line_end - line_start);
+      if (const size_t colon = line.find(':'); colon != std::string_view::npos)
+      {
+        std::string_view value = line.substr(colon + 1);
+        while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+          value.remove_prefix(1);
+        while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
+          value.remove_suffix(1);
+        fields.push_back({line.substr(0, colon), value});
+      }
+      line_start = line_end;
+    }
+    return fields;
+  }
+
+  // Case-insensitive lookup of the first header called name; empty when absent.
+  std::string_view header(const std::string_view name) const
+  {
+    for (const auto &field : headers())
+    {
+      if (field.name.size() == name.size() &&
+          std::equal(name.begin(), name.end(), field.name.begin(), [](const char a, const char b)
+                     { return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b)); }))
+      {
+        return field.value;
+      }
+    }
+    return {};
+  }
+};
+
+// Options for Network::probe_latency: count TCP connects to host:port spread
+// over up to concurrency worker threads, each bounded by timeout_sec. The host
+// is resolved once before the first connect, so DNS time is not sampled.
+struct LatencyProbeOptions
+{
+  int port = 80;
+  size_t count = 4;
+  size_t concurrency = 4;
+  int timeout_sec = 3;
+};
+
+// Connect-time distribution in milliseconds over the successful samples.
+// Percentiles use the nearest-rank method; jitter_ms is the mean absolute
+// difference between consecutive samples in the order they were started.
+struct LatencyProbeResult
+{
+  bool success = false;
+  int error_code = 0;
+  std::string message;
+  size_t attempts = 0;
+  size_t successes = 0;
+  double min_ms = 0.0;
+  double mean_ms = 0.0;
+  double p50_ms = 0.0;
+  double p95_ms = 0.0;
+  double p99_ms = 0.0;
+  double max_ms = 0.0;
+  double jitter_ms = 0.0;
+  std::vector<double> samples_ms; // successful samples, ascending
+};
+
+// Options for Network::probe_bandwidth: streams parallel GETs of the same URL
+// whose bodies are counted and discarded. A stream stops at the end of its
+// response, after max_bytes_per_stream bytes, or when duration has elapsed
+// (zero disables either limit).
+struct BandwidthProbeOptions
+{
+  size_t streams = 4;
+  uint64_t max_bytes_per_stream = 0;
+  std::chrono::milliseconds duration{0};
+};
+
+struct BandwidthProbeResult
+{
+  bool success = false;
+  int error_code = 0;
+  std::string message;
+  size_t streams = 0; // streams that delivered a 2xx body
+  uint64_t bytes = 0;
+  std::chrono::microseconds elapsed{0};
+  double mbps = 0.0; // 2^20 bits per second, as measure_bandwidth
+};
+
+class Network
+{
+private:
+  static constexpr size_t download_buffer_size = 1024 * 1024;
+  static bool initialize_winsock()
+  {
+#ifdef _WIN32
+    WSADATA wsaData;
+    return WSAStartup(MAKEWORD(2, 2), &wsaData) == 0;
+#else
+    return true;
+#endif
+  }
+  static void cleanup_winsock()
+  {
+#ifdef _WIN32
+    WSACleanup();
+#endif
+  }
+
+  static bool is_test_mode()
+  {
+    const char *test_mode_value = std::getenv("PIXELLIB_TEST_MODE");
+    return test_mode_value && test_mode_value[0] == '1';
+  }
+  // NOLINT(readability-suspicious-call-argument)
+  static void set_socket_timeout(const int timeout_sec, const int socket_fd)
+  {
+#ifdef _WIN32
+    DWORD timeout = timeout_sec * 1000;
+    setsockopt(socket_fd, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char *>(&timeout), sizeof(timeout));
+    setsockopt(socket_fd, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char *>(&timeout), sizeof(timeout));
+#else
+    // NOLINT(misc-include-cleaner)
+    struct timeval timeout = {};
+    timeout.tv_sec = timeout_sec;
+    timeout.tv_usec = 0;
+    setsockopt(socket_fd, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char *>(&timeout), sizeof(timeout));
+    setsockopt(socket_fd, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char *>(&timeout), sizeof(timeout));
+#endif
+  }
+  static void close_socket(int sockfd)
+  {
+#ifdef _WIN32
+    closesocket(sockfd);
+#else
+    close(sockfd);
+#endif
+  }
+  // NOLINT(readability-suspicious-call-argument)
+  static int get_connection_error(bool &refused_flag, bool &timeout_flag)
+  {
+    timeout_flag = false;
+    refused_flag = false;
+
+#ifdef _WIN32
+    int error = WSAGetLastError();
+    if (error == WSAETIMEDOUT)
+    {
+      timeout_flag = true;
+      return 3;
+    }
+    if (error == WSAECONNREFUSED)
+    {
+      refused_flag = true;
+      return 4;
+    }
+#else
+    if (errno == ETIMEDOUT)
+    {
+      timeout_flag = true;
+      return 3;
+    }
+    if (errno == ECONNREFUSED)
+    {
+      refused_flag = true;
+      return 4;
+    }
+#endif
+    return 5;
+  }
+
+  struct ResolvedAddress
+  {
+    sockaddr_storage storage = {};
+    socklen_t length = 0;
+  };
+
+  // Outcome of one getaddrinfo call: status is its return code (0 on success)
+  // and addresses keeps every stream address in the order returned.
+  struct Resolution
+  {
+    int status = 0;
+    std::vector<ResolvedAddress> addresses;
+  };
+
+  static std::shared_ptr<const Resolution> lookup_host(const std::string &hostname)
+  {
+    auto resolution = std::make_shared<Resolution>();
+    if (test_resolve_hook)
+    {
+      if (int forced = test_resolve_hook(hostname); forced != 0)
+      {
+        resolution->status = EAI_NONAME;
+        return resolution;
+      }
+    }
+    if (!initialize_winsock())
+    {
+      resolution->status = EAI_FAIL;
+      return resolution;
+    }
+    struct addrinfo hints = {}, *result = nullptr;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    resolution->status = getaddrinfo(hostname.c_str(), nullptr, &hints, &result);
+    if (resolution->status == 0)
+    {
+      for (const struct addrinfo *entry = result; entry; entry = entry->ai_next)
+      {
+        if ((entry->ai_family != AF_INET && entry->ai_family != AF_INET6) ||
+            entry->ai_addrlen > sizeof(sockaddr_storage))
+        {
+          continue;
+        }
+        ResolvedAddress address;
+        std::memcpy(&address.storage, entry->ai_addr, entry->ai_addrlen);
+        address.length = static_cast<socklen_t>(entry->ai_addrlen);
+        resolution->addresses.push_back(address);
+      }
+      freeaddrinfo(result);
+    }
+    cleanup_winsock();
+    return resolution;
+  }
+
+  static std::string address_to_string(const ResolvedAddress &address)
+  {
+    std::array<char, INET6_ADDRSTRLEN> ip_str{};
+    if (address.storage.ss_family == AF_INET)
+    {
+      const auto ipv4 = reinterpret_cast<const struct sockaddr_in *>(&address.storage);
+      inet_ntop(AF_INET, &ipv4->sin_addr, ip_str.data(), INET_ADDRSTRLEN);
+    }
+    else if (address.storage.ss_family == AF_INET6)
+    {
+      const auto ipv6 = reinterpret_cast<const struct sockaddr_in6 *>(&address.storage);
+      inet_ntop(AF_INET6, &ipv6->sin6_addr, ip_str.data(), INET6_ADDRSTRLEN);
+    }
+    return std::string(ip_str.data());
+  }
+
+  // Connects to the first reachable address of a resolution. socket_failed is
+  // set when no socket could be created for any of the addresses.
+  static int connect_resolved(const Resolution &resolution, const int port, const int timeout_sec, bool &socket_failed)
+  {
+    socket_failed = false;
+    if (!initialize_winsock())
+    {
+      return -1;
+    }
+    bool created_any = false;
+    for (const auto &address : resolution.addresses)
+    {
+      ResolvedAddress target = address;
+      if (target.storage.ss_family == AF_INET)
+      {
+        reinterpret_cast<struct sockaddr_in *>(&target.storage)->sin_port = htons(static_cast<uint16_t>(port));
+      }
+      else
+      {
+        reinterpret_cast<struct sockaddr_in6 *>(&target.storage)->sin6_port = htons(static_cast<uint16_t>(port));
+      }
+
+      const int sockfd = socket(target.storage.ss_family, SOCK_STREAM, IPPROTO_TCP);
+      if (sockfd < 0)
+      {
+        continue;
+      }
+      created_any = true;
+      set_socket_timeout(timeout_sec, sockfd);
+      if (connect(sockfd, reinterpret_cast<struct sockaddr *>(&target.storage), target.length) == 0)
+      {
+        cleanup_winsock();
+        return sockfd;
+      }
+      close_socket(sockfd);
+    }
+    socket_failed = !created_any && !resolution.addresses.empty();
+    cleanup_winsock();
+    return -1;
+  }
+
+  // Thread-safe hostname cache with per-entry expiry, LRU eviction and
+  // single-flight lookups: concurrent callers for the same name wait for the
+  // one getaddrinfo call in progress instead of issuing their own.
+  class ResolverCache
+  {
+  public:
+    std::shared_ptr<const Resolution> resolve(const std::string &hostname)
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (const auto it = entries_.find(hostname); it != entries_.end())
+      {
+        if (std::chrono::steady_clock::now() < it->second.expires)
+        {
+          lru_.splice(lru_.begin(), lru_, it->second.position);
+          ++(it->second.result->status == 0 ? stats_.hits : stats_.negative_hits);
+          return it->second.result;
+        }
+        lru_.erase(it->second.position);
+        entries_.erase(it);
+      }
+
+      if (const auto pending = in_flight_.find(hostname); pending != in_flight_.end())
+      {
+        const std::shared_ptr<InFlight> flight = pending->second;
+        ++stats_.coalesced;
+        completed_.wait(lock, [&flight] { return flight->result != nullptr; });
+        return flight->result;
+      }
+
+      const auto flight = std::make_shared<InFlight>();
+      in_flight_.emplace(hostname, flight);
+      ++stats_.misses;
+      lock.unlock();
+
+      std::shared_ptr<const Resolution> result = lookup_host(hostname);
+
+      lock.lock();
+      flight->result = result;
+      in_flight_.erase(hostname);
+      const auto ttl = result->status == 0 ? options_.ttl : options_.negative_ttl;
+      if (options_.max_entries > 0 && ttl.count() > 0)
+      {
+        if (const auto stale = entries_.find(hostname); stale != entries_.end())
+        {
+          lru_.erase(stale->second.position);
+        }
+        lru_.push_front(hostname);
+        entries_[hostname] = Entry{result, std::chrono::steady_clock::now() + ttl, lru_.begin()};
+        trim();
+      }
+      lock.unlock();
+      completed_.notify_all();
+      return result;
+    }
+
+    void configure(const ResolverCacheOptions &options)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      options_ = options;
+      trim();
+    }
+
+    ResolverCacheOptions options() const
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      return options_;
+    }
+
+    void clear()
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      entries_.clear();
+      lru_.clear();
+    }
+
+    ResolverCacheStats stats() const
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ResolverCacheStats out = stats_;
+      out.entries = entries_.size();
+      return out;
+    }
+
+  private:
+    struct Entry
+    {
+      std::shared_ptr<const Resolution> result;
+      std::chrono::steady_clock::time_point expires;
+      std::list<std::string>::iterator position;
+    };
+
+    struct InFlight
+    {
+      std::shared_ptr<const Resolution> result;
+    };
+
+    void trim()
+    {
+      while (entries_.size() > options_.max_entries)
+      {
+        entries_.erase(lru_.back());
+        lru_.pop_back();
+        ++stats_.evictions;
+      }
+    }
+
+    mutable std::mutex mutex_;
+    std::condition_variable completed_;
+    ResolverCacheOptions options_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::list<std::string> lru_; // most recently used first
+    std::unordered_map<std::string, std::shared_ptr<InFlight>> in_flight_;
+    ResolverCacheStats stats_;
+  };
+
+  static ResolverCache &resolver_cache()
+  {
+    static ResolverCache cache;
+    return cache;
+  }
+
+  // Idle connections are only handed out again when the peer has neither closed
+  // them nor sent unsolicited bytes; a zero-timeout poll detects both cases.
+  static bool is_connection_idle(const int socket_fd)
+  {
+#ifdef _WIN32
+    WSAPOLLFD pfd = {};
+    pfd.fd = static_cast<SOCKET>(socket_fd);
+    pfd.events = POLLRDNORM;
+    return WSAPoll(&pfd, 1, 0) == 0;
+#else
+    struct pollfd pfd = {};
+    pfd.fd = socket_fd;
+    pfd.events = POLLIN;
+    return poll(&pfd, 1, 0) == 0;
+#endif
+  }
+
+  // Per-host pool of HTTP/1.1 keep-alive connections. Connections are keyed by
+  // host:port, reused most-recently-released first, and closed once they exceed
+  // the idle timeout or the idle limits. Sockets are always closed outside the lock.
+  class ConnectionPool
+  {
+  public:
+    ConnectionPool() = default;
+    ConnectionPool(const ConnectionPool &) = delete;
+    ConnectionPool &operator=(const ConnectionPool &) = delete;
+    ~ConnectionPool() { clear(); }
+
+    void configure(const ConnectionPoolOptions &options)
+    {
+      std::vector<int> to_close;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        options_ = options;
+        for (auto &[key, entry] : hosts_)
+        {
+          while (entry.idle.size() > options_.max_idle_per_host)
+          {
+            pop_oldest(entry, to_close);
+          }
+        }
+        while (idle_total_ > options_.max_idle_connections)
+        {
+          evict_oldest(to_close);
+        }
+        stats_.connections_closed += to_close.size();
+      }
+      released_.notify_all();
+      close_all(to_close);
+    }
+
+    ConnectionPoolOptions options() const
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      return options_;
+    }
+
+    bool reuse_enabled() const
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      return options_.max_idle_per_host > 0 && options_.max_idle_connections > 0;
+    }
+
+    // Returns a connected socket for host:port, or -1. Waits up to acquire_timeout
+    // while the host is at max_connections_per_host.
+    int acquire(const std::string &host, const int port, bool &reused)
+    {
+      reused = false;
+      const std::string host_key = key(host, port);
+      std::vector<int> to_close;
+      int socket_fd = -1;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        HostConnections &entry = hosts_[host_key];
+        const auto deadline = std::chrono::steady_clock::now() + options_.acquire_timeout;
+        for (;;)
+        {
+          expire(entry, std::chrono::steady_clock::now(), to_close);
+          while (!entry.idle.empty())
+          {
+            const int candidate = entry.idle.back().socket_fd;
+            entry.idle.pop_back();
+            --idle_total_;
+            if (is_connection_idle(candidate))
+            {
+              socket_fd = candidate;
+              break;
+            }
+            to_close.push_back(candidate);
+          }
+          if (socket_fd >= 0)
+          {
+            reused = true;
+            ++entry.active;
+            ++stats_.connections_reused;
+            break;
+          }
+          if (options_.max_connections_per_host == 0 || entry.active < options_.max_connections_per_host)
+          {
+            ++entry.active; // reserve the slot while connecting outside the lock
+            break;
+          }
+          if (released_.wait_until(lock, deadline) == std::cv_status::timeout &&
+              entry.idle.empty() && entry.active >= options_.max_connections_per_host)
+          {
+            stats_.connections_closed += to_close.size();
+            lock.unlock();
+            close_all(to_close);
+            return -1;
+          }
+        }
+        stats_.connections_closed += to_close.size();
+      }
+      close_all(to_close);
+      if (reused)
+      {
+        return socket_fd;
+      }
+
+      socket_fd = create_socket_connection(host, port);
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (socket_fd < 0)
+        {
+          --hosts_[host_key].active;
+        }
+        else
+        {
+          ++stats_.connections_created;
+        }
+      }
+      if (socket_fd < 0)
+      {
+        released_.notify_all();
+      }
+      return socket_fd;
+    }
+
+    // Hands a socket back after a request. Only sockets whose response was fully
+    // framed and allowed keep-alive should be released as reusable.
+    void release(const std::string &host, const int port, const int socket_fd, const bool reusable)
+    {
+      std::vector<int> to_close;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        HostConnections &entry = hosts_[key(host, port)];
+        if (entry.active > 0)
+        {
+          --entry.active;
+        }
+        if (reusable && options_.max_idle_per_host > 0 && options_.max_idle_connections > 0)
+        {
+          const auto now = std::chrono::steady_clock::now();
+          expire(entry, now, to_close);
+          if (entry.idle.size() >= options_.max_idle_per_host)
+          {
+            pop_oldest(entry, to_close);
+          }
+          while (idle_total_ >= options_.max_idle_connections)
+          {
+            evict_oldest(to_close);
+          }
+          entry.idle.push_back({socket_fd, now});
+          ++idle_total_;
+        }
+        else
+        {
+          to_close.push_back(socket_fd);
+        }
+        stats_.connections_closed += to_close.size();
+      }
+      released_.notify_all();
+      close_all(to_close);
+    }
+
+    void clear()
+    {
+      std::vector<int> to_close;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &[key, entry] : hosts_)
+        {
+          for (const auto &connection : entry.idle)
+          {
+            to_close.push_back(connection.socket_fd);
+          }
+          entry.idle.clear();
+        }
+        idle_total_ = 0;
+        stats_.connections_closed += to_close.size();
+      }
+      released_.notify_all();
+      close_all(to_close);
+    }
+
+    ConnectionPoolStats stats() const
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ConnectionPoolStats out = stats_;
+      out.idle_connections = idle_total_;
+      out.active_connections = 0;
+      for (const auto &[key, entry] : hosts_)
+      {
+        out.active_connections += entry.active;
+      }
+      return out;
+    }
+
+  private:
+    struct IdleConnection
+    {
+      int socket_fd;
+      std::chrono::steady_clock::time_point since;
+    };
+
+    struct HostConnections
+    {
+      std::vector<IdleConnection> idle; // oldest first
+      size_t active = 0;
+    };
+
+    static std::string key(const std::string &host, const int port)
+    {
+      return host + ":" + std::to_string(port);
+    }
+
+    static void close_all(const std::vector<int> &sockets)
+    {
+      for (const int socket_fd : sockets)
+      {
+        close_socket_connection(socket_fd);
+      }
+    }
+
+    void expire(HostConnections &entry, const std::chrono::steady_clock::time_point now, std::vector<int> &to_close)
+    {
+      while (!entry.idle.empty() && now - entry.idle.front().since >= options_.idle_timeout)
+      {
+        pop_oldest(entry, to_close);
+      }
+    }
+
+    void pop_oldest(HostConnections &entry, std::vector<int> &to_close)
+    {
+      to_close.push_back(entry.idle.front().socket_fd);
+      entry.idle.erase(entry.idle.begin());
+      --idle_total_;
+    }
+
+    void evict_oldest(std::vector<int> &to_close)
+    {
+      HostConnections *oldest = nullptr;
+      for (auto &[key, entry] : hosts_)
+      {
+        if (!entry.idle.empty() && (!oldest || entry.idle.front().since < oldest->idle.front().since))
+        {
+          oldest = &entry;
+        }
+      }
+      if (oldest)
+      {
+        pop_oldest(*oldest, to_close);
+      }
+      else
+      {
+        idle_total_ = 0;
+      }
+    }
+
+    mutable std::mutex mutex_;
+    std::condition_variable released_;
+    ConnectionPoolOptions options_;
+    std::unordered_map<std::string, HostConnections> hosts_;
+    size_t idle_total_ = 0;
+    ConnectionPoolStats stats_;
+  };
+
+  static ConnectionPool &connection_pool()
+  {
+    static ConnectionPool pool;
+    return pool;
+  }
+
+  static bool iequals(const std::string_view lhs, const std::string_view rhs)
+  {
+    return lhs.size() == rhs.size() &&
+           std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](const char a, const char b)
+                      { return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b)); });
+  }
+
+  // True when a comma-separated header value (Connection, Transfer-Encoding) lists token.
+  static bool header_has_token(std::string_view value, const std::string_view token)
+  {
+    while (!value.empty())
+    {
+      const size_t comma = value.find(',');
+      std::string_view item = value.substr(0, comma);
+      while (!item.empty() && (item.front() == ' ' || item.front() == '\t'))
+        item.remove_prefix(1);
+      while (!item.empty() && (item.back() == ' ' || item.back() == '\t'))
+        item.remove_suffix(1);
+      if (iequals(item, token))
+      {
+        return true;
+      }
+      if (comma == std::string_view::npos)
+      {
+        break;
+      }
+      value.remove_prefix(comma + 1);
+    }
+    return false;
+  }
+
+  // Incremental message framing state for one HTTP/1.x response.
+  struct ResponseFraming
+  {
+    size_t start = 0;                    // status line of the current (non-1xx) response
+    size_t scanned = 0;                  // header terminator search resumes here
+    size_t body = std::string::npos;     // first body byte, npos until headers are complete
+    size_t content_length = 0;
+    size_t chunk_pos = 0;                // next chunk-size line in a chunked body
+    int status = 0;
+    bool chunked = false;
+    bool until_close = false;
+    bool keep_alive = false;
+  };
+
+  static std::string_view trim_header_value(std::string_view value)
+  {
+    while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+      value.remove_prefix(1);
+    while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
+      value.remove_suffix(1);
+    return value;
+  }
+
+  // Value of the first header called name in a response head (status line and
+  // fields, without the blank line); empty when absent.
+  static std::string_view header_value(const std::string_view head, const std::string_view name)
+  {
+    size_t line_start = head.find("\r\n");
+    while (line_start != std::string_view::npos)
+    {
+      line_start += 2;
+      const size_t line_end = head.find("\r\n", line_start);
+      const std::string_view line = head.substr(line_start, line_end == std::string_view::npos ? std::string_view::npos : line_end - line_start);
+      if (const size_t colon = line.find(':'); colon != std::string_view::npos && iequals(line.substr(0, colon), name))
+      {
+        return trim_header_value(line.substr(colon + 1));
+      }
+      line_start = line_end;
+    }
+    return {};
+  }
+
+  // Parses the status line and framing headers once data holds the complete
+  // response head, skipping interim 1xx responses. Returns 1 when framing.body
+  // is set, 0 while more bytes are needed and -1 for a malformed head.
+  static int parse_response_head(const std::string &data, ResponseFraming &framing)
+  {
+    constexpr size_t npos = std::string::npos;
+    while (framing.body == npos)
+    {
+      const size_t header_end = data.find("\r\n\r\n", framing.scanned);
+      if (header_end == npos)
+      {
+        framing.scanned = data.size() > 3 ? std::max(framing.start, data.size() - 3) : framing.start;
+        return 0;
+      }
+
+      const std::string_view head(data.data() + framing.start, header_end - framing.start);
+      const size_t status_end = head.find("\r\n");
+      const std::string_view status_line = head.substr(0, status_end);
+      if (status_line.size() < 12 || status_line.substr(0, 7) != "HTTP/1." || status_line[8] != ' ')
+      {
+        return -1;
+      }
+      const bool http11 = status_line[7] != '0';
+      int code = 0;
+      if (const auto [ptr, ec] = std::from_chars(status_line.data() + 9, status_line.data() + 12, code);
+          ec != std::errc() || ptr != status_line.data() + 12)
+      {
+        return -1;
+      }
+
+      bool has_length = false;
+      bool close = false;
+      bool keep_alive_token = false;
+      size_t length = 0;
+      std::string_view fields = status_end == std::string_view::npos ? std::string_view() : head.substr(status_end + 2);
+      while (!fields.empty())
+      {
+        const size_t line_end = fields.find("\r\n");
+        const std::string_view line = fields.substr(0, line_end);
+        fields = line_end == std::string_view::npos ? std::string_view() : fields.substr(line_end + 2);
+        const size_t colon = line.find(':');
+        if (colon == std::string_view::npos)
+        {
+          continue;
+        }
+        const std::string_view name = line.substr(0, colon);
+        const std::string_view value = trim_header_value(line.substr(colon + 1));
+
+        if (iequals(name, "Content-Length"))
+        {
+          size_t parsed = 0;
+          if (const auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), parsed);
+              ec != std::errc() || ptr != value.data() + value.size() || (has_length && parsed != length))
+          {
+            return -1;
+          }
+          has_length = true;
+          length = parsed;
+        }
+        else if (iequals(name, "Transfer-Encoding"))
+        {
+          framing.chunked = header_has_token(value, "chunked");
+        }
+        else if (iequals(name, "Connection"))
+        {
+          close = close || header_has_token(value, "close");
+          keep_alive_token = keep_alive_token || header_has_token(value, "keep-alive");
+        }
+      }
+
+      framing.body = header_end + 4;
+      if (code >= 100 && code < 200 && code != 101)
+      {
+        // Interim response (e.g. 100 Continue): the real response follows it.
+        framing = ResponseFraming();
+        framing.start = header_end + 4;
+        framing.scanned = framing.start;
+        continue;
+      }
+
+      framing.status = code;
+      framing.keep_alive = !close && (http11 || keep_alive_token) && code != 101;
+      if (code == 101 || code == 204 || code == 304)
+      {
+        framing.chunked = false;
+        framing.content_length = 0;
+      }
+      else if (framing.chunked)
+      {
+        framing.chunk_pos = framing.body;
+      }
+      else if (has_length)
+      {
+        framing.content_length = length;
+      }
+      else
+      {
+        framing.until_close = true;
+        framing.keep_alive = false;
+      }
+    }
+    return 1;
+  }
+
+  // Returns the offset one past the end of the response once data holds a whole
+  // message, 0 while more bytes are needed, and npos for malformed framing.
+  // Bodies delimited by connection close never complete here; the caller ends
+  // them on EOF.
+  static size_t frame_http_response(const std::string &data, ResponseFraming &framing)
+  {
+    constexpr size_t npos = std::string::npos;
+    if (const int head = parse_response_head(data, framing); head <= 0)
+    {
+      return head == 0 ? 0 : npos;
+    }
+
+    if (framing.until_close)
+    {
+      return 0;
+    }
+    if (!framing.chunked)
+    {
+      return data.size() - framing.body >= framing.content_length ? framing.body + framing.content_length : 0;
+    }
+
+    for (;;)
+    {
+      const size_t line_end = data.find("\r\n", framing.chunk_pos);
+      if (line_end == npos)
+      {
+        return 0;
+      }
+      const char *first = data.data() + framing.chunk_pos;
+      size_t chunk_size = 0;
+      const auto [ptr, ec] = std::from_chars(first, data.data() + line_end, chunk_size, 16);
+      if (ec != std::errc() || ptr == first)
+      {
+        return npos;
+      }
+      if (chunk_size == 0)
+      {
+        // Last chunk: an optional trailer section ends with an empty line.
+        if (data.compare(line_end + 2, 2, "\r\n") == 0)
+        {
+          return line_end + 4;
+        }
+        const size_t trailer_end = data.find("\r\n\r\n", line_end + 2);
+        return trailer_end == npos ? 0 : trailer_end + 4;
+      }
+      if (data.size() - (line_end + 2) < chunk_size + 2)
+      {
+        return 0;
+      }
+      framing.chunk_pos = line_end + 2 + chunk_size + 2;
+    }
+  }
+
+  static bool send_all(const int socket_fd, const std::string &data)
+  {
+#ifdef MSG_NOSIGNAL
+    constexpr int send_flags = MSG_NOSIGNAL; // a peer-closed keep-alive socket must not raise SIGPIPE
+#else
+    constexpr int send_flags = 0;
+#endif
+    size_t offset = 0;
+    while (offset < data.size())
+    {
+      const ssize_t sent = send(socket_fd, data.data() + offset, data.size() - offset, send_flags);
+      if (sent <= 0)
+      {
+        return false;
+      }
+      offset += static_cast<size_t>(sent);
+    }
+    return true;
+  }
+
+  // Reads exactly one response. keep_alive is set only when the message was
+  // framed by Content-Length or chunked encoding and the server allows reuse.
+  static bool read_http_response(const int socket_fd, std::string &response, bool &keep_alive)
+  {
+    keep_alive = false;
+    ResponseFraming framing;
+    std::array<char, 16384> buffer{};
+    for (;;)
+    {
+      const ssize_t received = recv(socket_fd, buffer.data(), buffer.size(), 0);
+      if (received < 0)
+      {
+        return false;
+      }
+      if (received == 0)
+      {
+        return framing.until_close;
+      }
+      response.append(buffer.data(), static_cast<size_t>(received));
+      const size_t message_end = frame_http_response(response, framing);
+      if (message_end == std::string::npos)
+      {
+        return false;
+      }
+      if (message_end != 0)
+      {
+        // Bytes past the message would desynchronise the next request on this socket.
+        keep_alive = framing.keep_alive && message_end == response.size();
+        response.resize(message_end);
+        return true;
+      }
+    }
+  }
+
+  // Sends one request over a pooled connection. A reused connection that the
+  // server closed while idle yields no response bytes; the request is then
+  // retried once on a fresh connection.
+  static std::string send_pooled_request(const std::string &host, const int port, const std::string &request)
+  {
+    ConnectionPool &pool = connection_pool();
+    for (int attempt = 0; attempt < 2; ++attempt)
+    {
+      bool reused = false;
+      const int socket_fd = pool.acquire(host, port, reused);
+      if (socket_fd < 0)
+      {
+        return "Failed to connect";
+      }
+
+      std::string response;
+      bool keep_alive = false;
+      const bool sent = send_all(socket_fd, request);
+      const bool complete = sent && read_http_response(socket_fd, response, keep_alive);
+      pool.release(host, port, socket_fd, complete && keep_alive);
+
+      if (reused && response.empty())
+      {
+        continue;
+      }
+      if (!sent)
+      {
+        return "Failed to send request";
+      }
+      if (response.empty())
+      {
+        return "No response received";
+      }
+      return response;
+    }
+    return "No response received";
+  }
+
+  static bool set_non_blocking(const int socket_fd)
+  {
+#ifdef _WIN32
+    u_long mode = 1;
+    return ioctlsocket(static_cast<SOCKET>(socket_fd), FIONBIO, &mode) == 0;
+#else
+    const int flags = fcntl(socket_fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(socket_fd, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+  }
+
+  static bool last_error_would_block(const bool connecting)
+  {
+#ifdef _WIN32
+    const int error = WSAGetLastError();
+    return error == WSAEWOULDBLOCK || (connecting && error == WSAEINPROGRESS);
+#else
+    return connecting ? errno == EINPROGRESS : (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+#endif
+  }
+
+  // Readiness notification for the batch engine: epoll on Linux, kqueue on
+  // macOS/BSD, WSAPoll on Windows and poll() elsewhere. Each descriptor waits
+  // for either writability (connect/send) or readability (receive).
+  class EventPoller
+  {
+  public:
+    struct Event
+    {
+      int fd;
+      bool readable;
+      bool writable;
+    };
+
+    EventPoller()
+    {
+#if defined(PIXELLIB_NETWORK_USE_EPOLL)
+      handle_ = epoll_create1(EPOLL_CLOEXEC);
+#elif defined(PIXELLIB_NETWORK_USE_KQUEUE)
+      handle_ = kqueue();
+#endif
+    }
+
+    ~EventPoller()
+    {
+#if defined(PIXELLIB_NETWORK_USE_EPOLL) || defined(PIXELLIB_NETWORK_USE_KQUEUE)
+      if (handle_ >= 0)
+      {
+        close(handle_);
+      }
+#endif
+    }
+
+    EventPoller(const EventPoller &) = delete;
+    EventPoller &operator=(const EventPoller &) = delete;
+
+    bool valid() const
+    {
+#if defined(PIXELLIB_NETWORK_USE_EPOLL) || defined(PIXELLIB_NETWORK_USE_KQUEUE)
+      return handle_ >= 0;
+#else
+      return true;
+#endif
+    }
+
+    bool watch(const int fd, const bool want_write)
+    {
+#if defined(PIXELLIB_NETWORK_USE_EPOLL)
+      struct epoll_event event = {};
+      event.events = want_write ? EPOLLOUT : EPOLLIN;
+      event.data.fd = fd;
+      if (epoll_ctl(handle_, EPOLL_CTL_MOD, fd, &event) == 0)
+      {
+        return true;
+      }
+      return errno == ENOENT && epoll_ctl(handle_, EPOLL_CTL_ADD, fd, &event) == 0;
+#elif defined(PIXELLIB_NETWORK_USE_KQUEUE)
+      struct kevent changes[2];
+      EV_SET(&changes[0], fd, EVFILT_READ, EV_ADD | (want_write ? EV_DISABLE : EV_ENABLE), 0, 0, nullptr);
+      EV_SET(&changes[1], fd, EVFILT_WRITE, EV_ADD | (want_write ? EV_ENABLE : EV_DISABLE), 0, 0, nullptr);
+      return kevent(handle_, changes, 2, nullptr, 0, nullptr) == 0;
+#else
+      const short events = want_write ? POLLOUT : POLLIN;
+      if (const auto it = slots_.find(fd); it != slots_.end())
+      {
+        fds_[it->second].events = events;
+        return true;
+      }
+      slots_.emplace(fd, fds_.size());
+      fds_.push_back({});
+      fds_.back().fd = static_cast<decltype(fds_.back().fd)>(fd);
+      fds_.back().events = events;
+      return true;
+#endif
+    }
+
+    void forget(const int fd)
+    {
+#if defined(PIXELLIB_NETWORK_USE_EPOLL)
+      epoll_ctl(handle_, EPOLL_CTL_DEL, fd, nullptr);
+#elif defined(PIXELLIB_NETWORK_USE_KQUEUE)
+      struct kevent changes[2];
+      EV_SET(&changes[0], fd, EVFILT_READ, EV_DELETE, 0, 0, nullptr);
+      EV_SET(&changes[1], fd, EVFILT_WRITE, EV_DELETE, 0, 0, nullptr);
+      kevent(handle_, changes, 2, nullptr, 0, nullptr);
+#else
+      const auto it = slots_.find(fd);
+      if (it == slots_.end())
+      {
+        return;
+      }
+      const size_t slot = it->second;
+      slots_.erase(it);
+      if (slot + 1 != fds_.size())
+      {
+        fds_[slot] = fds_.back();
+        slots_[static_cast<int>(fds_[slot].fd)] = slot;
+      }
+      fds_.pop_back();
+#endif
+    }
+
+    // Waits up to timeout_ms and fills events; returns false on a poller failure.
+    bool wait(const int timeout_ms, std::vector<Event> &events)
+    {
+      events.clear();
+#if defined(PIXELLIB_NETWORK_USE_EPOLL)
+      std::array<struct epoll_event, 256> ready{};
+      const int count = epoll_wait(handle_, ready.data(), static_cast<int>(ready.size()), timeout_ms);
+      if (count < 0)
+      {
+        return errno == EINTR;
+      }
+      for (int i = 0; i < count; ++i)
+      {
+        const uint32_t flags = ready[static_cast<size_t>(i)].events;
+        const bool failed = (flags & (EPOLLERR | EPOLLHUP)) != 0;
+        events.push_back({ready[static_cast<size_t>(i)].data.fd, failed || (flags & EPOLLIN) != 0, failed || (flags & EPOLLOUT) != 0});
+      }
+#elif defined(PIXELLIB_NETWORK_USE_KQUEUE)
+      std::array<struct kevent, 256> ready{};
+      struct timespec timeout = {};
+      timeout.tv_sec = timeout_ms / 1000;
+      timeout.tv_nsec = static_cast<long>(timeout_ms % 1000) * 1000000L;
+      const int count = kevent(handle_, nullptr, 0, ready.data(), static_cast<int>(ready.size()), &timeout);
+      if (count < 0)
+      {
+        return errno == EINTR;
+      }
+      for (int i = 0; i < count; ++i)
+      {
+        const auto &event = ready[static_cast<size_t>(i)];
+        const bool failed = (event.flags & (EV_ERROR | EV_EOF)) != 0;
+        events.push_back({static_cast<int>(event.ident), failed || event.filter == EVFILT_READ, failed || event.filter == EVFILT_WRITE});
+      }
+#else
+      if (fds_.empty())
+      {
+        return true;
+      }
+#ifdef _WIN32
+      const int count = WSAPoll(fds_.data(), static_cast<ULONG>(fds_.size()), timeout_ms);
+#else
+      const int count = poll(fds_.data(), static_cast<nfds_t>(fds_.size()), timeout_ms);
+      if (count < 0 && errno == EINTR)
+      {
+        return true;
+      }
+#endif
+      if (count < 0)
+      {
+        return false;
+      }
+      for (const auto &entry : fds_)
+      {
+        if (entry.revents == 0)
+        {
+          continue;
+        }
+        const bool failed = (entry.revents & (POLLERR | POLLHUP | POLLNVAL)) != 0;
+        events.push_back({static_cast<int>(entry.fd), failed || (entry.revents & POLLIN) != 0, failed || (entry.revents & POLLOUT) != 0});
+      }
+#endif
+      return true;
+    }
+
+  private:
+#if defined(PIXELLIB_NETWORK_USE_EPOLL) || defined(PIXELLIB_NETWORK_USE_KQUEUE)
+    int handle_ = -1;
+#elif defined(_WIN32)
+    std::vector<WSAPOLLFD> fds_;
+    std::unordered_map<int, size_t> slots_;
+#else
+    std::vector<struct pollfd> fds_;
+    std::unordered_map<int, size_t> slots_;
+#endif
+  };
+
+  // One http_get_many call: a single-threaded state machine over non-blocking
+  // sockets (connect -> send -> receive) driven by EventPoller. Every distinct
+  // host is resolved before the loop starts, so the loop never blocks in
+  // getaddrinfo. Keep-alive connections are reused for later requests to the
+  // same host:port within the batch and closed when it ends.
+  class HttpBatch
+  {
+  public:
+    HttpBatch(const std::vector<std::string> &urls, const std::function<void(const HttpBatchResult &)> &callback, const HttpBatchOptions &options)
+        : urls_(urls), callback_(callback), max_concurrency_(std::max<size_t>(1, options.max_concurrency)),
+          max_per_host_(std::max<size_t>(1, options.max_per_host)), timeout_(options.timeout)
+    {
+    }
+
+    HttpBatch(const HttpBatch &) = delete;
+    HttpBatch &operator=(const HttpBatch &) = delete;
+
+    ~HttpBatch()
+    {
+      for (const auto &[fd, request] : active_)
+      {
+        close_socket(fd);
+      }
+      for (const auto &[key, host] : hosts_)
+      {
+        for (const int fd : host.idle)
+        {
+          close_socket(fd);
+        }
+      }
+    }
+
+    size_t run()
+    {
+      for (size_t i = 0; i < urls_.size(); ++i)
+      {
+        queue(i);
+      }
+      if (!poller_.valid())
+      {
+        fail_queued(8, "Failed to create event poller");
+        return succeeded_;
+      }
+      resolve_hosts();
+
+      std::vector<EventPoller::Event> events;
+      fill();
+      while (!active_.empty())
+      {
+        const auto now = std::chrono::steady_clock::now();
+        auto next_deadline = now + std::chrono::hours(1);
+        for (const auto &[fd, request] : active_)
+        {
+          next_deadline = std::min(next_deadline, request.deadline);
+        }
+        const auto wait_ms = std::chrono::duration_cast<std::chrono::milliseconds>(next_deadline - now).count();
+        if (!poller_.wait(static_cast<int>(std::clamp<long long>(wait_ms + 1, 0, 60000)), events))
+        {
+          fail_active(8, "Event poller failure");
+          break;
+        }
+        for (const auto &event : events)
+        {
+          if (const auto it = active_.find(event.fd); it != active_.end())
+          {
+            advance(it->first, event.readable, event.writable);
+          }
+        }
+        expire(std::chrono::steady_clock::now());
+        fill();
+      }
+      fail_queued(8, "Event poller failure");
+      return succeeded_;
+    }
+
+  private:
+    enum class Stage
+    {
+      CONNECTING,
+      SENDING,
+      RECEIVING
+    };
+
+    struct Request
+    {
+      size_t index = 0;
+      std::string key;
+      int port = 0;
+      std::shared_ptr<const Resolution> resolution;
+      size_t address = 0;
+      Stage stage = Stage::CONNECTING;
+      bool reused = false;
+      std::string request;
+      size_t sent = 0;
+      std::string response;
+      ResponseFraming framing;
+      std::chrono::steady_clock::time_point started;
+      std::chrono::steady_clock::time_point deadline;
+    };
+
+    struct HostQueue
+    {
+      std::string host;
+      int port = 0;
+      std::shared_ptr<const Resolution> resolution;
+      std::vector<size_t> pending; // url indices, consumed front to back
+      size_t next = 0;
+      size_t active = 0;
+      std::vector<int> idle;
+    };
+
+    void queue(const size_t index)
+    {
+      Url parsed;
+      if (!Url::parse(urls_[index], parsed).success || parsed.scheme != "http" || parsed.port <= 0 || parsed.port > 65535)
+      {
+        report(index, std::chrono::steady_clock::now(), false, 6, "Invalid URL format", std::string());
+        return;
+      }
+      const std::string key = parsed.host + ":" + std::to_string(parsed.port);
+      auto [it, inserted] = hosts_.try_emplace(key);
+      if (inserted)
+      {
+        it->second.host = parsed.host;
+        it->second.port = parsed.port;
+        host_order_.push_back(key);
+      }
+      it->second.pending.push_back(index);
+      requests_.emplace(index, "GET " + parsed.path + " HTTP/1.1\r\nHost: " + parsed.host +
+                                   "\r\nConnection: keep-alive\r\nUser-Agent: pixelLib/1.0\r\n\r\n");
+    }
+
+    // Looks up every queued host, on up to max_concurrency threads so one slow
+    // name does not hold up the others. Each worker writes only its own entry.
+    void resolve_hosts()
+    {
+      std::atomic<size_t> next{0};
+      const auto work = [this, &next] {
+        for (size_t i = next++; i < host_order_.size(); i = next++)
+        {
+          HostQueue &host = hosts_.find(host_order_[i])->second;
+          host.resolution = resolver_cache().resolve(host.host);
+        }
+      };
+      std::vector<std::thread> workers;
+      const size_t count = std::min(host_order_.size(), max_concurrency_);
+      for (size_t i = 1; i < count; ++i)
+      {
+        workers.emplace_back(work);
+      }
+      work();
+      for (auto &worker : workers)
+      {
+        worker.join();
+      }
+    }
+
+    // Starts queued requests round-robin across hosts until a limit is reached.
+    void fill()
+    {
+      bool progressed = true;
+      while (progressed && active_.size() < max_concurrency_)
+      {
+        progressed = false;
+        for (const auto &key : host_order_)
+        {
+          HostQueue &host = hosts_[key];
+          if (host.next == host.pending.size() || host.active >= max_per_host_)
+          {
+            continue;
+          }
+          const size_t index = host.pending[host.next++];
+          start(key, host, index);
+          progressed = true;
+          if (active_.size() >= max_concurrency_)
+          {
+            break;
+          }
+        }
+      }
+    }
+
+    void start(const std::string &key, HostQueue &host, const size_t index)
+    {
+      Request request;
+      request.index = index;
+      request.key = key;
+      request.port = host.port;
+      request.started = std::chrono::steady_clock::now();
+      request.deadline = request.started + timeout_;
+      const auto node = requests_.find(index);
+      request.request = std::move(node->second);
+      requests_.erase(node);
+
+      while (!host.idle.empty())
+      {
+        const int fd = host.idle.back();
+        host.idle.pop_back();
+        if (is_connection_idle(fd) && poller_.watch(fd, true))
+        {
+          ++host.active;
+          request.reused = true;
+          request.stage = Stage::SENDING;
+          active_.emplace(fd, std::move(request));
+          return;
+        }
+        close_socket(fd);
+      }
+
+      request.resolution = host.resolution;
+      if (request.resolution->status != 0 || request.resolution->addresses.empty())
+      {
+        report(index, request.started, false, 2, "Hostname resolution failed", std::string());
+        return;
+      }
+      ++host.active;
+      connect_next(std::move(request), -1);
+    }
+
+    // Opens a connection to the next untried address of request, replacing old_fd.
+    void connect_next(Request request, const int old_fd)
+    {
+      if (old_fd >= 0)
+      {
+        poller_.forget(old_fd);
+        close_socket(old_fd);
+      }
+      while (request.address < request.resolution->addresses.size())
+      {
+        ResolvedAddress target = request.resolution->addresses[request.address++];
+        if (target.storage.ss_family == AF_INET)
+        {
+          reinterpret_cast<struct sockaddr_in *>(&target.storage)->sin_port = htons(static_cast<uint16_t>(request.port));
+        }
+        else
+        {
+          reinterpret_cast<struct sockaddr_in6 *>(&target.storage)->sin6_port = htons(static_cast<uint16_t>(request.port));
+        }
+        const int fd = socket(target.storage.ss_family, SOCK_STREAM, IPPROTO_TCP);
+        if (fd < 0)
+        {
+          continue;
+        }
+        if (!set_non_blocking(fd))
+        {
+          close_socket(fd);
+          continue;
+        }
+        const int status = connect(fd, reinterpret_cast<struct sockaddr *>(&target.storage), target.length);
+        if ((status == 0 || last_error_would_block(true)) && poller_.watch(fd, true))
+        {
+          request.stage = status == 0 ? Stage::SENDING : Stage::CONNECTING;
+          active_.emplace(fd, std::move(request));
+          return;
+        }
+        close_socket(fd);
+      }
+      host_done(request.key);
+      report(request.index, request.started, false, 8, "Failed to connect", std::string());
+    }
+
+    void advance(const int fd, const bool readable, const bool writable)
+    {
+      Request &request = active_.find(fd)->second;
+      if (request.stage == Stage::CONNECTING)
+      {
+        if (!writable)
+        {
+          return;
+        }
+        int error = 0;
+        socklen_t length = sizeof(error);
+        if (getsockopt(fd, SOL_SOCKET, SO_ERROR, reinterpret_cast<char *>(&error), &length) != 0 || error != 0)
+        {
+          connect_next(take(fd), fd);
+          return;
+        }
+        request.stage = Stage::SENDING;
+      }
+
+      if (request.stage == Stage::SENDING)
+      {
+        if (!writable)
+        {
+          return;
+        }
+#ifdef MSG_NOSIGNAL
+        constexpr int send_flags = MSG_NOSIGNAL;
+#else
+        constexpr int send_flags = 0;
+#endif
+        while (request.sent < request.request.size())
+        {
+          const ssize_t sent = send(fd, request.request.data() + request.sent, request.request.size() - request.sent, send_flags);
+          if (sent < 0 && last_error_would_block(false))
+          {
+            return;
+          }
+          if (sent <= 0)
+          {
+            fail_or_retry(fd, "Failed to send request");
+            return;
+          }
+          request.sent += static_cast<size_t>(sent);
+        }
+        request.stage = Stage::RECEIVING;
+        poller_.watch(fd, false);
+        return;
+      }
+
+      if (!readable)
+      {
+        return;
+      }
+      for (;;)
+      {
+        const ssize_t received = recv(fd, buffer_.data(), buffer_.size(), 0);
+        if (received < 0)
+        {
+          if (!last_error_would_block(false))
+          {
+            fail_or_retry(fd, "Network error during receive");
+          }
+          return;
+        }
+        if (received == 0)
+        {
+          if (request.framing.until_close && request.framing.body != std::string::npos)
+          {
+            complete(fd, false);
+          }
+          else
+          {
+            fail_or_retry(fd, "Connection closed before response completed");
+          }
+          return;
+        }
+        request.response.append(buffer_.data(), static_cast<size_t>(received));
+        const size_t message_end = frame_http_response(request.response, request.framing);
+        if (message_end == std::string::npos)
+        {
+          fail_or_retry(fd, "Malformed HTTP response");
+          return;
+        }
+        if (message_end != 0)
+        {
+          const bool keep_alive = request.framing.keep_alive && message_end == request.response.size();
+          request.response.resize(message_end);
+          complete(fd, keep_alive);
+          return;
+        }
+      }
+    }
+
+    Request take(const int fd)
+    {
+      auto node = active_.extract(fd);
+      return std::move(node.mapped());
+    }
+
+    // A reused connection the server closed while idle fails without a single
+    // response byte; retry such requests once on a fresh connection.
+    void fail_or_retry(const int fd, const char *message)
+    {
+      Request request = take(fd);
+      if (request.reused && request.response.empty())
+      {
+        request.reused = false;
+        request.sent = 0;
+        request.framing = ResponseFraming();
+        request.resolution = hosts_[request.key].resolution;
+        request.address = 0;
+        if (request.resolution->status == 0)
+        {
+          connect_next(std::move(request), fd);
+          return;
+        }
+      }
+      poller_.forget(fd);
+      close_socket(fd);
+      host_done(request.key);
+      report(request.index, request.started, false, 8, message, std::move(request.response));
+    }
+
+    void complete(const int fd, const bool keep_alive)
+    {
+      Request request = take(fd);
+      poller_.forget(fd);
+      if (keep_alive)
+      {
+        hosts_[request.key].idle.push_back(fd);
+      }
+      else
+      {
+        close_socket(fd);
+      }
+      host_done(request.key);
+      report(request.index, request.started, true, 0, "OK", std::move(request.response));
+    }
+
+    void expire(const std::chrono::steady_clock::time_point now)
+    {
+      std::vector<int> expired;
+      for (const auto &[fd, request] : active_)
+      {
+        if (now >= request.deadline)
+        {
+          expired.push_back(fd);
+        }
+      }
+      for (const int fd : expired)
+      {
+        Request request = take(fd);
+        poller_.forget(fd);
+        close_socket(fd);
+        host_done(request.key);
+        report(request.index, request.started, false, 3, "Request timed out", std::move(request.response));
+      }
+    }
+
+    void fail_active(const int error_code, const char *message)
+    {
+      while (!active_.empty())
+      {
+        const int fd = active_.begin()->first;
+        Request request = take(fd);
+        close_socket(fd);
+        host_done(request.key);
+        report(request.index, request.started, false, error_code, message, std::move(request.response));
+      }
+    }
+
+    void fail_queued(const int error_code, const char *message)
+    {
+      for (const auto &key : host_order_)
+      {
+        HostQueue &host = hosts_[key];
+        while (host.next < host.pending.size())
+        {
+          report(host.pending[host.next++], std::chrono::steady_clock::now(), false, error_code, message, std::string());
+        }
+      }
+    }
+
+    void host_done(const std::string &key)
+    {
+      HostQueue &host = hosts_[key];
+      if (host.active > 0)
+      {
+        --host.active;
+      }
+    }
+
+    void report(const size_t index, const std::chrono::steady_clock::time_point started, const bool success, const int error_code,
+                std::string message, std::string response)
+    {
+      HttpBatchResult result;
+      result.index = index;
+      result.url = urls_[index];
+      result.success = success;
+      result.error_code = error_code;
+      result.message = std::move(message);
+      result.response = std::move(response);
+      result.elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started);
+      if (success)
+      {
+        ++succeeded_;
+      }
+      if (callback_)
+      {
+        callback_(result);
+      }
+    }
+
+    const std::vector<std::string> &urls_;
+    const std::function<void(const HttpBatchResult &)> &callback_;
+    const size_t max_concurrency_;
+    const size_t max_per_host_;
+    const std::chrono::milliseconds timeout_;
+    EventPoller poller_;
+    std::unordered_map<int, Request> active_;
+    std::unordered_map<std::string, HostQueue> hosts_;
+    std::vector<std::string> host_order_;
+    std::unordered_map<size_t, std::string> requests_; // prepared request bytes for queued urls
+    std::array<char, 16384> buffer_{};
+    size_t succeeded_ = 0;
+  };
+
+  // Destination of a download, written with positioned writes so parallel
+  // segments can share one descriptor.
+  class DownloadFile
+  {
+  public:
+    DownloadFile() = default;
+    DownloadFile(const DownloadFile &) = delete;
+    DownloadFile &operator=(const DownloadFile &) = delete;
+    ~DownloadFile() { close(); }
+
+    bool open(const std::string &path, const bool truncate)
+    {
+#ifdef _WIN32
+      fd_ = _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_BINARY | (truncate ? _O_TRUNC : 0), _S_IREAD | _S_IWRITE);
+#else
+      fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | (truncate ? O_TRUNC : 0), 0644);
+#endif
+      return fd_ >= 0;
+    }
+
+    // Reserves disk blocks without changing the file size, so for a single
+    // stream the size still equals the bytes received (what resume relies on).
+    void reserve(const uint64_t size)
+    {
+#if defined(__linux__)
+      (void)fallocate(fd_, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(size));
+#elif defined(__APPLE__)
+      fstore_t store = {F_ALLOCATECONTIG, F_PEOFPOSMODE, 0, static_cast<off_t>(size), 0};
+      if (fcntl(fd_, F_PREALLOCATE, &store) == -1)
+      {
+        store.fst_flags = F_ALLOCATEALL;
+        fcntl(fd_, F_PREALLOCATE, &store);
+      }
+#else
+      (void)size;
+#endif
+    }
+
+    bool write_at(uint64_t offset, const char *data, size_t size)
+    {
+#ifdef _WIN32
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (_lseeki64(fd_, static_cast<__int64>(offset), SEEK_SET) < 0)
+      {
+        return false;
+      }
+      while (size > 0)
+      {
+        const int written = _write(fd_, data, static_cast<unsigned>(std::min<size_t>(size, 1u << 30)));
+        if (written <= 0)
+        {
+          return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+      }
+#else
+      while (size > 0)
+      {
+        const ssize_t written = ::pwrite(fd_, data, size, static_cast<off_t>(offset));
+        if (written < 0 && errno == EINTR)
+        {
+          continue;
+        }
+        if (written <= 0)
+        {
+          return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+        offset += static_cast<uint64_t>(written);
+      }
+#endif
+      return true;
+    }
+
+    bool resize(const uint64_t size)
+    {
+#ifdef _WIN32
+      return _chsize_s(fd_, static_cast<__int64>(size)) == 0;
+#else
+      return ::ftruncate(fd_, static_cast<off_t>(size)) == 0;
+#endif
+    }
+
+    bool close()
+    {
+      if (fd_ < 0)
+      {
+        return true;
+      }
+#ifdef _WIN32
+      const bool closed = _close(fd_) == 0;
+#else
+      const bool closed = ::close(fd_) == 0;
+#endif
+      fd_ = -1;
+      return closed;
+    }
+
+  private:
+    int fd_ = -1;
+#ifdef _WIN32
+    std::mutex mutex_;
+#endif
+  };
+
+  // Streaming de-framer for chunked transfer coding: payload bytes are handed
+  // to the sink straight out of the receive buffer.
+  class ChunkedDecoder
+  {
+  public:
+    // Returns 1 after the last chunk and trailers, 0 while more input is
+    // needed, -1 for malformed input or when the sink returns false.
+    template <typename Sink> int feed(const char *data, size_t size, Sink &&sink)
+    {
+      while (size > 0 && state_ != State::DONE)
+      {
+        if (state_ == State::DATA)
+        {
+          const size_t take = static_cast<size_t>(std::min<uint64_t>(size, remaining_));
+          if (!sink(data, take))
+          {
+            return -1;
+          }
+          data += take;
+          size -= take;
+          remaining_ -= take;
+          if (remaining_ == 0)
+          {
+            state_ = State::DATA_END;
+          }
+          continue;
+        }
+
+        const char *newline = static_cast<const char *>(std::memchr(data, '\n', size));
+        const size_t take = newline ? static_cast<size_t>(newline - data) : size;
+        line_.append(data, take);
+        if (line_.size() > 4096)
+        {
+          return -1;
+        }
+        if (!newline)
+        {
+          return 0;
+        }
+        data += take + 1;
+        size -= take + 1;
+        if (!line_.empty() && line_.back() == '\r')
+        {
+          line_.pop_back();
+        }
+
+        if (state_ == State::SIZE)
+        {
+          uint64_t chunk_size = 0;
+          const auto [ptr, ec] = std::from_chars(line_.data(), line_.data() + line_.size(), chunk_size, 16);
+          if (ec != std::errc() || ptr == line_.data())
+          {
+            return -1;
+          }
+          remaining_ = chunk_size;
+          state_ = chunk_size == 0 ? State::TRAILER : State::DATA;
+        }
+        else if (state_ == State::DATA_END)
+        {
+          if (!line_.empty())
+          {
+            return -1;
+          }
+          state_ = State::SIZE;
+        }
+        else if (line_.empty())
+        {
+          state_ = State::DONE; // blank line closes the trailer section
+        }
+        line_.clear();
+      }
+      unconsumed_ = size;
+      return state_ == State::DONE ? 1 : 0;
+    }
+
+    // Bytes of the last feed() past the end of the chunked body.
+    size_t unconsumed() const { return unconsumed_; }
+
+  private:
+    enum class State
+    {
+      SIZE,
+      DATA,
+      DATA_END,
+      TRAILER,
+      DONE
+    };
+
+    State state_ = State::SIZE;
+    uint64_t remaining_ = 0;
+    size_t unconsumed_ = 0;
+    std::string line_;
+  };
+
+  static uint64_t existing_file_size(const std::string &path)
+  {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+    {
+      return 0;
+    }
+    const auto size = file.tellg();
+    return size > 0 ? static_cast<uint64_t>(size) : 0;
+  }
+
+  // Parses "bytes first-last/total" ("*" totals are rejected).
+  static bool parse_content_range(std::string_view value, uint64_t &first, uint64_t &last, uint64_t &total)
+  {
+    if (value.substr(0, 6) != "bytes ")
+    {
+      return false;
+    }
+    value.remove_prefix(6);
+    const char *begin = value.data();
+    const char *end = value.data() + value.size();
+    auto [p1, e1] = std::from_chars(begin, end, first);
+    if (e1 != std::errc() || p1 == end || *p1 != '-')
+    {
+      return false;
+    }
+    auto [p2, e2] = std::from_chars(p1 + 1, end, last);
+    if (e2 != std::errc() || p2 == end || *p2 != '/')
+    {
+      return false;
+    }
+    auto [p3, e3] = std::from_chars(p2 + 1, end, total);
+    return e3 == std::errc() && p3 == end && first <= last && last < total;
+  }
+
+  static std::string download_request(const Url &url, const std::string &range)
+  {
+    std::string request = "GET " + url.path + " HTTP/1.1\r\n";
+    request += "Host: " + url.host + "\r\n";
+    if (!range.empty())
+    {
+      request += "Range: bytes=" + range + "\r\n";
+    }
+    request += "Connection: close\r\n\r\n";
+    return request;
+  }
+
+  // Connects for a download, honouring the connect/socket_create test hooks.
+  static int open_download_connection(const Resolution &resolution, const int port, const int timeout_sec, NetworkResult &error)
+  {
+    // Honor test hook proactively so tests can force a connect failure
+    if (test_download_hook)
+    {
+      if (int forced = test_download_hook("connect"); forced != 0)
+      {
+        error = {false, forced, "Forced connect failure"};
+        return -1;
+      }
+    }
+
+    bool socket_failed = false;
+    const int sockfd = connect_resolved(resolution, port, timeout_sec, socket_failed);
+    if (sockfd >= 0)
+    {
+      return sockfd;
+    }
+    if (socket_failed)
+    {
+      if (test_download_hook)
+      {
+        if (int forced = test_download_hook("socket_create"); forced != 0)
+        {
+          error = {false, forced, "Forced socket create failure"};
+          return -1;
+        }
+      }
+      error = {false, 8, "Failed to create socket"};
+      return -1;
+    }
+    error = {false, 8, "Failed to connect to host"};
+    return -1;
+  }
+
+  // Receives until head holds the complete response head; any bytes from
+  // framing.body on already belong to the body. Data is appended by length,
+  // so binary bodies with NULs are preserved.
+  static NetworkResult read_response_head(const int sockfd, std::vector<char> &buffer, std::string &head, ResponseFraming &framing)
+  {
+    for (;;)
+    {
+      const ssize_t received = recv(sockfd, buffer.data(), buffer.size(), 0);
+      if (received < 0)
+      {
+        return {false, 8, "Network error while receiving response"};
+      }
+      if (received == 0)
+      {
+        return {false, 8, "Connection closed before response headers"};
+      }
+      head.append(buffer.data(), static_cast<size_t>(received));
+      const int parsed = parse_response_head(head, framing);
+      if (parsed < 0)
+      {
+        return {false, 8, "Malformed HTTP response"};
+      }
+      if (parsed > 0)
+      {
+        return {true, 0, "OK"};
+      }
+      if (head.size() > 1024 * 1024)
+      {
+        return {false, 8, "HTTP response headers too large"};
+      }
+    }
+  }
+
+  // Streams a response body to sink(const char *, size_t) -> bool, starting with
+  // the bytes that arrived together with the head. Identity bodies go straight
+  // from the receive buffer to the sink; chunked bodies are de-framed in place.
+  // exact_end, when given, reports whether the message ended on the last byte
+  // received (the precondition for reusing the connection).
+  template <typename Sink>
+  static NetworkResult stream_response_body(const int sockfd, std::vector<char> &buffer, const ResponseFraming &framing,
+                                            const std::string_view initial, Sink &&sink, bool *exact_end = nullptr)
+  {
+    ChunkedDecoder decoder;
+    uint64_t remaining = framing.content_length;
+    bool write_failed = false;
+    bool exact = false;
+    const auto consume = [&](const char *data, const size_t size) -> int
+    {
+      if (framing.chunked)
+      {
+        const int state = decoder.feed(data, size, [&](const char *payload, const size_t length)
+                                       { return !(write_failed = !sink(payload, length)); });
+        exact = decoder.unconsumed() == 0;
+        return write_failed ? -2 : state;
+      }
+      if (framing.until_close)
+      {
+        return sink(data, size) ? 0 : -2;
+      }
+      const size_t take = static_cast<size_t>(std::min<uint64_t>(size, remaining));
+      if (take > 0 && !sink(data, take))
+      {
+        return -2;
+      }
+      remaining -= take;
+      exact = take == size;
+      return remaining == 0 ? 1 : 0;
+    };
+
+    exact = initial.empty();
+    int state = (!framing.chunked && !framing.until_close && remaining == 0) ? 1 : consume(initial.data(), initial.size());
+    while (state == 0)
+    {
+      const ssize_t received = recv(sockfd, buffer.data(), buffer.size(), 0);
+      if (received < 0)
+      {
+        return {false, 8, "Network error while receiving response"};
+      }
+      if (received == 0)
+      {
+        if (framing.until_close)
+        {
+          return {true, 0, "OK"};
+        }
+        return {false, 8, "Connection closed before response completed"};
+      }
+      state = consume(buffer.data(), static_cast<size_t>(received));
+    }
+    if (state == -2)
+    {
+      return {false, 7, "Failed to write output file"};
+    }
+    if (state < 0)
+    {
+      return {false, 8, "Malformed chunked encoding"};
+    }
+    if (exact_end)
+    {
+      *exact_end = exact;
+    }
+    return {true, 0, "OK"};
+  }
+
+  struct DownloadSegment
   {
-    std::string out = scheme + "://" + authority();
-    out += (path.empty() ? "/" : path);
-    if (!query.empty()) out += "?" + query;
-    if (!fragment.empty()) out += "#" + fragment;
-    return out;
+    uint64_t start = 0;
+    uint64_t end = 0;  // exclusive
+    uint64_t done = 0; // bytes of [start, end) already on disk
+  };
+
+  // "<destination>.progress": a header line with the total size, then one
+  // "start end done" line per segment.
+  static bool load_download_progress(const std::string &path, const uint64_t total, std::vector<DownloadSegment> &segments)
+  {
+    std::ifstream in(path);
+    std::string magic;
+    uint64_t recorded_total = 0;
+    if (!(in >> magic >> recorded_total) || magic != "pixellib-download-v1" || recorded_total != total)
+    {
+      return false;
+    }
+    std::vector<DownloadSegment> loaded;
+    DownloadSegment segment;
+    while (in >> segment.start >> segment.end >> segment.done)
+    {
+      if (segment.start >= segment.end || segment.end > total || segment.done > segment.end - segment.start)
+      {
+        return false;
+      }
+      loaded.push_back(segment);
+    }
+    if (loaded.empty())
+    {
+      return false;
+    }
+    segments = std::move(loaded);
+    return true;
   }
 
-  static int default_port_for_scheme(const std::string &scheme)
+  static void save_download_progress(const std::string &path, const uint64_t total, const std::vector<DownloadSegment> &segments)
   {
-    if (scheme == "http") return 80;
-    if (scheme == "https") return 443;
-    return 0;
+    std::ofstream out(path, std::ios::trunc);
+    out << "pixellib-download-v1 " << total << "\n";
+    for (const auto &segment : segments)
+    {
+      out << segment.start << " " << segment.end << " " << segment.done << "\n";
+    }
   }
 
-  // Parse a URL. Returns NetworkResult (success==false uses error_code 6 for invalid format to match existing API)
-  static NetworkResult parse(const std::string &url_str, Url &out)
+  static NetworkResult fetch_segment(const Url &url, const Resolution &resolution, const int timeout_sec, DownloadFile &file,
+                                     DownloadSegment &segment, const std::function<void(DownloadSegment &, uint64_t)> &checkpoint)
   {
-    if (url_str.empty())
+    uint64_t position = segment.start + segment.done;
+    NetworkResult error(false, 8, "Failed to connect to host");
+    const int sockfd = open_download_connection(resolution, url.port, timeout_sec, error);
+    if (sockfd < 0)
     {
-      return {false, 6, "Invalid URL format"};
+      return error;
     }
-
-    const size_t scheme_end = url_str.find("://");
-    if (scheme_end == std::string::npos)
+    if (!send_all(sockfd, download_request(url, std::to_string(position) + "-" + std::to_string(segment.end - 1))))
     {
-      return {false, 6, "Invalid URL format"};
+      close_socket(sockfd);
+      return {false, 8, "Failed to send HTTP request"};
     }
 
-    out = Url();
-    out.scheme = url_str.substr(0, scheme_end);
-    size_t pos = scheme_end + 3;
-
-    // authority = [userinfo@]host[:port]
-    size_t path_start = url_str.find_first_of("/?#", pos);
-    const std::string authority = (path_start == std::string::npos) ? url_str.substr(pos) : url_str.substr(pos, path_start - pos);
+    std::vector<char> buffer(256 * 1024);
+    std::string head;
+    ResponseFraming framing;
+    NetworkResult result = read_response_head(sockfd, buffer, head, framing);
+    uint64_t first = 0, last = 0, total = 0;
+    if (result.success && (framing.status != 206 ||
+                           !parse_content_range(header_value(std::string_view(head).substr(0, framing.body), "Content-Range"), first, last, total) ||
+                           first != position))
+    {
+      result = {false, 9, "Server did not honour range request"};
+    }
+    if (result.success)
+    {
+      constexpr uint64_t checkpoint_interval = 4 * 1024 * 1024;
+      uint64_t last_checkpoint = position;
+      result = stream_response_body(sockfd, buffer, framing, std::string_view(head).substr(framing.body),
+                                    [&](const char *data, const size_t size)
+                                    {
+                                      const size_t take = static_cast<size_t>(std::min<uint64_t>(size, segment.end - position));
+                                      if (!file.write_at(position, data, take))
+                                      {
+                                        return false;
+                                      }
+                                      position += take;
+                                      if (position - last_checkpoint >= checkpoint_interval)
+                                      {
+                                        checkpoint(segment, position - segment.start);
+                                        last_checkpoint = position;
+                                      }
+                                      return true;
+                                    });
+    }
+    close_socket(sockfd);
+    checkpoint(segment, position - segment.start);
+    if (result.success && position != segment.end)
+    {
+      return {false, 8, "Connection closed before response completed"};
+    }
+    return result;
+  }
 
-    // Separate userinfo
-    size_t at_pos = authority.find('@');
-    std::string hostport = authority;
-    if (at_pos != std::string::npos)
+  // Parallel ranged download. Returns nullopt when the server does not support
+  // ranges (or the file is too small to split) so the caller streams instead.
+  static std::optional<NetworkResult> download_segmented(const Url &url, const Resolution &resolution, const std::string &destination,
+                                                         const DownloadOptions &options)
+  {
+    // Probe with a one-byte range: a 206 reply carries the total size.
+    NetworkResult error(false, 8, "Failed to connect to host");
+    const int sockfd = open_download_connection(resolution, url.port, options.timeout_sec, error);
+    if (sockfd < 0)
     {
-      out.userinfo = authority.substr(0, at_pos);
-      hostport = authority.substr(at_pos + 1);
-      if (out.userinfo.empty())
-      {
-        return {false, 6, "Invalid URL format"};
-      }
+      return error;
+    }
+    if (!send_all(sockfd, download_request(url, "0-0")))
+    {
+      close_socket(sockfd);
+      return NetworkResult(false, 8, "Failed to send HTTP request");
+    }
+    std::vector<char> buffer(16 * 1024);
+    std::string head;
+    ResponseFraming framing;
+    const NetworkResult probe = read_response_head(sockfd, buffer, head, framing);
+    close_socket(sockfd);
+    if (!probe.success)
+    {
+      return probe;
+    }
+    if (framing.status >= 400)
+    {
+      return NetworkResult(false, 9, "HTTP error: " + std::to_string(framing.status));
+    }
+    uint64_t first = 0, last = 0, total = 0;
+    if (framing.status != 206 ||
+        !parse_content_range(header_value(std::string_view(head).substr(0, framing.body), "Content-Range"), first, last, total))
+    {
+      return std::nullopt;
+    }
+    const uint64_t count = std::min<uint64_t>(options.segments, total / std::max<size_t>(1, options.min_segment_size));
+    if (count < 2)
+    {
+      return std::nullopt;
     }
 
-    // IPv6 literal [::1]
-    if (!hostport.empty() && hostport[0] == '[')
+    const std::string progress_path = destination + ".progress";
+    std::vector<DownloadSegment> segments;
+    const bool resuming = options.resume && load_download_progress(progress_path, total, segments);
+    if (!resuming)
     {
-      const size_t rb = hostport.find(']');
-      if (rb == std::string::npos)
-      {
-        return {false, 6, "Invalid URL format"};
-      }
-      out.host = hostport.substr(1, rb - 1);
-      if (rb + 1 < hostport.size())
+      const uint64_t step = total / count;
+      for (uint64_t i = 0; i < count; ++i)
       {
-        if (hostport[rb + 1] == ':')
-        {
-          const std::string port_str = hostport.substr(rb + 2);
-          try
-          {
-            out.port = std::stoi(port_str);
-          }
-          catch (...) { return {false, 6, "Invalid URL format"}; }
-        }
-        else
-        {
-          return {false, 6, "Invalid URL format"};
-        }
+        segments.push_back({i * step, i + 1 == count ? total : (i + 1) * step, 0});
       }
     }
-    else
+
+    DownloadFile file;
+    if (!file.open(destination, !resuming))
     {
-      // host[:port] - be careful to pick the last colon as port separator only when it's unambiguous
-      size_t colon_pos = hostport.rfind(':');
-      if (colon_pos != std::string::npos && hostport.find(':') == colon_pos)
+      if (test_download_hook)
       {
-        out.host = hostport.substr(0, colon_pos);
-        const std::string port_str = hostport.substr(colon_pos + 1);
-        if (port_str.empty())
-          return {false, 6, "Invalid URL format"};
-        try
+        if (int forced = test_download_hook("fopen"); forced != 0)
         {
-          out.port = std::stoi(port_str);
+          return NetworkResult(false, forced, "Forced fopen failure");
         }
-        catch (...) { return {false, 6, "Invalid URL format"}; }
-      }
-      else
-      {
-        out.host = hostport;
       }
+      return NetworkResult(false, 7, "Failed to create output file");
     }
+    file.reserve(total);
 
-    // If host empty -> invalid
-    if (out.host.empty())
-      return {false, 6, "Invalid URL format"};
-
-    // Validate and set defaults
-    if (out.port == 0)
-      out.port = default_port_for_scheme(out.scheme);
+    std::mutex progress_mutex;
+    save_download_progress(progress_path, total, segments);
+    const std::function<void(DownloadSegment &, uint64_t)> checkpoint = [&](DownloadSegment &segment, const uint64_t done)
+    {
+      std::lock_guard<std::mutex> lock(progress_mutex);
+      segment.done = done;
+      save_download_progress(progress_path, total, segments);
+    };
 
-    // Path/query/fragment
-    if (path_start != std::string::npos)
+    std::vector<NetworkResult> results(segments.size(), NetworkResult(true, 0, "OK"));
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < segments.size(); ++i)
     {
-      size_t p = path_start;
-      size_t q = url_str.find('?', p);
-      size_t h = url_str.find('#', p);
-      size_t path_end = std::min(q == std::string::npos ? url_str.size() : q, h == std::string::npos ? url_str.size() : h);
-      out.path = url_str.substr(p, path_end - p);
-      if (q != std::string::npos)
+      if (segments[i].done < segments[i].end - segments[i].start)
       {
-        size_t query_end = (h == std::string::npos) ? url_str.size() : h;
-        out.query = url_str.substr(q + 1, query_end - q - 1);
+        workers.emplace_back([&, i] { results[i] = fetch_segment(url, resolution, options.timeout_sec, file, segments[i], checkpoint); });
       }
-      if (h != std::string::npos)
+    }
+    for (auto &worker : workers)
+    {
+      worker.join();
+    }
+
+    for (const auto &result : results)
+    {
+      if (!result.success)
       {
-        out.fragment = url_str.substr(h + 1);
+        file.close();
+        return result;
       }
     }
-    else
+    if (!file.resize(total) || !file.close())
     {
-      out.path = "/";
+      return NetworkResult(false, 7, "Failed to write output file");
     }
-
-    return {true, 0, "OK"};
+    std::remove(progress_path.c_str());
+    return NetworkResult(true, 0, "File downloaded successfully (" + std::to_string(segments.size()) + " segments)");
   }
-};
 
-class Network
-{
-private:
-  static constexpr size_t download_buffer_size = 1024 * 1024;
-  static bool initialize_winsock()
-  {
-#ifdef _WIN32
-    WSADATA wsaData;
-    return WSAStartup(MAKEWORD(2, 2), &wsaData) == 0;
-#else
-    return true;
-#endif
-  }
-  static void cleanup_winsock()
+  static std::string build_get_request(const std::string &host, const std::string &path, const bool keep_alive = true)
   {
-#ifdef _WIN32
-    WSACleanup();
-#endif
+    std::string request = "GET " + path + " HTTP/1.1\r\n";
+    request += "Host: " + host + "\r\n";
+    request += keep_alive && connection_pool().reuse_enabled() ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+    request += "User-Agent: pixelLib/1.0\r\n";
+    request += "\r\n";
+    return request;
   }
 
-  static bool is_test_mode()
-  {
-    const char *test_mode_value = std::getenv("PIXELLIB_TEST_MODE");
-    return test_mode_value && test_mode_value[0] == '1';
-  }
-  // NOLINT(readability-suspicious-call-argument)
-  static void set_socket_timeout(const int timeout_sec, const int socket_fd)
+  // Builds the deterministic test-mode response from the http_get mock.
+  static HttpResponse mock_response(const std::string &url)
   {
-#ifdef _WIN32
-    DWORD timeout = timeout_sec * 1000;
-    setsockopt(socket_fd, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char *>(&timeout), sizeof(timeout));
-    setsockopt(socket_fd, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char *>(&timeout), sizeof(timeout));
-#else
-    // NOLINT(misc-include-cleaner)
-    struct timeval timeout = {};
-    timeout.tv_sec = timeout_sec;
-    timeout.tv_usec = 0;
-    setsockopt(socket_fd, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char *>(&timeout), sizeof(timeout));
-    setsockopt(socket_fd, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char *>(&timeout), sizeof(timeout));
-#endif
-  }
-  static void close_socket(int sockfd)
-  {
-#ifdef _WIN32
-    closesocket(sockfd);
-#else
-    close(sockfd);
-#endif
+    const std::string raw = http_get(url);
+    HttpResponse response;
+    const size_t head_end = raw.find("\r\n\r\n");
+    response.success = true;
+    response.message = "OK";
+    response.status = parse_http_response_code(raw);
+    response.head = raw.substr(0, head_end);
+    response.body = head_end == std::string::npos ? std::string() : raw.substr(head_end + 4);
+    return response;
   }
-  // NOLINT(readability-suspicious-call-argument)
-  static int get_connection_error(bool &refused_flag, bool &timeout_flag)
-  {
-    timeout_flag = false;
-    refused_flag = false;
 
-#ifdef _WIN32
-    int error = WSAGetLastError();
-    if (error == WSAETIMEDOUT)
+  // GET over a pooled keep-alive connection with the body streamed to sink
+  // (see stream_response_body); buffer is the receive buffer. A sink returning
+  // false aborts the transfer with error_code 10. With dedicated set, the
+  // request opens its own connection and closes it afterwards, bypassing the
+  // pool, so concurrent callers never share a socket.
+  template <typename Sink>
+  static void fetch_streaming(const std::string &url, std::vector<char> &buffer, HttpResponse &response, Sink &&sink, const bool dedicated = false)
+  {
+    Url parsed_url;
+    if (!Url::parse(url, parsed_url).success)
     {
-      timeout_flag = true;
-      return 3;
+      response.error_code = 6;
+      response.message = "Invalid URL format";
+      return;
     }
-    if (error == WSAECONNREFUSED)
+    if (buffer.empty())
     {
-      refused_flag = true;
-      return 4;
+      buffer.resize(16 * 1024);
     }
-#else
-    if (errno == ETIMEDOUT)
+
+    ConnectionPool &pool = connection_pool();
+    const auto release = [&](const int sockfd, const bool reusable)
     {
-      timeout_flag = true;
-      return 3;
-    }
-    if (errno == ECONNREFUSED)
+      if (dedicated)
+      {
+        close_socket(sockfd);
+      }
+      else
+      {
+        pool.release(parsed_url.host, parsed_url.port, sockfd, reusable);
+      }
+    };
+    const std::string request = build_get_request(parsed_url.host, parsed_url.path, !dedicated);
+    for (int attempt = 0; attempt < 2; ++attempt)
     {
-      refused_flag = true;
-      return 4;
+      bool reused = false;
+      const int sockfd = dedicated ? create_socket_connection(parsed_url.host, parsed_url.port) : pool.acquire(parsed_url.host, parsed_url.port, reused);
+      if (sockfd < 0)
+      {
+        response.error_code = 8;
+        response.message = "Failed to connect";
+        return;
+      }
+      if (!send_all(sockfd, request))
+      {
+        release(sockfd, false);
+        if (reused)
+        {
+          continue;
+        }
+        response.error_code = 8;
+        response.message = "Failed to send request";
+        return;
+      }
+
+      std::string head;
+      ResponseFraming framing;
+      NetworkResult result = read_response_head(sockfd, buffer, head, framing);
+      if (!result.success)
+      {
+        release(sockfd, false);
+        if (reused && head.empty())
+        {
+          continue; // server closed the idle connection; retry on a fresh one
+        }
+        response.error_code = result.error_code;
+        response.message = result.message;
+        return;
+      }
+
+      bool exact_end = false;
+      bool aborted = false;
+      result = stream_response_body(sockfd, buffer, framing, std::string_view(head).substr(framing.body),
+                                    [&](const char *data, const size_t size) { return !(aborted = !sink(data, size)); }, &exact_end);
+      release(sockfd, result.success && exact_end && framing.keep_alive && !framing.until_close);
+
+      response.status = framing.status;
+      response.head.assign(head, framing.start, framing.body - 4 - framing.start);
+      response.success = result.success;
+      response.error_code = aborted ? 10 : result.error_code;
+      response.message = aborted ? "Body callback aborted the transfer" : result.message;
+      return;
     }
-#endif
-    return 5;
+    response.error_code = 8;
+    response.message = "No response received";
   }
 
 public:
   static std::function<int(const std::string &)> test_download_hook;
   static std::function<int(const std::string &)> test_is_host_hook;
+  // Called with the hostname before each real lookup; a non-zero return fails it with EAI_NONAME.
+  static std::function<int(const std::string &)> test_resolve_hook;
   static NetworkResult resolve_hostname(const std::string &hostname)
   {
     if (hostname.empty())
@@ -416,49 +2821,63 @@ public:
       }
       return {true, 0, "127.0.0.1"};
     }
-    if (!initialize_winsock())
+    const auto resolution = resolver_cache().resolve(hostname);
+    if (resolution->status != 0)
     {
-      return {false, 2, "Failed to initialize Winsock"};
+      return {false, 2, "Hostname resolution failed: " + std::string(gai_strerror(resolution->status))};
     }
-    struct addrinfo hints = {}, *result = nullptr;
-    hints.ai_family = AF_UNSPEC;
-    hints.ai_socktype = SOCK_STREAM;
-    hints.ai_flags = 0;
-    hints.ai_protocol = 0;
 
-    if (const int status =
-            getaddrinfo(hostname.c_str(), nullptr, &hints, &result);
-        status != 0)
+    const std::string ip_address = resolution->addresses.empty() ? std::string() : address_to_string(resolution->addresses.front());
+    if (ip_address.empty())
     {
-      cleanup_winsock();
-      return {false, 2, "Hostname resolution failed: " + std::string(gai_strerror(status))};
+      return {false, 3, "No addresses found for hostname"};
     }
 
-    std::string ip_address;
-    std::array<char, INET6_ADDRSTRLEN> ip_str{};
+    return {true, 0, ip_address};
+  }
 
-    if (result->ai_family == AF_INET)
+  // Every address the resolver returned for hostname, in getaddrinfo order.
+  // Served from the resolver cache; empty when resolution fails.
+  static std::vector<std::string> resolve_addresses(const std::string &hostname)
+  {
+    std::vector<std::string> addresses;
+    if (hostname.empty())
     {
-      const auto ipv4 = reinterpret_cast<struct sockaddr_in *>(result->ai_addr);
-      inet_ntop(AF_INET, &ipv4->sin_addr, ip_str.data(), INET_ADDRSTRLEN);
-      ip_address = std::string(ip_str.data());
+      return addresses;
     }
-    else if (result->ai_family == AF_INET6)
+    if (is_test_mode())
     {
-      const auto ipv6 = reinterpret_cast<struct sockaddr_in6 *>(result->ai_addr);
-      inet_ntop(AF_INET6, &ipv6->sin6_addr, ip_str.data(), INET6_ADDRSTRLEN);
-      ip_address = std::string(ip_str.data());
+      addresses.emplace_back("127.0.0.1");
+      return addresses;
     }
-
-    freeaddrinfo(result);
-    cleanup_winsock();
-
-    if (ip_address.empty())
+    const auto resolution = resolver_cache().resolve(hostname);
+    addresses.reserve(resolution->addresses.size());
+    for (const auto &address : resolution->addresses)
     {
-      return {false, 3, "No addresses found for hostname"};
+      addresses.push_back(address_to_string(address));
     }
+    return addresses;
+  }
 
-    return {true, 0, ip_address};
+  static void set_resolver_cache_options(const ResolverCacheOptions &options)
+  {
+    resolver_cache().configure(options);
+  }
+
+  static ResolverCacheOptions get_resolver_cache_options()
+  {
+    return resolver_cache().options();
+  }
+
+  static ResolverCacheStats get_resolver_cache_stats()
+  {
+    return resolver_cache().stats();
+  }
+
+  // Drops every cached (positive and negative) resolution.
+  static void clear_resolver_cache()
+  {
+    resolver_cache().clear();
   }
   static NetworkResult is_host_reachable(const std::string &host)
   {
@@ -594,6 +3013,15 @@ public:
   }
 
   static NetworkResult download_file(const std::string &url, const std::string &destination)
+  {
+    return download_file(url, destination, DownloadOptions());
+  }
+
+  // Streams the response body to destination: headers are parsed
+  // incrementally, chunked bodies are decoded on the fly and the file is
+  // preallocated from Content-Length. See DownloadOptions for parallel ranged
+  // downloads and resume.
+  static NetworkResult download_file(const std::string &url, const std::string &destination, const DownloadOptions &options)
   {
     if (test_download_hook)
     {
@@ -637,183 +3065,133 @@ public:
       return {true, 0, "File downloaded successfully (test mode)"};
     }
 
-    // Parse URL using production Url parser
-    std::string host = parsed_url.host;
-    std::string path = parsed_url.path;
-    int port = parsed_url.port;
-    std::string port_str = std::to_string(port);
-    if (!initialize_winsock())
-    {
-      return {false, 8, "Failed to initialize Winsock"};
-    }
-    struct addrinfo hints = {}, *result = nullptr;
-    hints.ai_family = AF_UNSPEC;
-    hints.ai_socktype = SOCK_STREAM;
-    hints.ai_flags = AI_PASSIVE;
-
-    int status = getaddrinfo(host.c_str(), port_str.c_str(), &hints, &result);
-    if (status != 0)
+    const auto resolution = resolver_cache().resolve(parsed_url.host);
+    if (resolution->status != 0)
     {
       if (test_download_hook)
       {
         if (int forced = test_download_hook("getaddrinfo"); forced != 0)
         {
-          cleanup_winsock();
           return {false, forced, "Forced getaddrinfo failure"};
         }
       }
-      cleanup_winsock();
-      return {false, 8, "Hostname resolution failed: " + std::string(gai_strerror(status))};
+      return {false, 8, "Hostname resolution failed: " + std::string(gai_strerror(resolution->status))};
     }
-
-    int sockfd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
-    if (sockfd < 0)
-    {
-      if (test_download_hook)
-      {
-        if (int forced = test_download_hook("socket_create"); forced != 0)
-        {
-          freeaddrinfo(result);
-          cleanup_winsock();
-          return {false, forced, "Forced socket create failure"};
-        }
-      }
-      freeaddrinfo(result);
-      cleanup_winsock();
-      return {false, 8, "Failed to create socket"};
+    if (!initialize_winsock())
+    {
+      return {false, 8, "Failed to initialize Winsock"};
     }
 
-    set_socket_timeout(30, sockfd);
-
-    // Honor test hook proactively so tests can force a connect failure
-    if (test_download_hook)
+    if (options.segments > 1)
     {
-      if (int forced = test_download_hook("connect"); forced != 0)
+      if (auto segmented = download_segmented(parsed_url, *resolution, destination, options))
       {
-        freeaddrinfo(result);
-        close_socket(sockfd);
         cleanup_winsock();
-        return {false, forced, "Forced connect failure"};
+        return *segmented;
       }
     }
 
-    status = connect(sockfd, result->ai_addr, result->ai_addrlen);
-    if (status < 0)
+    const uint64_t resume_from = options.resume ? existing_file_size(destination) : 0;
+    NetworkResult connect_error(false, 8, "Failed to connect to host");
+    const int sockfd = open_download_connection(*resolution, parsed_url.port, options.timeout_sec, connect_error);
+    if (sockfd < 0)
     {
-      freeaddrinfo(result);
-      close_socket(sockfd);
       cleanup_winsock();
-      return {false, 8, "Failed to connect to host"};
+      return connect_error;
     }
 
-    std::string request = "GET " + path + " HTTP/1.1\r\n";
-    request += "Host: " + host + "\r\n";
-    request += "Connection: close\r\n\r\n";
-
-    // NOLINT(misc-include-cleaner)
+    const std::string request = download_request(parsed_url, resume_from > 0 ? std::to_string(resume_from) + "-" : std::string());
 
     // Honor test hook proactively so tests can force a send failure (normalized to standard network error code 8)
     if (test_download_hook)
     {
       if (int forced = test_download_hook("send"); forced != 0)
       {
-        freeaddrinfo(result);
         close_socket(sockfd);
         cleanup_winsock();
         return {false, 8, "Forced send failure"};
       }
     }
 
-    if (ssize_t send_status =
-            send(sockfd, request.c_str(), request.length(), 0);
-        send_status < 0)
+    if (!send_all(sockfd, request))
     {
-      freeaddrinfo(result);
       close_socket(sockfd);
       cleanup_winsock();
       return {false, 8, "Failed to send HTTP request"};
     }
 
-    FILE *file = fopen(destination.c_str(), "wb");
-    if (!file)
+    std::vector<char> buffer(download_buffer_size);
+    std::string head;
+    ResponseFraming framing;
+    NetworkResult result = read_response_head(sockfd, buffer, head, framing);
+    if (result.success && framing.status == 416 && resume_from > 0)
+    {
+      // Nothing left past the bytes already on disk
+      close_socket(sockfd);
+      cleanup_winsock();
+      return {true, 0, "File already complete"};
+    }
+    if (result.success && framing.status >= 400)
+    {
+      close_socket(sockfd);
+      cleanup_winsock();
+      return {false, 9, "HTTP error: " + std::to_string(framing.status)};
+    }
+
+    DownloadFile file;
+    const bool append = result.success && resume_from > 0 && framing.status == 206;
+    if (result.success && !file.open(destination, !append))
     {
       if (test_download_hook)
       {
         if (int forced = test_download_hook("fopen"); forced != 0)
         {
-          freeaddrinfo(result);
           close_socket(sockfd);
           cleanup_winsock();
           return {false, forced, "Forced fopen failure"};
         }
       }
-      freeaddrinfo(result);
       close_socket(sockfd);
       cleanup_winsock();
       return {false, 7, "Failed to create output file"};
     }
 
-    std::vector<char> buffer(download_buffer_size);
-    bool headers_parsed = false;
-    std::string headers;
-
-    // NOLINT(misc-include-cleaner)
-    ssize_t recv_status = 0;
-    while ((recv_status = recv(sockfd, buffer.data(), buffer.size() - 1, 0)) > 0)
+    if (result.success)
     {
-      buffer[static_cast<size_t>(recv_status)] = '\0';
-
-      if (!headers_parsed)
+      uint64_t offset = append ? resume_from : 0;
+      if (!framing.chunked && !framing.until_close)
       {
-        headers += buffer.data();
-        if (size_t header_end = headers.find("\r\n\r\n");
-            header_end != std::string::npos)
-        {
-          headers_parsed = true;
-          std::string header_part = headers.substr(0, header_end);
-          std::string body_part = headers.substr(header_end + 4);
-
-          if (size_t status_pos = header_part.find(' ');
-              status_pos != std::string::npos)
-          {
-            if (size_t status_end = header_part.find(' ', status_pos + 1);
-                status_end != std::string::npos)
-            {
-              std::string status_code = header_part.substr(status_pos + 1, status_end - status_pos - 1);
-              if (int code = std::stoi(status_code); code >= 400)
-              {
-                fclose(file);
-                freeaddrinfo(result);
-                close_socket(sockfd);
-                cleanup_winsock();
-                return {false, 9, "HTTP error: " + status_code};
-              }
-            }
-          }
-
-          fwrite(body_part.c_str(), 1, body_part.length(), file);
-        }
-      }
-      else
-      {
-        fwrite(buffer.data(), 1, recv_status, file);
+        file.reserve(offset + framing.content_length);
       }
+      result = stream_response_body(sockfd, buffer, framing, std::string_view(head).substr(framing.body),
+                                    [&file, &offset](const char *data, const size_t size)
+                                    {
+                                      if (!file.write_at(offset, data, size))
+                                      {
+                                        return false;
+                                      }
+                                      offset += size;
+                                      return true;
+                                    });
     }
-    fclose(file);
-    freeaddrinfo(result);
+    const bool closed = file.close();
     close_socket(sockfd);
     cleanup_winsock();
 
-    if (recv_status < 0)
+    if (!result.success)
     {
-      if (test_download_hook)
+      if (result.error_code == 8 && test_download_hook)
       {
         if (int forced = test_download_hook("recv_error"); forced != 0)
         {
           return {false, forced, "Forced recv failure"};
         }
       }
-      return {false, 8, "Network error during download"};
+      return result;
+    }
+    if (!closed)
+    {
+      return {false, 7, "Failed to write output file"};
     }
 
     return {true, 0, "File downloaded successfully"};
@@ -849,46 +3227,67 @@ public:
     std::string path = parsed_url.path;
     int port = parsed_url.port;
 
-    // Create socket and send HTTP request
-    int sockfd = create_socket_connection(host, port);
-    if (sockfd < 0)
+    return send_pooled_request(host, port, build_get_request(host, path));
+  }
+
+  // Structured variant of http_get: parsed status, header views and the
+  // decoded body, without re-parsing a raw response string.
+  static HttpResponse http_get_response(const std::string &url)
+  {
+    if (url.empty())
     {
-      return "Failed to connect";
+      HttpResponse response;
+      response.error_code = 6;
+      response.message = "Invalid URL format";
+      return response;
     }
-
-    std::string request = "GET " + path + " HTTP/1.1\r\n";
-    request += "Host: " + host + "\r\n";
-    request += "Connection: close\r\n";
-    request += "User-Agent: pixelLib/1.0\r\n";
-    request += "\r\n";
-
-    // Send request
-    if (ssize_t sent = send(sockfd, request.c_str(), request.length(), 0);
-        sent < 0)
+    if (is_test_mode())
     {
-      close_socket_connection(sockfd);
-      return "Failed to send request";
+      return mock_response(url);
     }
 
-    // Receive response
-    std::string response;
-    constexpr size_t download_buffer_size = 1024 * 1024;
-    std::vector<char> buffer(download_buffer_size);
-    ssize_t received = 0;
+    thread_local std::vector<char> buffer(64 * 1024);
+    HttpResponse response;
+    fetch_streaming(url, buffer, response, [&response](const char *data, const size_t size)
+                    {
+                      response.body.append(data, size);
+                      return true;
+                    });
+    return response;
+  }
 
-    while ((received = recv(sockfd, buffer.data(), buffer.size() - 1, 0)) > 0)
+  // Streaming GET: body bytes are handed to on_body as they arrive, straight
+  // out of the caller-provided receive buffer (resized to 16 KiB if empty), so
+  // large responses can be piped into a parser or file without being held in
+  // memory, e.g. a JSON body into json::StreamingParser with
+  // [&parser](std::string_view chunk) { return parser.feed(chunk); }.
+  // on_body returning false aborts the transfer (error_code 10). The
+  // returned response carries status and headers; its body stays empty.
+  static HttpResponse http_get_stream(const std::string &url, std::vector<char> &buffer, const std::function<bool(std::string_view)> &on_body)
+  {
+    if (url.empty())
     {
-      buffer[static_cast<size_t>(received)] = '\0';
-      response.append(buffer.data(), static_cast<size_t>(received));
+      HttpResponse response;
+      response.error_code = 6;
+      response.message = "Invalid URL format";
+      return response;
     }
-
-    close_socket_connection(sockfd);
-
-    if (response.empty())
+    if (is_test_mode())
     {
-      return "No response received";
+      HttpResponse response = mock_response(url);
+      if (on_body && !response.body.empty() && !on_body(response.body))
+      {
+        response.success = false;
+        response.error_code = 10;
+        response.message = "Body callback aborted the transfer";
+      }
+      response.body.clear();
+      return response;
     }
 
+    HttpResponse response;
+    fetch_streaming(url, buffer, response, [&on_body](const char *data, const size_t size)
+                    { return !on_body || size == 0 || on_body(std::string_view(data, size)); });
     return response;
   }
 
@@ -922,50 +3321,87 @@ public:
     std::string path = parsed_url.path;
     int port = parsed_url.port;
 
-    // Create a socket and send HTTP POST request
-    int sockfd = create_socket_connection(host, port);
-    if (sockfd < 0)
-    {
-      return "Failed to connect";
-    }
-
     std::string request = "POST " + path + " HTTP/1.1\r\n";
     request += "Host: " + host + "\r\n";
     request += "Content-Type: application/x-www-form-urlencoded\r\n";
     request += "Content-Length: " + std::to_string(payload.length()) + "\r\n";
-    request += "Connection: close\r\n";
+    request += connection_pool().reuse_enabled() ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
     request += "User-Agent: pixelLib/1.0\r\n";
     request += "\r\n";
     request += payload;
 
-    // Send request
-    if (ssize_t sent = send(sockfd, request.c_str(), request.length(), 0);
-        sent < 0)
+    return send_pooled_request(host, port, request);
+  }
+
+  // Fetches every URL concurrently from the calling thread using non-blocking
+  // sockets and one event loop (epoll/kqueue/WSAPoll). callback runs on the
+  // calling thread once per URL, in completion order, and the return value is
+  // the number of successful requests. Only plain http URLs are supported;
+  // names resolve through the shared resolver cache.
+  static size_t http_get_many(const std::vector<std::string> &urls, const std::function<void(const HttpBatchResult &)> &callback,
+                              const HttpBatchOptions &options = HttpBatchOptions())
+  {
+    if (urls.empty())
     {
-      close_socket_connection(sockfd);
-      return "Failed to send request";
+      return 0;
     }
 
-    // Receive response
-    std::string response;
-    constexpr size_t download_buffer_size = 1024 * 1024;
-    std::vector<char> buffer(download_buffer_size);
-    ssize_t received = 0;
-
-    while ((received = recv(sockfd, buffer.data(), buffer.size() - 1, 0)) > 0)
+    if (is_test_mode())
     {
-      buffer[static_cast<size_t>(received)] = '\0';
-      response.append(buffer.data(), static_cast<size_t>(received));
+      // In test mode, answer each URL with the deterministic http_get response
+      size_t succeeded = 0;
+      for (size_t i = 0; i < urls.size(); ++i)
+      {
+        HttpBatchResult result;
+        result.index = i;
+        result.url = urls[i];
+        result.response = http_get(urls[i]);
+        result.success = !urls[i].empty();
+        result.error_code = result.success ? 0 : 6;
+        result.message = result.success ? "OK" : "Invalid URL format";
+        succeeded += result.success ? 1 : 0;
+        if (callback)
+        {
+          callback(result);
+        }
+      }
+      return succeeded;
     }
 
-    close_socket_connection(sockfd);
-
-    if (response.empty())
+    if (!initialize_winsock())
     {
-      return "No response received";
+      return 0;
+    }
+    size_t succeeded = 0;
+    {
+      HttpBatch batch(urls, callback, options);
+      succeeded = batch.run();
     }
+    cleanup_winsock();
+    return succeeded;
+  }
 
-    return response;
+  // Keep-alive pool used by http_get/http_post. Changing the options trims idle
+  // connections that exceed the new limits.
+  static void set_connection_pool_options(const ConnectionPoolOptions &options)
+  {
+    connection_pool().configure(options);
+  }
+
+  static ConnectionPoolOptions get_connection_pool_options()
+  {
+    return connection_pool().options();
+  }
+
+  static ConnectionPoolStats get_connection_pool_stats()
+  {
+    return connection_pool().stats();
+  }
+
+  // Closes every idle pooled connection; connections in use are unaffected.
+  static void clear_connection_pool()
+  {
+    connection_pool().clear();
   }
 
   static std::string https_get(const std::string &url)
@@ -978,53 +3414,128 @@ public:
     return "HTTPS POST response from " + url + " with payload: " + payload;
   }
 
-  static std::string url_encode(const std::string &value)
+private:
+  // Lookup tables for the URL codec: RFC 3986 unreserved characters, and the
+  // value of each hex digit (-1 for anything else).
+  struct UrlCodecTables
   {
-    std::ostringstream escaped;
-    escaped.fill('0');
-    escaped << std::hex;
+    std::array<bool, 256> unreserved{};
+    std::array<int8_t, 256> hex_value{};
+  };
 
-    for (char c : value)
+  static const UrlCodecTables &url_codec_tables()
+  {
+    static constexpr UrlCodecTables tables = []
     {
-      if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~')
+      UrlCodecTables t;
+      t.hex_value.fill(-1);
+      for (int c = 0; c < 256; ++c)
       {
-        escaped << c;
+        t.unreserved[c] = (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.' || c == '~';
       }
-      else
+      for (int c = 0; c < 10; ++c)
       {
-        escaped << '%' << std::setw(2) << static_cast<int>(static_cast<unsigned char>(c));
+        t.hex_value['0' + c] = static_cast<int8_t>(c);
       }
-    }
-
-    return escaped.str();
+      for (int c = 0; c < 6; ++c)
+      {
+        t.hex_value['a' + c] = static_cast<int8_t>(10 + c);
+        t.hex_value['A' + c] = static_cast<int8_t>(10 + c);
+      }
+      return t;
+    }();
+    return tables;
   }
 
-  static std::string url_decode(const std::string &value)
+  // Decodes size bytes from in to out and returns the decoded length; out may
+  // equal in. A truncated escape at the end stops decoding, an escape with
+  // non-hex digits is copied through unchanged.
+  static size_t percent_decode(const char *in, const size_t size, char *out, const bool plus_as_space)
   {
-    std::ostringstream unescaped;
-    for (size_t i = 0; i < value.length(); ++i)
+    const auto &hex_value = url_codec_tables().hex_value;
+    size_t written = 0;
+    for (size_t i = 0; i < size; ++i)
     {
-      if (value[i] == '%')
+      const char c = in[i];
+      if (c == '%')
       {
-        if (i + 2 < value.length())
+        if (i + 2 >= size)
         {
-          std::istringstream iss(value.substr(i + 1, 2));
-          int hex_val;
-          iss >> std::hex >> hex_val;
-          unescaped << static_cast<char>(hex_val);
-          i += 2;
+          break;
         }
-        else
+        const int high = hex_value[static_cast<unsigned char>(in[i + 1])];
+        const int low = hex_value[static_cast<unsigned char>(in[i + 2])];
+        if (high >= 0 && low >= 0)
         {
-          return unescaped.str();
+          out[written++] = static_cast<char>((high << 4) | low);
+          i += 2;
+          continue;
         }
       }
+      out[written++] = (plus_as_space && c == '+') ? ' ' : c;
+    }
+    return written;
+  }
+
+public:
+  // Appends the percent-encoding of value to out without intermediate
+  // buffers; out grows at most once. value must not view into out.
+  static void url_encode_to(const std::string_view value, std::string &out, const bool uppercase_hex = false)
+  {
+    const auto &unreserved = url_codec_tables().unreserved;
+    const char *digits = uppercase_hex ? "0123456789ABCDEF" : "0123456789abcdef";
+    size_t escaped = 0;
+    for (const char c : value)
+    {
+      escaped += unreserved[static_cast<unsigned char>(c)] ? 0 : 1;
+    }
+    size_t pos = out.size();
+    out.resize(pos + value.size() + 2 * escaped);
+    for (const char c : value)
+    {
+      const auto byte = static_cast<unsigned char>(c);
+      if (unreserved[byte])
+      {
+        out[pos++] = c;
+      }
       else
       {
-        unescaped << value[i];
+        out[pos++] = '%';
+        out[pos++] = digits[byte >> 4];
+        out[pos++] = digits[byte & 0x0F];
       }
     }
-    return unescaped.str();
+  }
+
+  // Appends the decoding of value to out; see url_decode for the rules.
+  // With plus_as_space, '+' decodes to a space (form encoding).
+  static void url_decode_to(const std::string_view value, std::string &out, const bool plus_as_space = false)
+  {
+    const size_t pos = out.size();
+    out.resize(pos + value.size());
+    out.resize(pos + percent_decode(value.data(), value.size(), out.data() + pos, plus_as_space));
+  }
+
+  // Decodes value in place; decoding never lengthens the text.
+  static void url_decode_in_place(std::string &value, const bool plus_as_space = false)
+  {
+    value.resize(percent_decode(value.data(), value.size(), value.data(), plus_as_space));
+  }
+
+  static std::string url_encode(const std::string &value)
+  {
+    std::string escaped;
+    url_encode_to(value, escaped);
+    return escaped;
+  }
+
+  // Decodes %XX escapes; a truncated escape at the end is dropped and one
+  // with non-hex digits is kept literally.
+  static std::string url_decode(const std::string &value)
+  {
+    std::string unescaped;
+    url_decode_to(value, unescaped);
+    return unescaped;
   }
 
   static std::vector<std::string> get_network_interfaces()
@@ -1049,7 +3560,7 @@ public:
     // Allocation-free, pointer-based parser optimized for tight loops.
     // Avoids repeated calls to size()/operator[] and extra integer casts
     // to reduce per-character overhead. Local microbenchmark (see
-    // tests::Ipv4Performance) shows a measurable improvement over the
+    // the network/ipv4 benchmarks) shows a measurable improvement over the
     // previous index-based loop in hot code paths. Measured locally on
     // Linux x86_64 (100k iterations): valid ~6ms (was ~16ms), invalid ~3ms
     // (was ~5ms), i.e. ~2-3x faster in common cases.
@@ -1155,44 +3666,14 @@ public:
     {
       return -1;
     }
-    if (!initialize_winsock())
-    {
-      return -1;
-    }
-    struct addrinfo hints = {}, *result = nullptr;
-    hints.ai_family = AF_UNSPEC;
-    hints.ai_socktype = SOCK_STREAM;
-
-    const std::string port_str = std::to_string(port);
-    int status = getaddrinfo(host.c_str(), port_str.c_str(), &hints, &result);
-    if (status != 0)
-    {
-      cleanup_winsock();
-      return -1;
-    }
-
-    const int sockfd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
-    if (sockfd < 0)
-    {
-      freeaddrinfo(result);
-      cleanup_winsock();
-      return -1;
-    }
-
-    // Set timeout to prevent hanging during connection
-    set_socket_timeout(3, sockfd);
-
-    status = connect(sockfd, result->ai_addr, result->ai_addrlen);
-    freeaddrinfo(result);
-
-    if (status < 0)
+    const auto resolution = resolver_cache().resolve(host);
+    if (resolution->status != 0)
     {
-      close_socket(sockfd);
-      cleanup_winsock();
       return -1;
     }
-    cleanup_winsock();
-    return sockfd;
+    // Fail over through every resolved address, each with a 3 second timeout
+    bool socket_failed = false;
+    return connect_resolved(*resolution, port, 3, socket_failed);
   }
 
   static bool close_socket_connection(const int socket_fd)
@@ -1243,176 +3724,236 @@ public:
     return response_code >= 200 && response_code < 300;
   }
 
-  static double measure_latency(const std::string &host, const int count = 4)
+private:
+  static void summarize_latency(std::vector<double> &samples, LatencyProbeResult &result)
   {
-    if (host.empty() || count <= 0)
+    result.successes = samples.size();
+    if (samples.empty())
     {
-      return -1.0;
+      return;
     }
-
-    if (is_test_mode())
+    double jitter = 0.0;
+    for (size_t i = 1; i < samples.size(); ++i)
     {
-      // In test mode, return deterministic values
-      return 50.0 + (static_cast<double>(host.length()) * 0.1);
+      jitter += std::abs(samples[i] - samples[i - 1]);
     }
+    result.jitter_ms = samples.size() > 1 ? jitter / static_cast<double>(samples.size() - 1) : 0.0;
 
-    // Real implementation using actual socket connections
-    double total_latency = 0.0;
-    int successful_pings = 0;
-
-    for (int i = 0; i < count; ++i)
+    std::sort(samples.begin(), samples.end());
+    double total = 0.0;
+    for (const double sample : samples)
     {
-      auto start_time = std::chrono::high_resolution_clock::now();
-
-      // Use socket connection to measure actual latency
-      if (const int sockfd = create_socket_connection(host, 80); sockfd >= 0)
-      {
-        close_socket_connection(sockfd);
-        auto end_time = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
-        const double latency_ms = static_cast<double>(duration.count()) / 1000.0;
-        total_latency += latency_ms;
-        successful_pings++;
-      }
+      total += sample;
     }
-
-    if (successful_pings == 0)
+    const auto rank = [&samples](const double percentile)
     {
-      return -1.0;
-    }
-
-    return total_latency / successful_pings;
+      const auto position = static_cast<size_t>(std::ceil(percentile / 100.0 * static_cast<double>(samples.size())));
+      return samples[std::clamp<size_t>(position, 1, samples.size()) - 1];
+    };
+    result.min_ms = samples.front();
+    result.max_ms = samples.back();
+    result.mean_ms = total / static_cast<double>(samples.size());
+    result.p50_ms = rank(50.0);
+    result.p95_ms = rank(95.0);
+    result.p99_ms = rank(99.0);
+    result.samples_ms = std::move(samples);
   }
 
-  static double measure_bandwidth(const std::string &host)
+public:
+  // Times count TCP connects to host:port, up to concurrency at a time.
+  // Errors: 1 invalid arguments, 2 resolution failed, 8 no connect succeeded.
+  static LatencyProbeResult probe_latency(const std::string &host, const LatencyProbeOptions &options = LatencyProbeOptions())
   {
-    if (host.empty())
+    LatencyProbeResult result;
+    if (host.empty() || options.count == 0 || options.port <= 0 || options.port > 65535)
     {
-      return -1.0;
+      result.error_code = 1;
+      result.message = "Invalid latency probe arguments";
+      return result;
     }
+    result.attempts = options.count;
 
+    std::vector<double> samples(options.count, -1.0);
     if (is_test_mode())
     {
-      // In test mode, do a real download test but limit to 3 seconds
-      std::string temp_file = "build/tmp/bandwidth_test_" + std::to_string(std::time(nullptr));
-
-      auto start_time = std::chrono::high_resolution_clock::now();
-
-      // Try to download from known test endpoints
-      bool download_success = false;
-
-      if (auto result = download_file(host, temp_file); result.success)
+      // In test mode, return deterministic values
+      std::fill(samples.begin(), samples.end(), 50.0 + (static_cast<double>(host.length()) * 0.1));
+    }
+    else
+    {
+      const auto resolution = resolver_cache().resolve(host);
+      if (resolution->status != 0)
       {
-        download_success = true;
+        result.error_code = 2;
+        result.message = "Failed to resolve hostname";
+        return result;
       }
 
-      if (!download_success)
+      std::atomic<size_t> next{0};
+      const auto worker = [&]
       {
-        // Fallback: create a local test file and measure local transfer speed
-        if (std::ofstream test_file(temp_file, std::ios::binary);
-            test_file.is_open())
+        for (size_t i = next++; i < options.count; i = next++)
         {
-          constexpr auto test_size = static_cast<size_t>(1024 * 1024); // 1MB
-          std::vector<char> buffer(test_size, 0);
-          test_file.write(buffer.data(), test_size);
-          test_file.close();
-          download_success = true;
+          const auto start_time = std::chrono::steady_clock::now();
+          bool socket_failed = false;
+          if (const int sockfd = connect_resolved(*resolution, options.port, options.timeout_sec, socket_failed); sockfd >= 0)
+          {
+            const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time);
+            close_socket_connection(sockfd);
+            samples[i] = static_cast<double>(duration.count()) / 1000.0;
+          }
         }
-      }
-
-      if (!download_success)
+      };
+      const size_t workers = std::clamp<size_t>(options.concurrency, 1, options.count);
+      std::vector<std::thread> threads;
+      threads.reserve(workers - 1);
+      for (size_t i = 1; i < workers; ++i)
       {
-        std::remove(temp_file.c_str());
-        return -1.0;
+        threads.emplace_back(worker);
       }
-
-      auto actual_end_time = std::chrono::high_resolution_clock::now();
-      auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(actual_end_time - start_time);
-
-      // Get file size
-      std::ifstream file(temp_file, std::ios::binary | std::ios::ate);
-      if (!file.is_open())
+      worker();
+      for (auto &thread : threads)
       {
-        std::remove(temp_file.c_str());
-        return -1.0;
+        thread.join();
       }
-
-      size_t file_size = file.tellg();
-      file.close();
-
-      // Calculate bandwidth in Mbps
-      double seconds = static_cast<double>(duration.count()) / 1000.0;
-      double bits_per_second = (static_cast<double>(file_size) * 8) / seconds;
-      double mbps = bits_per_second / (1024 * 1024);
-
-      std::remove(temp_file.c_str());
-
-      return mbps;
     }
 
-    // Real implementation by measuring download speed
-    std::string temp_file = "build/tmp/bandwidth_test_" + std::to_string(std::time(nullptr));
+    std::erase_if(samples, [](const double sample) { return sample < 0.0; });
+    summarize_latency(samples, result);
+    if (result.successes == 0)
+    {
+      result.error_code = 8;
+      result.message = "No connection attempt succeeded";
+      return result;
+    }
+    result.success = true;
+    return result;
+  }
 
-    auto start_time = std::chrono::high_resolution_clock::now();
+  // Downloads url over options.streams parallel connections and counts the
+  // body bytes in memory; nothing is written to disk. Each stream opens its
+  // own connection outside the keep-alive pool, so the streams really run
+  // concurrently. Succeeds when at least one stream received a 2xx response,
+  // otherwise reports the first error.
+  static BandwidthProbeResult probe_bandwidth(const std::string &url, const BandwidthProbeOptions &options = BandwidthProbeOptions())
+  {
+    BandwidthProbeResult result;
+    if (url.empty())
+    {
+      result.error_code = 6;
+      result.message = "Invalid URL format";
+      return result;
+    }
 
-    // Try to download from known test endpoints
-    bool download_success = false;
-    std::vector<std::string> test_endpoints = {
-        "http://speedtest.wdc01.softlayer.com/downloads/test10.zip", "http://proof.ovh.net/files/1Mb.dat",
-        "http://httpbin.org/bytes/1048576" // 1MB test data
+    struct StreamOutcome
+    {
+      HttpResponse response;
+      uint64_t bytes = 0;
+      bool limited = false;
     };
-
-    for (const auto &url : test_endpoints)
+    const size_t streams = std::max<size_t>(options.streams, 1);
+    std::vector<StreamOutcome> outcomes(streams);
+    const auto start_time = std::chrono::steady_clock::now();
+    const auto deadline = start_time + options.duration;
+    const auto run_stream = [&](StreamOutcome &outcome)
     {
-      if (auto result = download_file(url, temp_file); result.success)
+      std::vector<char> buffer(64 * 1024);
+      const auto count = [&](const std::string_view chunk)
       {
-        download_success = true;
-        break;
+        outcome.bytes += chunk.size();
+        outcome.limited = (options.max_bytes_per_stream > 0 && outcome.bytes >= options.max_bytes_per_stream) ||
+                          (options.duration.count() > 0 && std::chrono::steady_clock::now() >= deadline);
+        return !outcome.limited;
+      };
+      if (is_test_mode())
+      {
+        outcome.response = http_get_stream(url, buffer, count);
+        return;
       }
+      fetch_streaming(url, buffer, outcome.response, [&count](const char *data, const size_t size)
+                      { return size == 0 || count(std::string_view(data, size)); }, true);
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(streams - 1);
+    for (size_t i = 1; i < streams; ++i)
+    {
+      threads.emplace_back(run_stream, std::ref(outcomes[i]));
+    }
+    run_stream(outcomes[0]);
+    for (auto &thread : threads)
+    {
+      thread.join();
     }
+    result.elapsed = std::max(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time),
+                              std::chrono::microseconds(1));
 
-    if (!download_success)
+    for (const auto &outcome : outcomes)
     {
-      // Fallback: create a local test file and measure local transfer speed
-      if (std::ofstream test_file(temp_file, std::ios::binary);
-          test_file.is_open())
+      const bool completed = outcome.response.success || (outcome.limited && outcome.response.error_code == 10);
+      if (completed && outcome.response.ok())
       {
-        constexpr auto test_size = static_cast<size_t>(1024 * 1024); // 1MB
-        std::vector<char> buffer(test_size, 0);
-        test_file.write(buffer.data(), test_size);
-        test_file.close();
-        download_success = true;
+        ++result.streams;
+        result.bytes += outcome.bytes;
       }
+      else if (result.error_code == 0)
+      {
+        result.error_code = outcome.response.error_code != 0 ? outcome.response.error_code : 9;
+        result.message = outcome.response.error_code != 0 ? outcome.response.message : "HTTP error " + std::to_string(outcome.response.status);
+      }
+    }
+    if (result.streams == 0)
+    {
+      return result;
     }
+    result.success = true;
+    result.error_code = 0;
+    result.message.clear();
+    const double seconds = static_cast<double>(result.elapsed.count()) / 1e6;
+    result.mbps = (static_cast<double>(result.bytes) * 8) / seconds / (1024 * 1024);
+    return result;
+  }
 
-    if (!download_success)
+  // Mean connect time to port 80 over count sequential attempts; see
+  // probe_latency for the full distribution.
+  static double measure_latency(const std::string &host, const int count = 4)
+  {
+    if (host.empty() || count <= 0)
     {
-      std::remove(temp_file.c_str());
       return -1.0;
     }
+    LatencyProbeOptions options;
+    options.count = static_cast<size_t>(count);
+    options.concurrency = 1;
+    const auto result = probe_latency(host, options);
+    return result.success ? result.mean_ms : -1.0;
+  }
 
-    auto end_time = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
-
-    // Get file size
-    std::ifstream file(temp_file, std::ios::binary | std::ios::ate);
-    if (!file.is_open())
+  // Throughput in Mbps of the first reachable test endpoint (host itself in
+  // test mode). Returns -1.0 when no endpoint answers.
+  static double measure_bandwidth(const std::string &host)
+  {
+    if (host.empty())
     {
-      std::remove(temp_file.c_str());
       return -1.0;
     }
 
-    size_t file_size = file.tellg();
-    file.close();
-
-    // Calculate bandwidth in Mbps
-    double seconds = static_cast<double>(duration.count()) / 1000.0;
-    double bits_per_second = (static_cast<double>(file_size) * 8) / seconds;
-    double mbps = bits_per_second / (1024 * 1024);
-
-    std::remove(temp_file.c_str());
+    std::vector<std::string> test_endpoints = {host};
+    if (!is_test_mode())
+    {
+      test_endpoints = {
+          "http://speedtest.wdc01.softlayer.com/downloads/test10.zip", "http://proof.ovh.net/files/1Mb.dat",
+          "http://httpbin.org/bytes/1048576" // 1MB test data
+      };
+    }
 
-    return mbps;
+    for (const auto &url : test_endpoints)
+    {
+      if (const auto result = probe_bandwidth(url); result.success && result.bytes > 0)
+      {
+        return result.mbps;
+      }
+    }
+    return -1.0;
   }
 
   static int test_get_connection_error_with_errno(int err);
@@ -1433,6 +3974,23 @@ public:
 // Define static hook variables as inline to avoid ODR violations
 inline std::function<int(const std::string &)> Network::test_download_hook;
 inline std::function<int(const std::string &)> Network::test_is_host_hook;
+inline std::function<int(const std::string &)> Network::test_resolve_hook;
+
+// Form-encoding spellings of Network::url_encode/url_decode: uppercase hex
+// escapes, and '+' decodes to a space.
+inline std::string url_encode(const std::string &value)
+{
+  std::string result;
+  Network::url_encode_to(value, result, true);
+  return result;
+}
+
+inline std::string url_decode(const std::string &value)
+{
+  std::string result;
+  Network::url_decode_to(value, result, true);
+  return result;
+}
 
 // Test helper implementations
 inline int Network::test_get_connection_error_with_errno(int err)
@@ -1,8 +1,11 @@
 #include "../include/filesystem.hpp"
+#include "../include/json.hpp"
 #include "../third-party/doctest/doctest.h"
 
 #include <algorithm>
+#include <atomic>
 #include <random>
+#include <set>
 #include <string>
 #include <vector>
 #include <cstdlib>
@@ -119,6 +122,260 @@ TEST_SUITE("FileSystem Module")
     remove_dir_tree(dir);
   }
 
+  TEST_CASE("MappedFile")
+  {
+    using pixellib::core::filesystem::MappedFile;
+    std::string dir = make_temp_dir();
+    REQUIRE(!dir.empty());
+
+    const std::string file = dir + "/config.json";
+    REQUIRE(FileSystem::write_file(file, R"({"name": "pixel", "values": [1, 2, 3]})"));
+    {
+      MappedFile mapped(file);
+      REQUIRE(mapped.is_open());
+      CHECK(mapped.size() == static_cast<size_t>(FileSystem::file_size(file)));
+      CHECK(mapped.view() == FileSystem::read_file(file));
+
+      // The parser reads straight from the mapped pages.
+      pixellib::core::json::JSON doc;
+      REQUIRE(pixellib::core::json::JSON::parse(mapped.view(), doc));
+      REQUIRE(doc.find("name") != nullptr);
+      CHECK(doc.find("name")->as_string_view() == "pixel");
+
+      MappedFile moved = std::move(mapped);
+      CHECK_FALSE(mapped.is_open());
+      CHECK(mapped.view().empty());
+      CHECK(moved.view().substr(0, 9) == R"({"name": )");
+      moved.close();
+      CHECK_FALSE(moved.is_open());
+    }
+
+    const std::string empty = dir + "/empty.txt";
+    REQUIRE(FileSystem::write_file(empty, ""));
+    MappedFile mapped_empty(empty);
+    CHECK(mapped_empty.is_open());
+    CHECK(mapped_empty.size() == 0);
+    CHECK(mapped_empty.view().empty());
+
+    MappedFile missing;
+    CHECK_FALSE(missing.open(dir + "/missing.txt"));
+    CHECK_FALSE(missing.is_open());
+    CHECK_FALSE(missing.open(dir));
+
+    mapped_empty.close();
+    remove_dir_tree(dir);
+  }
+
+  TEST_CASE("CopyFileContents")
+  {
+    std::string dir = make_temp_dir();
+    REQUIRE(!dir.empty());
+
+    // Several MiB of binary data, including NULs, copy byte for byte.
+    std::string payload(3 * 1024 * 1024 + 17, '\0');
+    for (size_t i = 0; i < payload.size(); ++i)
+      payload[i] = static_cast<char>((i * 131 + (i >> 12)) & 0xFF);
+    const std::string src = dir + "/big.bin";
+    const std::string dst = dir + "/copy.bin";
+    REQUIRE(FileSystem::write_file(src, payload));
+    REQUIRE(FileSystem::write_file(dst, payload + payload)); // larger file is truncated
+    CHECK(FileSystem::copy_file(src, dst));
+    CHECK(FileSystem::file_size(dst) == static_cast<long long>(payload.size()));
+    CHECK(FileSystem::read_file(dst) == payload);
+
+    const std::string empty_src = dir + "/empty.bin";
+    REQUIRE(FileSystem::write_file(empty_src, ""));
+    CHECK(FileSystem::copy_file(empty_src, dst));
+    CHECK(FileSystem::file_size(dst) == 0);
+
+    CHECK_FALSE(FileSystem::copy_file(dir + "/missing.bin", dst));
+    CHECK_FALSE(FileSystem::copy_file(src, dir + "/no/such/dir/copy.bin"));
+    CHECK_FALSE(FileSystem::copy_file(dir, dst));
+
+    remove_dir_tree(dir);
+  }
+
+  TEST_CASE("WriteFileAtomic")
+  {
+    std::string dir = make_temp_dir();
+    REQUIRE(!dir.empty());
+
+    const std::string file = dir + "/state.txt";
+    CHECK(FileSystem::write_file_atomic(file, "first version"));
+    CHECK(FileSystem::read_file(file) == "first version");
+    CHECK(FileSystem::write_file_atomic(file, "second"));
+    CHECK(FileSystem::read_file(file) == "second");
+    CHECK(FileSystem::write_file_atomic(file, ""));
+    CHECK(FileSystem::file_size(file) == 0);
+
+#ifndef _WIN32
+    // The replacement keeps the permission bits of the file it replaces.
+    REQUIRE(::chmod(file.c_str(), 0640) == 0);
+    CHECK(FileSystem::write_file_atomic(file, "private"));
+    struct stat info;
+    REQUIRE(::stat(file.c_str(), &info) == 0);
+    CHECK((info.st_mode & 07777) == 0640);
+    CHECK(FileSystem::read_file(file) == "private");
+#endif
+
+    // No temporary files are left behind.
+    CHECK(FileSystem::directory_iterator(dir) == std::vector<std::string>{"state.txt"});
+
+    CHECK_FALSE(FileSystem::write_file_atomic(dir + "/no/such/dir/state.txt", "x"));
+    CHECK_FALSE(FileSystem::write_file_atomic(dir, "replacing a directory fails"));
+    CHECK(FileSystem::is_directory(dir));
+    CHECK(FileSystem::directory_iterator(dir) == std::vector<std::string>{"state.txt"});
+
+    remove_dir_tree(dir);
+  }
+
+  TEST_CASE("DirectoryWalker")
+  {
+    using pixellib::core::filesystem::DirectoryEntry;
+    using pixellib::core::filesystem::DirectoryWalker;
+    using pixellib::core::filesystem::FileType;
+    using pixellib::core::filesystem::WalkOptions;
+    std::string dir = make_temp_dir();
+    REQUIRE(!dir.empty());
+
+    REQUIRE(FileSystem::write_file(dir + "/a.txt", "a"));
+    REQUIRE(FileSystem::create_directories(dir + "/sub/deeper"));
+    REQUIRE(FileSystem::create_directory(dir + "/empty"));
+    REQUIRE(FileSystem::write_file(dir + "/sub/b.txt", "b"));
+    REQUIRE(FileSystem::write_file(dir + "/sub/deeper/c.bin", "c"));
+
+    std::set<std::string> seen;
+    std::string previous_directory;
+    for (const DirectoryEntry &entry : DirectoryWalker(dir))
+    {
+      const std::string relative = entry.path.substr(dir.size() + 1);
+      seen.insert(relative + (entry.is_directory() ? "/" : "") + "@" + std::to_string(entry.depth));
+      CHECK(entry.name() == relative.substr(relative.find_last_of('/') + 1));
+      CHECK(entry.is_directory() == FileSystem::is_directory(entry.path));
+      CHECK(entry.is_regular_file() == FileSystem::is_regular_file(entry.path));
+      // Pre-order: a directory's contents follow the directory itself.
+      if (entry.depth > 0)
+        CHECK(entry.path.rfind(previous_directory, 0) == 0);
+      if (entry.is_directory())
+        previous_directory = entry.path;
+    }
+    CHECK(seen == std::set<std::string>{"a.txt@0", "empty/@0", "sub/@0", "sub/b.txt@1", "sub/deeper/@1", "sub/deeper/c.bin@2"});
+
+    WalkOptions shallow;
+    shallow.max_depth = 0;
+    size_t top_level = 0;
+    for (const DirectoryEntry &entry : DirectoryWalker(dir, shallow))
+    {
+      CHECK(entry.depth == 0);
+      ++top_level;
+    }
+    CHECK(top_level == 3);
+
+    // Rejecting a directory prunes its subtree.
+    WalkOptions pruned;
+    pruned.filter = [](const DirectoryEntry &entry) { return entry.name() != "deeper"; };
+    size_t kept = 0;
+    for (const DirectoryEntry &entry : DirectoryWalker(dir, pruned))
+    {
+      CHECK(entry.path.find("deeper") == std::string::npos);
+      ++kept;
+    }
+    CHECK(kept == 4);
+
+#ifndef _WIN32
+    REQUIRE(::symlink((dir + "/sub").c_str(), (dir + "/link").c_str()) == 0);
+    WalkOptions links;
+    links.max_depth = 0;
+    FileType link_type = FileType::Unknown;
+    CHECK(FileSystem::walk(dir, [&](const DirectoryEntry &entry) {
+      if (entry.name() == "link")
+        link_type = entry.type;
+      return true;
+    }, links));
+    CHECK(link_type == FileType::Symlink);
+    links.follow_symlinks = true;
+    links.max_depth = 1;
+    size_t through_link = 0;
+    CHECK(FileSystem::walk(dir, [&](const DirectoryEntry &entry) {
+      through_link += entry.path.find("/link/") != std::string::npos ? 1 : 0;
+      return true;
+    }, links));
+    CHECK(through_link == 2);
+    ::unlink((dir + "/link").c_str());
+#endif
+
+    size_t visited = 0;
+    CHECK(FileSystem::walk(dir, [&visited](const DirectoryEntry &) { return ++visited < 2; }));
+    CHECK(visited == 2);
+
+    DirectoryWalker missing(dir + "/missing");
+    CHECK_FALSE(missing.is_open());
+    CHECK(missing.begin() == missing.end());
+    CHECK_FALSE(FileSystem::walk(dir + "/missing", [](const DirectoryEntry &) { return true; }));
+    WalkOptions parallel;
+    parallel.threads = 4;
+    CHECK_FALSE(FileSystem::walk(dir + "/a.txt", [](const DirectoryEntry &) { return true; }, parallel));
+
+    remove_dir_tree(dir);
+  }
+
+  TEST_CASE("DirectoryWalkParallel")
+  {
+    using pixellib::core::filesystem::DirectoryEntry;
+    using pixellib::core::filesystem::WalkOptions;
+    std::string dir = make_temp_dir();
+    REQUIRE(!dir.empty());
+
+    constexpr int branches = 8;
+    constexpr int leaves = 8;
+    constexpr int files = 20;
+    for (int b = 0; b < branches; ++b)
+    {
+      for (int l = 0; l < leaves; ++l)
+      {
+        const std::string leaf = dir + "/b" + std::to_string(b) + "/l" + std::to_string(l);
+        REQUIRE(FileSystem::create_directories(leaf));
+        for (int f = 0; f < files; ++f)
+          REQUIRE(FileSystem::write_file(leaf + "/f" + std::to_string(f), ""));
+      }
+    }
+    // One directory larger than a worker's batch, so entries are delivered in several batches
+    REQUIRE(FileSystem::create_directories(dir + "/wide"));
+    for (int f = 0; f < 700; ++f)
+      REQUIRE(FileSystem::write_file(dir + "/wide/w" + std::to_string(f), ""));
+    const size_t expected = branches + branches * leaves + branches * leaves * files + 1 + 700;
+
+    std::set<std::string> sequential;
+    CHECK(FileSystem::walk(dir, [&sequential](const DirectoryEntry &entry) {
+      sequential.insert(entry.path + (entry.is_directory() ? "/" : ""));
+      return true;
+    }));
+
+    // visit is never entered from two workers at once
+    WalkOptions options;
+    options.threads = 4;
+    std::set<std::string> parallel;
+    std::atomic<int> inside{0};
+    std::atomic<bool> overlapped{false};
+    CHECK(FileSystem::walk(dir, [&](const DirectoryEntry &entry) {
+      if (inside.fetch_add(1) != 0)
+        overlapped = true;
+      parallel.insert(entry.path + (entry.is_directory() ? "/" : ""));
+      inside.fetch_sub(1);
+      return true;
+    }, options));
+    CHECK_FALSE(overlapped);
+    CHECK(sequential.size() == expected);
+    CHECK(parallel == sequential);
+
+    // Stopping from one worker ends the whole walk.
+    std::atomic<size_t> visits{0};
+    CHECK(FileSystem::walk(dir, [&visits](const DirectoryEntry &) { return ++visits < 10; }, options));
+    CHECK(visits == 10);
+
+    remove_dir_tree(dir);
+  }
+
   TEST_CASE("TempPath")
   {
     std::string tmp = FileSystem::temp_directory_path();
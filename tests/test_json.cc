@@ -2,9 +2,15 @@
 #include "../third-party/doctest/doctest.h"
 
 #include <cstdint>
+#include <filesystem>
+#include <fstream>
 #include <limits>
+#include <memory_resource>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 TEST_SUITE("JSON Module")
 {
@@ -314,4 +320,955 @@ TEST_SUITE("JSON Module")
     CHECK(obj["newKey"].is_string());
     CHECK(obj["newKey"].as_string() == std::string("hello"));
   }
-}
\ No newline at end of file
+
+  TEST_CASE("ParseStringView")
+  {
+    const std::string buffer = "xx[1,\"two\"]yy";
+    std::string_view text = std::string_view(buffer).substr(2, buffer.size() - 4);
+    pixellib::core::json::JSON v;
+    CHECK(pixellib::core::json::JSON::parse(text, v));
+    REQUIRE(v.is_array());
+    CHECK(v.as_array()[1].as_string() == "two");
+    CHECK_FALSE(v.as_array()[1].is_borrowed());
+    CHECK(pixellib::core::json::JSON::validate(text));
+  }
+
+  TEST_CASE("ParseBorrowed")
+  {
+    const std::string buffer = R"({"name":"plain","esc":"a\nb","n":-12.5e3})";
+    pixellib::core::json::ParseOptions options;
+    options.borrow = true;
+    pixellib::core::json::JSON v;
+    REQUIRE(pixellib::core::json::JSON::parse(buffer, v, options));
+
+    const pixellib::core::json::JSON *name = v.find("name");
+    REQUIRE(name);
+    CHECK(name->is_borrowed());
+    CHECK(name->as_string_view() == "plain");
+    CHECK(name->as_string_view().data() >= buffer.data());
+    CHECK(name->as_string_view().data() < buffer.data() + buffer.size());
+    CHECK_THROWS_AS(name->as_string(), std::logic_error);
+
+    // Strings with escapes are materialized at parse time
+    const pixellib::core::json::JSON *esc = v.find("esc");
+    REQUIRE(esc);
+    CHECK_FALSE(esc->is_borrowed());
+    CHECK(esc->as_string() == "a\nb");
+
+    const pixellib::core::json::JSON *n = v.find("n");
+    REQUIRE(n);
+    CHECK(n->is_borrowed());
+    CHECK(n->as_number().text() == "-12.5e3");
+    CHECK(n->as_number().to_double() == -12500.0);
+    CHECK_FALSE(n->as_number().is_integral());
+
+    CHECK(v.stringify() == buffer);
+  }
+
+  TEST_CASE("MaterializeBorrowed")
+  {
+    pixellib::core::json::JSON v;
+    {
+      std::string buffer = R"([["inner", 7], {"k": "v"}])";
+      pixellib::core::json::ParseOptions options;
+      options.borrow = true;
+      REQUIRE(pixellib::core::json::JSON::parse(buffer, v, options));
+      v.materialize();
+      buffer.assign(buffer.size(), '#');
+    }
+    CHECK_FALSE(v.as_array()[0].as_array()[0].is_borrowed());
+    CHECK(v.as_array()[0].as_array()[0].as_string() == "inner");
+    CHECK(v.as_array()[0].as_array()[1].as_number().to_int64() == 7);
+    CHECK(v.as_array()[1].find("k")->as_string() == "v");
+    CHECK(v.stringify() == R"([["inner",7],{"k":"v"}])");
+
+    CHECK_THROWS_AS(pixellib::core::json::JSON(true).as_string_view(), std::logic_error);
+  }
+
+  TEST_CASE("ParseWithMemoryResource")
+  {
+    // Counts allocations routed through the parser's resource
+    class CountingResource : public std::pmr::memory_resource
+    {
+    public:
+      size_t allocations{0};
+
+    private:
+      void *do_allocate(size_t bytes, size_t alignment) override
+      {
+        ++allocations;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+      }
+      void do_deallocate(void *p, size_t bytes, size_t alignment) override
+      {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+      }
+      bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+      {
+        return this == &other;
+      }
+    };
+
+    CountingResource counting;
+    pixellib::core::json::ParseOptions options;
+    options.resource = &counting;
+    pixellib::core::json::JSON v;
+    const std::string text = R"({"a":[1,2,[3]],"b":{"c":true},"a key longer than the inline buffer":"a string value longer than the inline buffer\n"})";
+    REQUIRE(pixellib::core::json::JSON::parse(text, v, options));
+    // Three containers, the long key and the long string
+    CHECK(counting.allocations >= 5);
+    CHECK(v.as_object().get_allocator().resource() == &counting);
+    CHECK(v.find("a")->as_array()[2].as_array().get_allocator().resource() == &counting);
+    CHECK(v.as_object().back().first.get_allocator().resource() == &counting);
+
+    // Strings live in the resource too; as_string_view() reads them in place
+    const auto *long_string = v.find("a key longer than the inline buffer");
+    REQUIRE(long_string != nullptr);
+    CHECK(long_string->as_string_view() == "a string value longer than the inline buffer\n");
+    CHECK_FALSE(long_string->is_borrowed());
+
+    // as_string() builds one std::string per node, shared by concurrent readers
+    const size_t before_as_string = counting.allocations;
+    const std::string *seen[2] = {};
+    std::thread reader([&] { seen[0] = &long_string->as_string(); });
+    seen[1] = &long_string->as_string();
+    reader.join();
+    CHECK(seen[0] == seen[1]);
+    CHECK(&long_string->as_string() == seen[0]);
+    CHECK(long_string->as_string() == "a string value longer than the inline buffer\n");
+    CHECK(counting.allocations == before_as_string);
+
+    // Copies detach from the parser's resource
+    const size_t before_copy = counting.allocations;
+    pixellib::core::json::JSON copy = v;
+    CHECK(counting.allocations == before_copy);
+    CHECK(copy.as_object().get_allocator().resource() == std::pmr::get_default_resource());
+    CHECK(copy.as_object().back().first.get_allocator().resource() == std::pmr::get_default_resource());
+    CHECK(copy.stringify() == v.stringify());
+
+    // CBOR decoding follows the same rules
+    pixellib::core::json::JSON decoded;
+    REQUIRE(pixellib::core::json::JSON::from_cbor(v.to_cbor(), decoded, options));
+    CHECK(decoded.as_object().back().first.get_allocator().resource() == &counting);
+    CHECK(decoded.stringify() == v.stringify());
+  }
+
+  TEST_CASE("JsonDocumentArena")
+  {
+    pixellib::core::json::JsonDocument doc(1024);
+    REQUIRE(doc.parse(R"([{"id":1},{"id":2}])"));
+    REQUIRE(doc.root().is_array());
+    CHECK(doc.root().as_array().size() == 2);
+    CHECK(doc.root().as_array().get_allocator().resource() == doc.resource());
+    CHECK(doc.root().as_array()[1].find("id")->as_number().to_int64() == 2);
+
+    // Mutations allocate from the same arena
+    doc.root().push_back(pixellib::core::json::JSON(true));
+    CHECK(doc.root().stringify() == R"([{"id":1},{"id":2},true])");
+
+    // Re-parsing releases the previous tree
+    pixellib::core::json::JsonError err;
+    CHECK_FALSE(doc.parse("[1,", &err));
+    CHECK(doc.parse("{\"k\":\"v\"}"));
+    CHECK(doc.root().find("k")->as_string() == "v");
+
+    pixellib::core::json::ParseOptions borrow;
+    borrow.borrow = true;
+    const std::string text = R"({"k":"borrowed"})";
+    REQUIRE(doc.parse(text, nullptr, borrow));
+    CHECK(doc.root().find("k")->is_borrowed());
+  }
+
+  TEST_CASE("KeyIndexLargeObject")
+  {
+    using pixellib::core::json::JSON;
+    constexpr int count = 5000;
+    JSON obj = JSON::object(JSON::object_t{});
+    for (int i = 0; i < count; ++i)
+    {
+      obj["key" + std::to_string(i)] = JSON::number(std::to_string(i));
+    }
+    CHECK(obj.has_key_index());
+    CHECK(obj.as_object().size() == static_cast<size_t>(count));
+
+    const JSON &view = obj;
+    CHECK(view.find("key0")->as_number().to_int64() == 0);
+    CHECK(view.find("key4999")->as_number().to_int64() == 4999);
+    CHECK(view.find("missing") == nullptr);
+
+    // Insertion order is preserved for stringify
+    const std::string text = obj.stringify();
+    CHECK(text.find("\"key0\":0") < text.find("\"key1\":1"));
+    CHECK(text.find("\"key1\":1") < text.find("\"key4999\":4999"));
+
+    // Mutable access drops the index and lookups scan until reindex()
+    obj.as_object().erase(obj.as_object().begin());
+    CHECK_FALSE(obj.has_key_index());
+    CHECK(view.find("key0") == nullptr);
+    CHECK(view.find("key1")->as_number().to_int64() == 1);
+    CHECK_FALSE(obj.has_key_index());
+    obj.reindex();
+    CHECK(view.find("key1")->as_number().to_int64() == 1);
+    CHECK(obj.has_key_index());
+
+    // Copies start unindexed but resolve the same keys
+    JSON copy = obj;
+    CHECK_FALSE(copy.has_key_index());
+    CHECK(copy.find("key2500")->as_number().to_int64() == 2500);
+  }
+
+  TEST_CASE("KeyIndexParsedDuplicatesAndStaleness")
+  {
+    using pixellib::core::json::JSON;
+    std::string text = "{";
+    for (size_t i = 0; i < JSON::index_threshold; ++i)
+    {
+      text += "\"k" + std::to_string(i) + "\":" + std::to_string(i) + ",";
+    }
+    text += "\"k0\":\"dup\"}";
+    JSON v;
+    REQUIRE(JSON::parse(text, v));
+    CHECK_FALSE(v.has_key_index());
+    // The first occurrence wins, as with a linear scan
+    CHECK(v.find("k0")->is_number());
+    CHECK(v.has_key_index());
+
+    // A reference kept across lookups may change keys in place or keep the
+    // same size and storage after erase + push_back; lookups stay correct
+    JSON::object_t &members = v.as_object();
+    CHECK(v.find("k1") != nullptr);
+    CHECK_FALSE(v.has_key_index());
+    members[1].first = "renamed";
+    CHECK(v.find("k1") == nullptr);
+    CHECK(v.find("renamed")->as_number().to_int64() == 1);
+    members.erase(members.begin() + 2);
+    members.emplace_back("late", JSON(true));
+    CHECK(v.find("k2") == nullptr);
+    CHECK(v.find("late") != nullptr);
+    members[0].first = "k3"; // an earlier duplicate now wins
+    CHECK(v.find("k3")->as_number().to_int64() == 0);
+    CHECK(v["late"].as_bool());
+    CHECK(v["fresh"].is_null());
+    CHECK(v.find("fresh") != nullptr);
+    CHECK_FALSE(v.has_key_index());
+
+    JSON moved = std::move(v);
+    CHECK_FALSE(moved.has_key_index());
+    moved.reindex();
+    CHECK(moved.find("k3")->as_number().to_int64() == 0);
+    CHECK(moved.find("k4")->as_number().to_int64() == 4);
+    CHECK(moved.has_key_index());
+  }
+
+  TEST_CASE("JsonNodeSize")
+  {
+    using pixellib::core::json::JSON;
+    // The key index lives with object nodes only, and the type comes from the variant
+    CHECK(sizeof(JSON) <= 48);
+    CHECK(JSON().type() == JSON::Type::Null);
+    CHECK(JSON::borrowed_string("x").type() == JSON::Type::String);
+    CHECK(JSON::object({}).type() == JSON::Type::Object);
+  }
+
+  namespace
+  {
+  // Records every event as a compact token so whole sequences can be compared
+  struct RecordingHandler : pixellib::core::json::JsonHandler
+  {
+    std::string events;
+    size_t abort_after = static_cast<size_t>(-1);
+    size_t count = 0;
+
+    bool add(const std::string &event)
+    {
+      events += event;
+      events += ' ';
+      return ++count < abort_after;
+    }
+
+    bool on_null() override
+    {
+      return add("null");
+    }
+    bool on_bool(bool value) override
+    {
+      return add(value ? "true" : "false");
+    }
+    bool on_number(std::string_view repr) override
+    {
+      return add("n:" + std::string(repr));
+    }
+    bool on_string(std::string_view value) override
+    {
+      return add("s:" + std::string(value));
+    }
+    bool on_key(std::string_view key) override
+    {
+      return add("k:" + std::string(key));
+    }
+    bool on_start_object() override
+    {
+      return add("{");
+    }
+    bool on_end_object() override
+    {
+      return add("}");
+    }
+    bool on_start_array() override
+    {
+      return add("[");
+    }
+    bool on_end_array() override
+    {
+      return add("]");
+    }
+    bool on_document_end() override
+    {
+      return add("|");
+    }
+  };
+  } // namespace
+
+  TEST_CASE("StreamingParserEvents")
+  {
+    using pixellib::core::json::StreamingParser;
+    const std::string text = R"({"a": [1, -2.5e3, true, false, null], "b\u00e9": "x\ny", "c": {}})";
+    RecordingHandler handler;
+    StreamingParser parser(&handler);
+    REQUIRE(parser.feed(text));
+    REQUIRE(parser.finish());
+    CHECK(handler.events == "{ k:a [ n:1 n:-2.5e3 true false null ] k:b\xc3\xa9 s:x\ny k:c { } } | ");
+    CHECK(parser.values() == 1);
+  }
+
+  TEST_CASE("StreamingParserChunkBoundaries")
+  {
+    using pixellib::core::json::StreamingParser;
+    const std::string text = R"([{"key": "va\"lue", "emoji": "\ud83d\ude00", "num": 12345.678e-9}, "tail", 0])";
+    RecordingHandler whole;
+    StreamingParser reference(&whole);
+    REQUIRE(reference.feed(text));
+    REQUIRE(reference.finish());
+
+    // Every split point, including inside escapes, surrogate pairs and numbers
+    for (size_t split = 0; split <= text.size(); ++split)
+    {
+      RecordingHandler handler;
+      StreamingParser parser(&handler);
+      REQUIRE(parser.feed(std::string_view(text).substr(0, split)));
+      REQUIRE(parser.feed(std::string_view(text).substr(split)));
+      REQUIRE(parser.finish());
+      CHECK(handler.events == whole.events);
+    }
+
+    RecordingHandler bytewise;
+    StreamingParser parser(&bytewise);
+    for (char c : text)
+    {
+      REQUIRE(parser.feed(std::string_view(&c, 1)));
+    }
+    REQUIRE(parser.finish());
+    CHECK(bytewise.events == whole.events);
+  }
+
+  TEST_CASE("StreamingParserMultipleValues")
+  {
+    using pixellib::core::json::StreamingParser;
+    RecordingHandler handler;
+    StreamingParser parser(&handler, true);
+    REQUIRE(parser.feed("{\"id\": 1}\n{\"id\""));
+    REQUIRE(parser.feed(": 2}\n42"));
+    REQUIRE(parser.feed("7\n"));
+    REQUIRE(parser.finish());
+    CHECK(parser.values() == 3);
+    CHECK(handler.events == "{ k:id n:1 } | { k:id n:2 } | n:427 | ");
+
+    StreamingParser single;
+    CHECK_FALSE(single.feed("1 2"));
+    CHECK(single.error().message == "Trailing characters after JSON value");
+    CHECK(single.error().position == 2);
+
+    parser.reset();
+    CHECK(parser.finish() == false);
+
+    // Top-level values must be separated by whitespace, even across chunks
+    for (const char *input : {"1{}", "truefalse", "\"a\"\"b\"", "{}[]", "null1"})
+    {
+      StreamingParser stream(nullptr, true);
+      CHECK_FALSE_MESSAGE(stream.feed(input), input);
+      CHECK(stream.error().message == "Expected whitespace between top-level values");
+    }
+    StreamingParser split(nullptr, true);
+    REQUIRE(split.feed("true"));
+    CHECK_FALSE(split.feed("false"));
+    CHECK(split.error().position == 4);
+    StreamingParser spaced(nullptr, true);
+    CHECK(spaced.feed("1 {}\ttrue\r\nfalse\n\"a\""));
+    CHECK(spaced.finish());
+    CHECK(spaced.values() == 5);
+  }
+
+  TEST_CASE("StreamingParserErrors")
+  {
+    using pixellib::core::json::StreamingParser;
+    auto error_of = [](std::string_view first, std::string_view second = {}) {
+      StreamingParser parser;
+      if (parser.feed(first) && parser.feed(second) && parser.finish())
+      {
+        return std::string();
+      }
+      return parser.error().message;
+    };
+
+    CHECK(error_of("[1, 2") == "Expected ',' between array elements");
+    CHECK(error_of("{\"a\" 1}") == "Expected ':' after object key");
+    CHECK(error_of("{\"a\": 1,", "}") == "Expected opening quote for string");
+    CHECK(error_of("\"abc") == "Unterminated string literal");
+    CHECK(error_of("\"abc\\") == "Unterminated escape sequence");
+    CHECK(error_of("\"\\u12") == "Incomplete unicode escape");
+    CHECK(error_of("\"\\ud83d\"") == "Missing low surrogate for unicode escape");
+    CHECK(error_of("\"\\ud83d\\u0041\"") == "Invalid low surrogate in unicode escape");
+    CHECK(error_of("\"\\q\"") == "Invalid escape sequence in string");
+    CHECK(error_of("tr", "ue") == "");
+    CHECK(error_of("tru") == "Invalid literal");
+    CHECK(error_of("nul", "x") == "Invalid literal");
+    CHECK(error_of("-") == "Invalid number format");
+    CHECK(error_of("1.") == "Invalid fraction in number");
+    CHECK(error_of("1e", "+") == "Invalid exponent in number");
+    CHECK(error_of("") == "Unexpected character while parsing value");
+    CHECK(error_of("[1,]") == "Unexpected character while parsing value");
+
+    StreamingParser parser;
+    REQUIRE(parser.feed("[1, 2"));
+    CHECK_FALSE(parser.feed(", }"));
+    CHECK(parser.error().position == 7);
+    CHECK(parser.failed());
+    CHECK_FALSE(parser.feed("]"));
+  }
+
+  TEST_CASE("StreamingParserHandlerAbort")
+  {
+    using pixellib::core::json::StreamingParser;
+    RecordingHandler handler;
+    handler.abort_after = 3;
+    StreamingParser parser(&handler);
+    CHECK_FALSE(parser.feed("[1, 2, 3, 4]"));
+    CHECK(parser.error().message == "Parsing cancelled by handler");
+    CHECK(handler.events == "[ n:1 n:2 ");
+  }
+
+  TEST_CASE("ValidateMatchesParse")
+  {
+    using pixellib::core::json::JSON;
+    const char *inputs[] = {"",          "null",        " [1, 2, {\"a\": []}] ", "{\"a\":}", "[1 2]",
+                            "01",        "-0.5e+10",    "\"\\u00\"",          "\"\\ud800\\udc00\"", "{\"a\":1,}",
+                            "\"a\tb\"", "[true,false]", "nan",                   "{} {}"};
+    for (const char *input : inputs)
+    {
+      JSON value;
+      CHECK_MESSAGE(JSON::validate(input) == JSON::parse(input, value), input);
+    }
+  }
+
+  TEST_CASE("StringScanBlockBoundaries")
+  {
+    using pixellib::core::json::JSON;
+    // Place each special character at every offset across several SIMD blocks
+    const std::string specials[] = {"\"", "\\", "\n", std::string(1, '\x01'), "/"};
+    for (const std::string &special : specials)
+    {
+      for (size_t offset = 0; offset < 70; ++offset)
+      {
+        std::string raw(offset, 'a');
+        raw += "\xc3\xa9"; // bytes >= 0x80 are not control characters
+        raw += special;
+        raw += std::string(offset % 19, 'z');
+
+        const std::string quoted = JSON(raw).stringify({false, 2, true});
+        JSON parsed;
+        REQUIRE(JSON::parse(quoted, parsed));
+        CHECK(parsed.as_string() == raw);
+        CHECK(quoted.substr(1, offset) == std::string(offset, 'a'));
+        CHECK(quoted.find('\\') == offset + 3);
+      }
+    }
+    CHECK(JSON(std::string("a/b")).stringify() == "\"a/b\"");
+    CHECK(JSON(std::string()).stringify({false, 2, true}) == "\"\"");
+  }
+
+  TEST_CASE("JsonWriterMatchesStringify")
+  {
+    using pixellib::core::json::JSON;
+    using pixellib::core::json::JsonWriter;
+    using pixellib::core::json::StringifyOptions;
+    const JSON dom = JSON::parse_or_throw(
+        R"({"name":"a/b \"q\"","n":-42,"pi":3.5,"ok":true,"none":null,"list":[1,[],{}],"nested":{"x":[{"y":"z"}]}})");
+
+    const StringifyOptions variants[] = {{false, 2, false}, {true, 2, false}, {true, 4, true}};
+    std::string out;
+    for (const StringifyOptions &options : variants)
+    {
+      out.clear();
+      JsonWriter writer(out, options);
+      writer.begin_object();
+      writer.key("name").value("a/b \"q\"");
+      writer.key("n").value(-42);
+      writer.key("pi").value(3.5);
+      writer.key("ok").value(true);
+      writer.key("none").value(nullptr);
+      writer.key("list").begin_array().value(1).begin_array().end_array().begin_object().end_object().end_array();
+      writer.key("nested").value(*dom.find("nested"));
+      writer.end_object();
+      CHECK(writer.complete());
+      CHECK(out == dom.stringify(options));
+    }
+  }
+
+  TEST_CASE("JsonWriterSinkFlushesIncrementally")
+  {
+    using pixellib::core::json::JsonWriter;
+    std::vector<std::string> chunks;
+    {
+      JsonWriter writer([&](std::string_view chunk) { chunks.emplace_back(chunk); }, {}, 256);
+      writer.begin_array();
+      for (int i = 0; i < 1000; ++i)
+      {
+        writer.value(i);
+      }
+      writer.end_array();
+      CHECK(chunks.size() > 10);
+    }
+    std::string joined;
+    for (const std::string &chunk : chunks)
+    {
+      CHECK(chunk.size() < 300);
+      joined += chunk;
+    }
+    pixellib::core::json::JSON parsed;
+    REQUIRE(pixellib::core::json::JSON::parse(joined, parsed));
+    CHECK(parsed.as_array().size() == 1000);
+    CHECK(parsed.as_array()[999].as_number().to_int64() == 999);
+  }
+
+  TEST_CASE("JsonWriterMisuseThrows")
+  {
+    using pixellib::core::json::JsonWriter;
+    std::string out;
+    JsonWriter object_writer(out);
+    object_writer.begin_object();
+    CHECK_THROWS_AS(object_writer.value(1), std::logic_error);
+    CHECK_THROWS_AS(object_writer.end_array(), std::logic_error);
+    object_writer.key("k");
+    CHECK_THROWS_AS(object_writer.key("again"), std::logic_error);
+    CHECK_THROWS_AS(object_writer.end_object(), std::logic_error);
+    object_writer.value("v").end_object();
+    CHECK(out == R"({"k":"v"})");
+    CHECK_THROWS_AS(object_writer.value(2), std::logic_error);
+
+    std::string array_out;
+    JsonWriter array_writer(array_out);
+    array_writer.begin_array();
+    CHECK_THROWS_AS(array_writer.key("k"), std::logic_error);
+    CHECK_FALSE(array_writer.complete());
+  }
+
+  TEST_CASE("NumberClassifiedAtParse")
+  {
+    using pixellib::core::json::JSON;
+    using Kind = JSON::Number::Kind;
+    JSON v;
+    REQUIRE(JSON::parse(R"([-7, 18446744073709551615, 123456789012345678901234, 2.5e-3, 1e400, -1e-400])", v));
+    const auto &items = v.as_array();
+    CHECK(items[0].as_number().kind == Kind::Int64);
+    CHECK(items[0].as_number().to_int64() == -7);
+    CHECK(items[0].as_number().to_uint64(9) == 9);
+
+    CHECK(items[1].as_number().kind == Kind::Uint64);
+    CHECK(items[1].as_number().to_uint64() == std::numeric_limits<uint64_t>::max());
+    CHECK(items[1].as_number().to_int64() == std::numeric_limits<int64_t>::max());
+    CHECK(items[1].as_number().is_integral());
+
+    CHECK(items[2].as_number().kind == Kind::BigInteger);
+    CHECK(items[2].as_number().is_integral());
+    CHECK(items[2].as_number().to_double() == doctest::Approx(1.2345678901234568e23));
+
+    CHECK(items[3].as_number().kind == Kind::Double);
+    CHECK(items[3].as_number().to_double() == 2.5e-3);
+    CHECK(items[3].as_number().to_int64(5) == 5);
+    CHECK(items[4].as_number().to_double() == std::numeric_limits<double>::infinity());
+    CHECK(items[5].as_number().to_double(1.0) == 0.0);
+
+    // Original text is kept for round trips
+    CHECK(v.stringify() == R"([-7,18446744073709551615,123456789012345678901234,2.5e-3,1e400,-1e-400])");
+
+    // Numbers built from text alone are still converted on demand
+    const JSON::Number manual{"64"};
+    CHECK(manual.kind == Kind::Unclassified);
+    CHECK(manual.resolved_kind() == Kind::Int64);
+    CHECK(manual.to_int64() == 64);
+    CHECK(JSON::number("+1").as_number().kind == Kind::Invalid);
+  }
+
+  TEST_CASE("NumberTextStorage")
+  {
+    using pixellib::core::json::JSON;
+    // Inline, heap-owned and borrowed text all fit the same 32 bytes
+    CHECK(sizeof(JSON::Number) <= 32);
+
+    const std::string long_text = "123456789012345678901234567890.5e-3";
+    JSON::Number heap = JSON::Number::from_text(long_text);
+    JSON::Number copy = heap;
+    JSON::Number moved = std::move(heap);
+    CHECK(copy.text() == long_text);
+    CHECK(moved.text() == long_text);
+    CHECK(copy.text().data() != moved.text().data());
+    copy = JSON::Number::from_int64(7);
+    CHECK(copy.text() == "7");
+    CHECK(copy.to_int64() == 7);
+
+    std::string buffer = long_text;
+    JSON::Number view = JSON::Number::from_text(buffer, true);
+    CHECK(view.is_borrowed());
+    CHECK(view.text().data() == buffer.data());
+    view.materialize();
+    CHECK_FALSE(view.is_borrowed());
+    buffer.assign(buffer.size(), 'x');
+    CHECK(view.text() == long_text);
+    CHECK(view.to_double() == doctest::Approx(1.2345678901234568e26));
+  }
+
+  TEST_CASE("NumberFromDoubleRoundTrips")
+  {
+    using pixellib::core::json::JSON;
+    const double values[] = {0.1 + 0.2, 1.0 / 3.0, -2.2250738585072014e-308, 1e21, 42.0, 5e-324};
+    for (double value : values)
+    {
+      const JSON number(value);
+      JSON parsed;
+      REQUIRE(JSON::parse(number.stringify(), parsed));
+      CHECK(parsed.as_number().to_double() == value);
+    }
+    CHECK(JSON(42.0).stringify() == "42");
+    CHECK(JSON(42.0).as_number().is_integral());
+    CHECK(JSON(0.5).stringify() == "0.5");
+  }
+
+  TEST_CASE("JsonQueryPointers")
+  {
+    using pixellib::core::json::JSON;
+    using pixellib::core::json::JsonQuery;
+    const std::string text = R"({
+      "user": {"id": 7, "name": "Ada", "tags": ["a", "b"]},
+      "events": [{"ts": 1, "kind": "x"}, {"ts": 2}, {"kind": "y"}, {"ts": 3}],
+      "a/b": {"m~n": true},
+      "k\u0065y": "escaped key"
+    })";
+
+    JsonQuery query{"/user/id", "/events/*/ts", "/a~1b/m~0n", "/key", "/user/tags/1", "/missing", "/user"};
+    std::vector<std::vector<JSON>> matches;
+    REQUIRE(query.run(text, matches));
+    REQUIRE(matches.size() == query.size());
+    CHECK(matches[0].size() == 1);
+    CHECK(matches[0][0].as_number().to_int64() == 7);
+    REQUIRE(matches[1].size() == 3);
+    CHECK(matches[1][0].as_number().to_int64() == 1);
+    CHECK(matches[1][2].as_number().to_int64() == 3);
+    CHECK(matches[2][0].as_bool());
+    CHECK(matches[3][0].as_string() == "escaped key");
+    CHECK(matches[4][0].as_string() == "b");
+    CHECK(matches[5].empty());
+    CHECK(matches[6][0].find("name")->as_string() == "Ada");
+
+    JsonQuery whole;
+    REQUIRE(whole.add(""));
+    REQUIRE(whole.run("[1, 2]", matches));
+    CHECK(matches[0][0].as_array().size() == 2);
+  }
+
+  TEST_CASE("JsonQueryFirstMatchAndEarlyStop")
+  {
+    using pixellib::core::json::JSON;
+    using pixellib::core::json::JsonQuery;
+    JsonQuery query{"/id", "/id"};
+    std::vector<std::vector<JSON>> matches;
+    // Scanning stops once every pointer is satisfied, so the broken tail is never read
+    REQUIRE(query.run(R"({"id": 1, "id": 2, "rest": [})", matches));
+    CHECK(matches[0].size() == 1);
+    CHECK(matches[0][0].as_number().to_int64() == 1);
+    CHECK(matches[1][0].as_number().to_int64() == 1);
+
+    // Wildcards scan the whole document and still validate skipped subtrees
+    JsonQuery all{"/*/id"};
+    pixellib::core::json::JsonError err;
+    CHECK_FALSE(all.run(R"([{"id": 1, "skip": {"x": [1, "\q"]}}])", matches, &err));
+    CHECK(err.message == "Invalid escape sequence in string");
+    CHECK_FALSE(all.run(R"([{"id": 1}] x)", matches, &err));
+    CHECK(err.message == "Trailing characters after JSON value");
+    CHECK_FALSE(all.run(R"([{"id": 1}, {"id": [2]}, 3, {"skip": tru}])", matches));
+  }
+
+  TEST_CASE("JsonQueryInvalidPointer")
+  {
+    using pixellib::core::json::JsonQuery;
+    JsonQuery query;
+    pixellib::core::json::JsonError err;
+    CHECK_FALSE(query.add("user", &err));
+    CHECK(err.message == "JSON pointer must be empty or start with '/'");
+    CHECK_FALSE(query.add("/a~2", &err));
+    CHECK(err.position == 2);
+    CHECK(query.size() == 0);
+    CHECK_THROWS_AS(JsonQuery({"/ok", "bad"}), std::invalid_argument);
+  }
+
+  TEST_CASE("NdjsonParallelKeepsOrder")
+  {
+    using pixellib::core::json::JSON;
+    using pixellib::core::json::NdjsonError;
+    using pixellib::core::json::NdjsonParser;
+    std::string text;
+    for (int i = 0; i < 5000; ++i)
+    {
+      text += R"({"seq":)" + std::to_string(i) + R"(,"msg":"line"})" + (i % 7 == 0 ? "\r\n\n" : "\n");
+    }
+    text += R"({"seq":5000})"; // no trailing newline
+
+    // Small batches force many rounds and slice boundaries
+    NdjsonParser parser({4, 997, {}});
+    std::vector<JSON> records;
+    std::vector<NdjsonError> errors;
+    REQUIRE(parser.parse(text, records, &errors));
+    CHECK(errors.empty());
+    REQUIRE(records.size() == 5001);
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+      REQUIRE(records[i].find("seq")->as_number().to_int64() == static_cast<int64_t>(i));
+    }
+  }
+
+  TEST_CASE("NdjsonReportsLineErrors")
+  {
+    using pixellib::core::json::JSON;
+    using pixellib::core::json::NdjsonError;
+    using pixellib::core::json::NdjsonParser;
+    const std::string text = "1\n[2,\n\n  {\"a\" 1}\n4\n";
+    NdjsonParser parser({3, 2, {}});
+    std::vector<size_t> lines;
+    std::vector<NdjsonError> errors;
+    CHECK_FALSE(parser.parse(
+        text,
+        [&](size_t line, JSON &&value) {
+          lines.push_back(line);
+          return value.is_number();
+        },
+        &errors));
+    CHECK(lines == std::vector<size_t>{1, 5});
+    REQUIRE(errors.size() == 2);
+    CHECK(errors[0].line == 2);
+    CHECK(errors[0].offset == 2);
+    CHECK(errors[1].line == 4);
+    CHECK(errors[1].offset == 7);
+    CHECK(errors[1].error.position == 7);
+    CHECK(errors[1].error.message == "Expected ':' after object key");
+
+    // A callback returning false stops delivery
+    size_t delivered = 0;
+    CHECK_FALSE(parser.parse("1\n2\n3\n", [&](size_t, JSON &&) { return ++delivered < 2; }));
+    CHECK(delivered == 2);
+  }
+
+  TEST_CASE("NdjsonParseFile")
+  {
+    using pixellib::core::json::JSON;
+    using pixellib::core::json::NdjsonError;
+    using pixellib::core::json::NdjsonParser;
+    const std::string path = (std::filesystem::temp_directory_path() / "pixellib_ndjson_test.ndjson").string();
+    {
+      std::ofstream out(path, std::ios::binary);
+      for (int i = 0; i < 3000; ++i)
+      {
+        out << R"({"id":)" << i << R"(,"name":"record )" << i << "\"}\n";
+      }
+      out << "oops\n";
+    }
+
+    NdjsonParser parser({2, 1024, pixellib::core::json::ParseOptions{true}});
+    std::vector<int64_t> ids;
+    std::vector<NdjsonError> errors;
+    CHECK_FALSE(parser.parse_file(
+        path,
+        [&](size_t line, JSON &&value) {
+          CHECK(line == ids.size() + 1);
+          CHECK_FALSE(value.find("name")->is_borrowed());
+          ids.push_back(value.find("id")->as_number().to_int64());
+          return true;
+        },
+        &errors));
+    CHECK(ids.size() == 3000);
+    CHECK(ids.back() == 2999);
+    REQUIRE(errors.size() == 1);
+    CHECK(errors[0].line == 3001);
+    std::filesystem::remove(path);
+
+    errors.clear();
+    CHECK_FALSE(parser.parse_file(path + ".missing", [](size_t, JSON &&) { return true; }, &errors));
+    REQUIRE(errors.size() == 1);
+    CHECK(errors[0].error.message.find("Unable to open file") == 0);
+  }
+
+  namespace
+  {
+  std::string hex_bytes(std::string_view bytes)
+  {
+    static const char digits[] = "0123456789abcdef";
+    std::string out;
+    for (unsigned char c : bytes)
+    {
+      out.push_back(digits[c >> 4]);
+      out.push_back(digits[c & 0xF]);
+    }
+    return out;
+  }
+
+  std::string from_hex(std::string_view hex)
+  {
+    std::string out;
+    for (size_t i = 0; i + 1 < hex.size(); i += 2)
+    {
+      out.push_back(static_cast<char>(std::stoi(std::string(hex.substr(i, 2)), nullptr, 16)));
+    }
+    return out;
+  }
+  } // namespace
+
+  TEST_CASE("CborEncodeKnownValues")
+  {
+    using pixellib::core::json::JSON;
+    // Examples from RFC 8949 Appendix A
+    auto encode = [](const char *text) { return hex_bytes(JSON::parse_or_throw(text).to_cbor()); };
+    CHECK(encode("0") == "00");
+    CHECK(encode("23") == "17");
+    CHECK(encode("24") == "1818");
+    CHECK(encode("1000") == "1903e8");
+    CHECK(encode("-1") == "20");
+    CHECK(encode("-1000") == "3903e7");
+    CHECK(encode("18446744073709551615") == "1bffffffffffffffff");
+    CHECK(encode("18446744073709551616") == "c249010000000000000000");
+    CHECK(encode("-18446744073709551616") == "3bffffffffffffffff");
+    CHECK(encode("-18446744073709551617") == "c349010000000000000000");
+    CHECK(encode("1.5") == "fa3fc00000");
+    CHECK(encode("1.1") == "fb3ff199999999999a");
+    CHECK(encode("\"a\"") == "6161");
+    CHECK(encode("[1, [2, 3], [4, 5]]") == "8301820203820405");
+    CHECK(encode(R"({"b": 1, "a": [2, 3]})") == "a26162016161820203");
+    CHECK(encode("[null, true, false]") == "83f6f5f4");
+    // More significant digits than a double holds: exact tag 4 decimal fraction
+    CHECK(encode("273.15000000000000000001") == "c48233c24a05c8bfc622ed72ec0001");
+  }
+
+  TEST_CASE("CborRoundTrip")
+  {
+    using pixellib::core::json::JSON;
+    const JSON original = JSON::parse_or_throw(R"({
+      "z": 1, "a": -9223372036854775808, "big": 123456789012345678901234567890,
+      "neg": -98765432109876543210987654321, "pi": 3.141592653589793, "precise": 0.12345678901234567890123,
+      "huge": 1e400, "tiny": -2.5e-400, "s": "café \"quoted\"", "list": [[], {}, null, true, 0.5],
+      "nested": {"k": [1, 2, {"deep": "x"}]}
+    })");
+    const std::string encoded = original.to_cbor();
+    CHECK(encoded.size() < original.stringify().size());
+
+    JSON decoded;
+    REQUIRE(JSON::from_cbor(encoded, decoded));
+    const auto &members = decoded.as_object();
+    CHECK(members.front().first == "z"); // key order follows object_t
+    CHECK(members[1].second.as_number().to_int64() == std::numeric_limits<int64_t>::min());
+    CHECK(decoded.find("big")->as_number().text() == "123456789012345678901234567890");
+    CHECK(decoded.find("neg")->as_number().text() == "-98765432109876543210987654321");
+    CHECK(decoded.find("pi")->as_number().to_double() == 3.141592653589793);
+    CHECK(decoded.find("precise")->as_number().text() == "12345678901234567890123e-23");
+    CHECK(decoded.find("huge")->as_number().text() == "1e400");
+    CHECK(decoded.find("tiny")->as_number().text() == "-25e-401");
+    CHECK(decoded.find("s")->as_string() == "caf\xc3\xa9 \"quoted\"");
+    CHECK(decoded.find("nested")->stringify() == original.find("nested")->stringify());
+    CHECK(decoded.find("list")->stringify() == "[[],{},null,true,0.5]");
+
+    // Appends to a caller buffer, and borrowed decoding references it
+    std::string buffer = "prefix";
+    original.append_cbor(buffer);
+    CHECK(buffer.substr(6) == encoded);
+    JSON borrowed;
+    REQUIRE(JSON::from_cbor(encoded, borrowed, pixellib::core::json::ParseOptions{true}));
+    CHECK(borrowed.find("s")->is_borrowed());
+  }
+
+  TEST_CASE("CborDecodeForms")
+  {
+    using pixellib::core::json::JSON;
+    auto decode = [](const char *hex) {
+      JSON value;
+      REQUIRE(JSON::from_cbor(from_hex(hex), value));
+      return value.stringify();
+    };
+    CHECK(decode("f93c00") == "1");
+    CHECK(decode("f97bff") == "65504");
+    CHECK(decode("f90001") == "5.960464477539063e-08");
+    CHECK(decode("fa47c35000") == "1e+05");
+    CHECK(decode("f97c00") == "null");
+    CHECK(decode("f7") == "null");
+    CHECK(decode("7f657374726561646d696e67ff") == "\"streaming\"");
+    CHECK(decode("9fff") == "[]");
+    CHECK(decode("bf61610161629f0203ffff") == R"({"a":1,"b":[2,3]})");
+    CHECK(decode("c074323031332d30332d32315432303a30343a30305a") == "\"2013-03-21T20:04:00Z\"");
+    CHECK(decode("c48221196ab3") == "27315e-2");
+
+    auto error_of = [](const char *hex) {
+      JSON value;
+      pixellib::core::json::JsonError err;
+      CHECK_FALSE(JSON::from_cbor(from_hex(hex), value, &err));
+      return err.message;
+    };
+    CHECK(error_of("") == "Unexpected end of CBOR data");
+    CHECK(error_of("830102") == "Unexpected end of CBOR data");
+    CHECK(error_of("a10102") == "CBOR map keys must be text strings");
+    CHECK(error_of("4161") == "Unsupported CBOR byte string");
+    CHECK(error_of("0000") == "Trailing bytes after CBOR value");
+    CHECK(error_of("ff") == "Unexpected CBOR break");
+    CHECK(error_of("1f") == "Invalid CBOR additional information");
+    CHECK(error_of("7f6161016161ff") == "Invalid chunk in indefinite-length CBOR string");
+    CHECK(error_of("9bffffffffffffffff") == "Unexpected end of CBOR data");
+  }
+
+  TEST_CASE("CborRejectsHostileNesting")
+  {
+    using pixellib::core::json::JSON;
+    auto decodes = [](const std::string &bytes) {
+      JSON value;
+      return JSON::from_cbor(bytes, value);
+    };
+    auto repeat = [](std::string_view hex, size_t count, std::string_view tail_hex = {}) {
+      std::string bytes;
+      const std::string unit = from_hex(hex);
+      for (size_t i = 0; i < count; ++i)
+        bytes += unit;
+      return bytes + from_hex(tail_hex);
+    };
+    // Huge declared lengths at every level must not pre-allocate per level
+    CHECK_FALSE(decodes(repeat("9affffffff", 18000)));
+    CHECK_FALSE(decodes(repeat("baffffffff6161", 13000)));
+    CHECK_FALSE(decodes(repeat("9affffffff", 100)));
+    // Deep nesting and tag chains fail instead of exhausting the stack
+    CHECK_FALSE(decodes(repeat("81", 100000, "00")));
+    CHECK_FALSE(decodes(repeat("c6", 100000, "00")));
+    pixellib::core::json::JsonError err;
+    JSON value;
+    CHECK_FALSE(JSON::from_cbor(repeat("d820", 1000, "00"), value, &err));
+    CHECK(err.message == "CBOR nesting too deep");
+    CHECK(err.position == 1024);
+
+    // Nesting within the limit still decodes
+    REQUIRE(JSON::from_cbor(repeat("81", 500, "00"), value));
+    CHECK(value.stringify() == std::string(500, '[') + "0" + std::string(500, ']'));
+    REQUIRE(JSON::from_cbor(repeat("c6", 500, "01"), value));
+    CHECK(value.stringify() == "1");
+  }
+}